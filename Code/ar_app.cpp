@@ -25,25 +25,100 @@ ARApp::ARApp(gef::Platform& platform) :
 	renderer_3d_(NULL),
 	camera_sprite_(NULL),
 	ui_manager_(NULL),
-	level_(NULL)
+	level_(NULL),
+	profiler_(NULL),
+	telemetry_(NULL),
+	governor_(NULL),
+	asset_bundle_(NULL),
+	camera_calibration_(NULL),
+	level_streamer_(NULL),
+	stress_benchmark_(NULL)
 {
 }
 
 void ARApp::Init()
 {
 
+	// Time each phase of starting up, so we can see where the time to the first frame goes
+	profiler_ = new Profiler();
+	gef::UInt64 phase_start = Profiler::GetTime();
+
 	// Init objects
 	input_manager_ = gef::InputManager::Create(platform_);
 	sprite_renderer_ = gef::SpriteRenderer::Create(platform_);
 	renderer_3d_ = gef::Renderer3D::Create(platform_);
 	ui_manager_ = new UIManager();
 	level_ = new Level();
+	telemetry_ = new Telemetry();
+	governor_ = new FrameGovernor();
+	asset_bundle_ = new AssetBundle();
+	level_streamer_ = new LevelStreamer();
+	stress_benchmark_ = new StressBenchmark();
+
+	// Assets are loaded from their own files if there's no bundle
+	asset_bundle_->Load(ASSET_BUNDLE_FILE);
+	level_->SetAssetBundle(asset_bundle_);
+
+	// The campaign is the two built-in levels unless there's a level pack
+	level_streamer_->LoadPack(LEVEL_PACK_FILE);
+	level_->SetLevelStreamer(level_streamer_);
+
+	// Start from the pinhole camera the tracking library assumes, and use the calibration if there is one,
+	// fitting it from the recorded samples the first time they're found
+	camera_calibration_ = new CameraCalibration();
+	camera_calibration_->SetDefault(SCE_SMART_IMAGE_FOV, SCE_SMART_IMAGE_WIDTH, SCE_SMART_IMAGE_HEIGHT);
+	if (!camera_calibration_->Load(CAMERA_CALIBRATION_FILE))
+	{
+
+		std::vector<CalibrationSample> samples;
+		float rms_error;
+		if (CameraCalibration::ReadSamples(CAMERA_CALIBRATION_SAMPLES_FILE, samples) && camera_calibration_->Fit(samples, rms_error))
+		{
+
+			camera_calibration_->Save(CAMERA_CALIBRATION_FILE);
+
+		}
+
+	}
+
+	camera_calibration_->BuildUndistortionMap();
+	level_->SetCameraCalibration(camera_calibration_);
+
+	// The game runs without telemetry if the writer can't be started
+	telemetry_->Start();
 
 	SetupLights();
 
-	// Initialise sony framework
+	// Initialise the sample framework, which sets up the camera
 	sampleInitialize();
-	smartInitialize();
+
+	tolerance_value_ = 0.05f;
+	tracking_interval_ = TRACKING_INTERVAL;
+	difficulty = DIFFICULTY_EASY;
+	level_id_ = level_streamer_->GetFirstLevel();
+
+#ifdef BAKE_ASSETS
+	// Development builds that bake the assets do it before anything's loaded, then carry on with the files they had
+	AssetBaker::BakeAll(&platform_, level_streamer_, tolerance_value_);
+#endif
+
+	profiler_->SetValue(PROFILER_VALUE_STARTUP_SETUP, (Profiler::GetTime() - phase_start) / 1000.0f);
+	phase_start = Profiler::GetTime();
+
+	// Initialising the tracking library, decoding the UI textures and reading the first level's scenes don't depend
+	// on each other or need the GPU, so run them together
+	TaskPool task_pool;
+	task_pool.AddTask(InitTrackingTask, this);
+	task_pool.AddTask(DecodeUITask, this);
+	task_pool.AddTask(PreloadLevelTask, this);
+	task_pool.Run();
+
+	// Start reading the next levels' scenes in the background, which the game runs without if it can't
+	level_streamer_->Start(&platform_, asset_bundle_, tolerance_value_);
+	level_streamer_->SetCurrentLevel(level_id_);
+
+	profiler_->SetValue(PROFILER_VALUE_STARTUP_LOADING, (Profiler::GetTime() - phase_start) / 1000.0f);
+	phase_start = Profiler::GetTime();
 
 	// Reset marker tracking
 	AppData* dat = sampleUpdateBegin();
@@ -58,13 +133,14 @@ void ARApp::Init()
 	float screen_aspect_ratio = (float)platform_.width() / (float)platform_.height();
 	camera_image_scale_factor_ = screen_aspect_ratio / camera_aspect_ratio_;
 
-	// Initialise the UI
-	ui_manager_->Init(&platform_, camera_image_scale_factor_);
+	// Initialise the UI, creating the textures from the decoded images
+	ui_manager_->Init(&platform_, camera_image_scale_factor_, asset_bundle_);
 
 	// Setup the orthographic frustum for the camera
 	orthographic_frustum_camera.OrthographicFrustumGL(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
 
 	// Setup the projection matrix for rendering geometry to the camera's perspective
+	// This is the tracking library's pinhole camera, which its uncorrected poses line up with on the distorted camera image
 	gef::Matrix44 fov_projection_matrix;
 	gef::Matrix44 scale_matrix;
 	fov_projection_matrix.PerspectiveFovGL(SCE_SMART_IMAGE_FOV, camera_aspect_ratio_, 0.01f, 10.0f);
@@ -77,6 +153,7 @@ void ARApp::Init()
 	// Initially the markers have not been found
 	marker_01_found_ = false;
 	marker_02_found_ = false;
+	markers_found_ = false;
 
 	// The player has not won yet, so set win values to false and set instructions to true on startup
 	correct_transforms_ = false;
@@ -84,12 +161,59 @@ void ARApp::Init()
 	has_won_ = false;
 	ui_manager_->DisplayTransforms(false);
 
-	tolerance_value_ = 0.05f;
-	difficulty = DIFFICULTY_EASY;
-	level_id_ = 1;
+	simulation_accumulator_ = 0.0f;
 
-	// Initialise the first level
-	level_->InitLevel(level_id_, tolerance_value_, &platform_);
+	// No commands have been issued yet
+	frame_count_ = 0;
+	reset_pending_ = false;
+	switch_level_pending_ = false;
+	stress_benchmark_pending_ = false;
+	deferred_input_timestamp_ = 0;
+	pending_input_timestamp_ = 0;
+
+	// Initialise the first level, creating its meshes from the scenes that were read
+	InitCurrentLevel();
+	level_start_time_ = Profiler::GetTime();
+
+	profiler_->SetValue(PROFILER_VALUE_STARTUP_UPLOAD, (Profiler::GetTime() - phase_start) / 1000.0f);
+
+	telemetry_->Emit(TELEMETRY_EVENT_SESSION_START, frame_count_, level_id_, 0);
+
+}
+
+void ARApp::InitTrackingTask(void* argument)
+{
+
+	ARApp* app = (ARApp*)argument;
+	gef::UInt64 start = Profiler::GetTime();
+
+	smartInitialize();
+
+	app->profiler_->SetValue(PROFILER_VALUE_STARTUP_TRACKING, (Profiler::GetTime() - start) / 1000.0f);
+
+}
+
+void ARApp::DecodeUITask(void* argument)
+{
+
+	ARApp* app = (ARApp*)argument;
+	gef::UInt64 start = Profiler::GetTime();
+
+	app->ui_manager_->DecodeTextures(&app->platform_, app->asset_bundle_);
+
+	app->profiler_->SetValue(PROFILER_VALUE_STARTUP_UI_DECODE, (Profiler::GetTime() - start) / 1000.0f);
+
+}
+
+void ARApp::PreloadLevelTask(void* argument)
+{
+
+	ARApp* app = (ARApp*)argument;
+	gef::UInt64 start = Profiler::GetTime();
+
+	app->level_->PreloadScenes(app->level_id_, app->tolerance_value_, &app->platform_);
+
+	app->profiler_->SetValue(PROFILER_VALUE_STARTUP_LEVEL_READ, (Profiler::GetTime() - start) / 1000.0f);
 
 }
 
@@ -119,13 +243,82 @@ void ARApp::CleanUp()
 	delete level_;
 	level_ = NULL;
 
+	// The level hands its scenes back to the streamer, so it goes after the level
+	delete level_streamer_;
+	level_streamer_ = NULL;
+
+	// The level's meshes use the bundle's materials, so it goes after the level
+	delete asset_bundle_;
+	asset_bundle_ = NULL;
+
+	delete camera_calibration_;
+	camera_calibration_ = NULL;
+
+	delete stress_benchmark_;
+	stress_benchmark_ = NULL;
+
+	delete profiler_;
+	profiler_ = NULL;
+
+	delete governor_;
+	governor_ = NULL;
+
+	// Stopping the telemetry writes out everything that's still in the ring
+	telemetry_->Stop();
+	delete telemetry_;
+	telemetry_ = NULL;
+
 }
 
 bool ARApp::Update(float frame_time)
 {
 	fps_ = 1.0f / frame_time;
 
+	// Adjust the quality of the frame to fit the budget, based on how long last frame's stages took
+	// The benchmark measures the full quality frame, so the governor is left alone while it runs
+	if (!stress_benchmark_->IsRunning())
+	{
+
+		governor_->Update(profiler_);
+		ApplyGovernor();
+
+	}
+
+	// Clear last frame's statistics
+	profiler_->BeginFrame();
+
+	// Read the controller, then act on everything that's been queued
 	HandleInput();
+	ProcessCommands();
+
+#ifdef HOT_RELOAD_LEVELS
+	// Every so often, pick up any edits to the level file
+	if (frame_count_ % HOT_RELOAD_INTERVAL == 0 && !stress_benchmark_->IsRunning())
+	{
+
+		level_->HotReload(&platform_);
+
+	}
+#endif
+
+	// While looking back through the pose history, draw the frame being looked at instead of tracking and simulating
+	if (level_->IsRewinding())
+	{
+
+		// Keep the camera image coming, so the past poses are drawn over the live feed
+		AppData* dat = sampleUpdateBegin();
+		sampleUpdateEnd(dat);
+
+		level_->ShowRewindFrame();
+		marker_02_found_ = level_->GetRewindFrame().is_active[0];
+		marker_01_found_ = level_->GetRewindFrame().is_active[1];
+		correct_transforms_ = false;
+
+		return true;
+
+	}
+
+	profiler_->BeginTimer(PROFILER_TIMER_TRACKING);
 
 	// Set the game objects to be inactive by default
 	level_->ReadyForUpdate();
@@ -134,29 +327,94 @@ bool ARApp::Update(float frame_time)
 	AppData* dat = sampleUpdateBegin();
 
 	// Use the tracking library to try and find markers
-	smartUpdate(dat->currentImage);
+	// While the markers are holding still they're only tracked every few frames, and extrapolated in between
+	// When the governor has lowered the tracking rate, they're tracked less often still
+	int tracking_interval = tracking_interval_ * (governor_->IsEngaged(GOVERNOR_KNOB_TRACKING_RATE) ? GOVERNOR_TRACKING_INTERVAL : 1);
+	bool is_tracked = tracking_interval <= 1 || frame_count_ % tracking_interval == 0 || level_->NeedsTracking();
+	if (is_tracked && !stress_benchmark_->IsRunning())
+	{
+
+		smartUpdate(dat->currentImage);
+
+	}
 
 	// Reset markers to not be found each frame
 	marker_01_found_ = false;
 	marker_02_found_ = false;
 
-	// Sample the camera image for markers
-	level_->SampleMarkers(marker_02_found_, marker_01_found_);
+	if (stress_benchmark_->IsRunning())
+	{
+
+		// The benchmark replays its generated trace instead, so every run sees the same poses
+		level_->ReplayMarkers(stress_benchmark_->GetMarkerTransforms(), stress_benchmark_->GetNumMarkers());
+		marker_02_found_ = level_->GetGameObject(0)->is_active();
+		marker_01_found_ = level_->GetGameObject(1)->is_active();
+
+	}
+	else
+	{
+
+		// Sample the camera image for markers, only fusing the poses into the filters when they've been tracked again
+		level_->SampleMarkers(marker_02_found_, marker_01_found_, is_tracked);
+
+	}
 
 	// Stop sampling camera image data
 	sampleUpdateEnd(dat);
 
+	profiler_->EndTimer(PROFILER_TIMER_TRACKING);
+
+	// Record the markers coming into and going out of view
+	bool markers_found = marker_01_found_ && marker_02_found_;
+	if (markers_found != markers_found_)
+	{
+
+		telemetry_->Emit(markers_found ? TELEMETRY_EVENT_MARKERS_FOUND : TELEMETRY_EVENT_MARKERS_LOST, frame_count_, level_id_,
+			(marker_01_found_ ? 1 : 0) | (marker_02_found_ ? 2 : 0));
+		markers_found_ = markers_found;
+
+	}
+
+	profiler_->BeginTimer(PROFILER_TIMER_SIMULATION);
+
+	// Advance the simulation in fixed timesteps so object motion doesn't depend on frame rate
+	simulation_accumulator_ += frame_time;
+	int num_steps = 0;
+	while (simulation_accumulator_ >= SIMULATION_TIMESTEP && num_steps < MAX_SIMULATION_STEPS)
+	{
+
+		simulation_accumulator_ -= SIMULATION_TIMESTEP;
+		num_steps++;
+
+	}
+
+	// If we've fallen too far behind, drop the remainder rather than trying to catch up
+	if (num_steps == MAX_SIMULATION_STEPS)
+	{
+
+		simulation_accumulator_ = 0.0f;
+
+	}
+
+	level_->StepSimulation(num_steps);
+
 	// Detect if the transforms are close enough to the correct values
-	correct_transforms_ = level_->GetUpdate();
+	// The transforms are interpolated between the last two simulation steps for rendering
+	correct_transforms_ = level_->GetUpdate(simulation_accumulator_ / SIMULATION_TIMESTEP);
+
+	profiler_->EndTimer(PROFILER_TIMER_SIMULATION);
+
+	// Keep the frame in the pose history, in case what led up to it needs looking back over
+	level_->RecordHistory(frame_count_, correct_transforms_);
 
-	// If the current difficulty is easy, automatically detect if the player has won
-	if (difficulty == DIFFICULTY_EASY)
+	// If the current difficulty is easy, automatically detect if the player has won, which the benchmark's levels can't
+	if (difficulty == DIFFICULTY_EASY && !stress_benchmark_->IsRunning())
 	{
 
 		if (correct_transforms_)
 		{
 
-			has_won_ = true;
+			Win();
 
 		}
 
@@ -169,6 +427,8 @@ void ARApp::Render()
 {
 	AppData* dat = sampleRenderBegin();
 
+	profiler_->BeginTimer(PROFILER_TIMER_RENDER);
+
 	// Set the sprite to cover the end of the frustum in normalised device space
 	camera_sprite_->set_width(2.0f);
 	camera_sprite_->set_height(2.0f*camera_image_scale_factor_);
@@ -196,18 +456,23 @@ void ARApp::Render()
 
 	// Begin 3D rendering
 
-	// Set the projection and view matrix
+	// Set the projection and view matrix, the view being the anchor marker's transform when the level is anchored to it
+	const gef::Matrix44& view_matrix = level_->GetViewTransform();
 	renderer_3d_->set_projection_matrix(perspective_projection_);
-	renderer_3d_->set_view_matrix(identity_matrix_);
+	renderer_3d_->set_view_matrix(view_matrix);
 
 	// Begin rendering 3D meshes, don't clear the frame buffer
 	renderer_3d_->Begin(false);
 
-	level_->Render(renderer_3d_);
+	// Draw the level, culling objects that are outside the camera's view
+	level_->Render(renderer_3d_, view_matrix, perspective_projection_, profiler_);
 
 	// End 3D rendering
 	renderer_3d_->End();
 
+	profiler_->EndTimer(PROFILER_TIMER_RENDER);
+	profiler_->BeginTimer(PROFILER_TIMER_UI);
+
 	// Set the projection matrix again
 	sprite_renderer_->set_projection_matrix(orthographic_frustum_camera);
 
@@ -228,14 +493,29 @@ void ARApp::Render()
 	sprite_renderer_->Begin(false);
 
 	// Draw the text
-	ui_manager_->DrawFont(&platform_, sprite_renderer_, level_, fps_, marker_01_found_, marker_02_found_, difficulty);
+	ui_manager_->DrawFont(&platform_, sprite_renderer_, level_, profiler_, fps_, marker_01_found_, marker_02_found_, difficulty);
 
 	sprite_renderer_->End();
 
+	profiler_->EndTimer(PROFILER_TIMER_UI);
+
 	// End rendering
 
 	sampleRenderEnd();
 
+	// The process time starts with the process, so the first frame's presentation time is the time to first frame
+	if (frame_count_ == 0)
+	{
+
+		profiler_->SetValue(PROFILER_VALUE_TIME_TO_FIRST_FRAME, Profiler::GetTime() / 1000.0f);
+
+	}
+
+	// Run any commands that were deferred until the frame was finished
+	RunDeferredCommands();
+
+	frame_count_++;
+
 }
 
 void ARApp::SetupLights()
@@ -249,30 +529,66 @@ void ARApp::SetupLights()
 	default_shader_data.AddPointLight(default_point_light);
 }
 
-void ARApp::SwitchLevels()
+void ARApp::ApplyGovernor()
 {
 
-	// Flip the level ID
-	if (level_id_ == 1)
-	{
-
-		level_id_ = 2;
+	ui_manager_->SetDebugTextAllowed(!governor_->IsEngaged(GOVERNOR_KNOB_DEBUG_TEXT));
+	level_->SetLodScale(governor_->IsEngaged(GOVERNOR_KNOB_MESH_LOD) ? GOVERNOR_LOD_SCALE : 1.0f);
 
-	}
-	else
-	{
+}
 
-		level_id_ = 1;
+void ARApp::SwitchLevels()
+{
 
-	}
+	// Move on to the next level in the pack
+	level_id_ = level_streamer_->GetNextLevel(level_id_);
 
-	// Reset the level
+	// Reset the level, which takes the scenes the streamer has prefetched for it
 	level_->ResetLevel();
-	level_->InitLevel(level_id_, tolerance_value_, &platform_);
+	InitCurrentLevel();
+
+	// Prefetch the levels after this one, and free what's least recently used if the cache is over budget
+	level_streamer_->SetCurrentLevel(level_id_);
+	level_streamer_->Trim();
 
 	// Reset win values
 	has_won_ = false;
 	correct_transforms_ = false;
+	level_start_time_ = Profiler::GetTime();
+
+	telemetry_->Emit(TELEMETRY_EVENT_LEVEL_SWITCHED, frame_count_, level_id_, 0);
+
+}
+
+void ARApp::InitCurrentLevel()
+{
+
+	// A level's file can go missing or stop parsing after the pack was read, which would leave the level without any
+	// objects, so skip ahead through the pack until one initialises
+	for (int attempt = 0; attempt < level_streamer_->GetNumLevels(); attempt++)
+	{
+
+		if (level_->InitLevel(level_id_, tolerance_value_, &platform_))
+		{
+
+			if (attempt > 0)
+			{
+
+				level_streamer_->SetCurrentLevel(level_id_);
+
+			}
+			return;
+
+		}
+
+		level_id_ = level_streamer_->GetNextLevel(level_id_);
+
+	}
+
+	// The first built-in level always initialises, whatever state its level file is in
+	level_id_ = 1;
+	level_->InitLevel(level_id_, tolerance_value_, &platform_);
+	level_streamer_->SetCurrentLevel(level_id_);
 
 }
 
@@ -281,11 +597,67 @@ void ARApp::Reset()
 
 	// Reset the level
 	level_->ResetLevel();
-	level_->InitLevel(level_id_, tolerance_value_, &platform_);
+	InitCurrentLevel();
+	level_streamer_->Trim();
 
 	// Reset the UI
 	ui_manager_->CleanUp(&platform_);
-	ui_manager_->Init(&platform_, camera_image_scale_factor_);
+	ui_manager_->Init(&platform_, camera_image_scale_factor_, asset_bundle_);
+
+	level_start_time_ = Profiler::GetTime();
+
+	telemetry_->Emit(TELEMETRY_EVENT_LEVEL_RESET, frame_count_, level_id_, 0);
+
+}
+
+void ARApp::Win()
+{
+
+	if (!has_won_)
+	{
+
+		telemetry_->Emit(TELEMETRY_EVENT_LEVEL_WON, frame_count_, level_id_, (int)((Profiler::GetTime() - level_start_time_) / 1000));
+
+	}
+
+	has_won_ = true;
+
+}
+
+void ARApp::StartStressBenchmark()
+{
+
+	StressSettings settings;
+	settings.num_markers = STRESS_BENCHMARK_MARKERS;
+	settings.objects_per_marker = 1;
+	settings.mesh_complexity = STRESS_BENCHMARK_MESH_COMPLEXITY;
+	settings.translation_noise = STRESS_BENCHMARK_TRANSLATION_NOISE;
+	settings.rotation_noise = STRESS_BENCHMARK_ROTATION_NOISE;
+	settings.num_frames = STRESS_BENCHMARK_FRAMES;
+	settings.seed = 1;
+
+	stress_benchmark_->Start(settings);
+	stress_benchmark_->BuildLevel(level_, &platform_);
+
+	has_won_ = false;
+	correct_transforms_ = false;
+
+}
+
+void ARApp::StopStressBenchmark()
+{
+
+	// Whatever has been measured so far is kept, even if the benchmark was stopped early
+	stress_benchmark_->WriteResults(STRESS_BENCHMARK_RESULTS_FILE);
+	stress_benchmark_->Stop();
+
+	// Go back to the level that was being played
+	level_->ResetLevel();
+	InitCurrentLevel();
+	level_streamer_->Trim();
+
+	correct_transforms_ = false;
+	level_start_time_ = Profiler::GetTime();
 
 }
 
@@ -299,31 +671,137 @@ void ARApp::HandleInput()
 	if (controller)
 	{
 
-		// If square is pressed and difficulty is normal, detect if the player has won
-		if (controller->buttons_pressed() & gef_SONY_CTRL_SQUARE)
+		gef::UInt32 buttons_pressed = controller->buttons_pressed();
+
+		if (buttons_pressed == 0)
 		{
 
-			if (difficulty == DIFFICULTY_NORMAL)
-			{
+			return;
+
+		}
 
-				if (correct_transforms_)
-				{
+		// Stamp the commands with when they were read so we can measure latency
+		gef::UInt64 timestamp = Profiler::GetTime();
 
-					has_won_ = true;
+		// If square is pressed, check the configuration
+		if (buttons_pressed & gef_SONY_CTRL_SQUARE)
+		{
 
-				}
+			command_queue_.Push(COMMAND_CHECK_CONFIGURATION, frame_count_, timestamp);
 
-			}
+		}
+		// If cross is pressed, move on from the win screen or hide/show the instructions
+		if (buttons_pressed & gef_SONY_CTRL_CROSS)
+		{
+
+			command_queue_.Push(COMMAND_CONFIRM, frame_count_, timestamp);
+
+		}
+		// If the circle is pressed, switch the difficulty
+		if (buttons_pressed & gef_SONY_CTRL_CIRCLE)
+		{
+
+			command_queue_.Push(COMMAND_TOGGLE_DIFFICULTY, frame_count_, timestamp);
+
+		}
+		// If the triangle is pressed, reset the game
+		if (buttons_pressed & gef_SONY_CTRL_TRIANGLE)
+		{
+
+			command_queue_.Push(COMMAND_RESET, frame_count_, timestamp);
+
+		}
+		// If the down button is pressed, switch levels
+		if (buttons_pressed & gef_SONY_CTRL_DOWN)
+		{
+
+			command_queue_.Push(COMMAND_SWITCH_LEVEL, frame_count_, timestamp);
+
+		}
+		// If the up button is pressed, display the transforms of the marker game objects
+		if (buttons_pressed & gef_SONY_CTRL_UP)
+		{
+
+			command_queue_.Push(COMMAND_TOGGLE_TRANSFORMS, frame_count_, timestamp);
+
+		}
+		// If start is pressed, capture the current configuration as the level's reference transforms
+		if (buttons_pressed & gef_SONY_CTRL_START)
+		{
+
+			command_queue_.Push(COMMAND_CAPTURE_REFERENCE, frame_count_, timestamp);
+
+		}
+		// If select is pressed, start or stop the stress benchmark
+		if (buttons_pressed & gef_SONY_CTRL_SELECT)
+		{
+
+			command_queue_.Push(COMMAND_STRESS_BENCHMARK, frame_count_, timestamp);
+
+		}
+		// If the right button is pressed, start or stop looking back through the pose history
+		if (buttons_pressed & gef_SONY_CTRL_RIGHT)
+		{
+
+			command_queue_.Push(COMMAND_TOGGLE_REWIND, frame_count_, timestamp);
+
+		}
+		// If the shoulder buttons are pressed, step through the pose history
+		if (buttons_pressed & gef_SONY_CTRL_L1)
+		{
+
+			command_queue_.Push(COMMAND_REWIND_BACK, frame_count_, timestamp);
+
+		}
+		if (buttons_pressed & gef_SONY_CTRL_R1)
+		{
+
+			command_queue_.Push(COMMAND_REWIND_FORWARD, frame_count_, timestamp);
 
 		}
-		if (controller->buttons_pressed() & gef_SONY_CTRL_CROSS)
+
+	}
+
+}
+
+void ARApp::ProcessCommands()
+{
+
+	Command command;
+
+	while (command_queue_.Pop(command))
+	{
+
+		// Remember the oldest input that hasn't reached the screen yet
+		if (pending_input_timestamp_ == 0)
+		{
+
+			pending_input_timestamp_ = command.timestamp;
+
+		}
+
+		switch (command.type)
 		{
 
+		case COMMAND_CHECK_CONFIGURATION:
+
+			// If the difficulty is normal, detect if the player has won
+			if (difficulty == DIFFICULTY_NORMAL && correct_transforms_ && !stress_benchmark_->IsRunning())
+			{
+
+				Win();
+
+			}
+			break;
+
+		case COMMAND_CONFIRM:
+
 			// If the player has won, switch levels
 			if (has_won_)
 			{
 
-				SwitchLevels();
+				switch_level_pending_ = true;
+				deferred_input_timestamp_ = command.timestamp;
 
 			}
 			else
@@ -333,11 +811,9 @@ void ARApp::HandleInput()
 				show_controls_ = !show_controls_;
 
 			}
+			break;
 
-		}
-		// If the circle is pressed, switch the difficulty
-		if (controller->buttons_pressed() & gef_SONY_CTRL_CIRCLE)
-		{
+		case COMMAND_TOGGLE_DIFFICULTY:
 
 			if (difficulty == DIFFICULTY_NORMAL)
 			{
@@ -351,30 +827,157 @@ void ARApp::HandleInput()
 				difficulty = DIFFICULTY_NORMAL;
 
 			}
+			telemetry_->Emit(TELEMETRY_EVENT_DIFFICULTY_CHANGED, frame_count_, level_id_, difficulty);
+			break;
+
+		case COMMAND_RESET:
+
+			// The benchmark's generated level and timings would be spoiled by reloading the real one under it,
+			// so it has to be stopped with its own button first
+			if (!stress_benchmark_->IsRunning())
+			{
+
+				reset_pending_ = true;
+				deferred_input_timestamp_ = command.timestamp;
+
+			}
+			break;
+
+		case COMMAND_SWITCH_LEVEL:
+
+			if (!stress_benchmark_->IsRunning())
+			{
+
+				switch_level_pending_ = true;
+				deferred_input_timestamp_ = command.timestamp;
+
+			}
+			break;
+
+		case COMMAND_TOGGLE_TRANSFORMS:
+
+			ui_manager_->DisplayTransforms(!ui_manager_->IsDisplayingTransforms());
+			break;
+
+		case COMMAND_CAPTURE_REFERENCE:
+
+			level_->BeginCapture();
+			break;
+
+		case COMMAND_STRESS_BENCHMARK:
+
+			stress_benchmark_pending_ = true;
+			deferred_input_timestamp_ = command.timestamp;
+			break;
+
+		case COMMAND_TOGGLE_REWIND:
+
+			if (level_->IsRewinding())
+			{
+
+				level_->EndRewind();
+
+			}
+			else if (!stress_benchmark_->IsRunning())
+			{
+
+				// The benchmark's frames are timed, so it can't be paused to look back over them
+				level_->BeginRewind();
+
+			}
+			break;
+
+		case COMMAND_REWIND_BACK:
+
+			level_->Rewind(REWIND_STEP_FRAMES);
+			break;
+
+		case COMMAND_REWIND_FORWARD:
+
+			level_->Rewind(-REWIND_STEP_FRAMES);
+			break;
 
 		}
-		// If the triangle is pressed, reset the game
-		if (controller->buttons_pressed() & gef_SONY_CTRL_TRIANGLE)
+
+	}
+
+}
+
+void ARApp::RunDeferredCommands()
+{
+
+	// The frame has been presented, so any input acted on this frame has now reached the screen
+	if (pending_input_timestamp_ != 0)
+	{
+
+		profiler_->SetValue(PROFILER_VALUE_INPUT_LATENCY, (Profiler::GetTime() - pending_input_timestamp_) / 1000.0f);
+		pending_input_timestamp_ = 0;
+
+	}
+
+	// Move the benchmark on, building the next level between frames like any other reload
+	if (stress_benchmark_->IsRunning() && !stress_benchmark_pending_)
+	{
+
+		if (!stress_benchmark_->EndFrame(profiler_))
 		{
 
-			Reset();
+			StopStressBenchmark();
 
 		}
-		// If the down button is pressed, switch levels
-		if (controller->buttons_pressed() & gef_SONY_CTRL_DOWN)
+		else if (stress_benchmark_->NeedsLevel())
 		{
 
-			SwitchLevels();
+			stress_benchmark_->BuildLevel(level_, &platform_);
 
 		}
-		// If the up button is pressed, display the transforms of the marker game objects
-		if (controller->buttons_pressed() & gef_SONY_CTRL_UP)
+
+	}
+
+	if (!reset_pending_ && !switch_level_pending_ && !stress_benchmark_pending_)
+	{
+
+		return;
+
+	}
+
+	// Reloading assets here means it never happens in the middle of tracking or rendering
+	if (reset_pending_)
+	{
+
+		Reset();
+		reset_pending_ = false;
+
+	}
+
+	if (switch_level_pending_)
+	{
+
+		SwitchLevels();
+		switch_level_pending_ = false;
+
+	}
+
+	if (stress_benchmark_pending_)
+	{
+
+		if (stress_benchmark_->IsRunning())
 		{
 
-			ui_manager_->DisplayTransforms(!ui_manager_->IsDisplayingTransforms());
+			StopStressBenchmark();
 
 		}
+		else
+		{
+
+			StartStressBenchmark();
+
+		}
+		stress_benchmark_pending_ = false;
 
 	}
 
+	// The result will be presented next frame, so measure the latency then
+	pending_input_timestamp_ = deferred_input_timestamp_;
+
 }
\ No newline at end of file
@@ -10,9 +10,43 @@
 #include "game_object.h"
 #include "level.h"
 #include "ui_manager.h"
+#include "profiler.h"
+#include "command_queue.h"
+#include "telemetry.h"
+#include "frame_governor.h"
+#include "asset_bundle.h"
+#include "task_pool.h"
+#include "camera_calibration.h"
+#include "level_streamer.h"
+#include "stress_benchmark.h"
+#include "asset_baker.h"
 
 // Vita AR includes removed for copyright purposes
 
+// Maximum number of simulation steps taken in one update, so a long frame can't stall the game
+#define MAX_SIMULATION_STEPS 5
+
+// Fraction of the screen size used to pick mesh LODs when the governor wants coarser ones
+#define GOVERNOR_LOD_SCALE 0.5f
+
+// Number of frames between marker tracking updates while the markers are holding still, with the poses extrapolated in between
+#define TRACKING_INTERVAL 2
+
+// Factor the tracking interval is multiplied by when the governor has lowered the tracking rate
+#define GOVERNOR_TRACKING_INTERVAL 2
+
+// Number of frames between checks of the level file for changes, in development builds with HOT_RELOAD_LEVELS defined
+#define HOT_RELOAD_INTERVAL 30
+
+// Number of frames each press moves through the pose history
+#define REWIND_STEP_FRAMES 1
+
+// Settings for the stress benchmark's generated levels and pose traces
+#define STRESS_BENCHMARK_MARKERS 4
+#define STRESS_BENCHMARK_MESH_COMPLEXITY 8
+#define STRESS_BENCHMARK_TRANSLATION_NOISE 0.001f
+#define STRESS_BENCHMARK_ROTATION_NOISE 0.005f
+
 // FRAMEWORK FORWARD DECLARATIONS
 namespace gef
 {
@@ -49,25 +83,66 @@ private:
 
 	void SetupLights();
 
+	// Startup tasks that are run together on the task pool
+	static void InitTrackingTask(void* argument);
+	static void DecodeUITask(void* argument);
+	static void PreloadLevelTask(void* argument);
+
+	// Function for applying the governor's knobs to the rest of the game
+	void ApplyGovernor();
+
 	// Function for switching between the two levels
 	void SwitchLevels();
 
-	// Function for handling controller input
+	// Function for initialising the current level, moving on through the pack if it can't be read
+	void InitCurrentLevel();
+
+	// Function for reading controller input into the command queue
 	void HandleInput();
 
+	// Function for acting on the queued commands, deferring the ones that reload assets
+	void ProcessCommands();
+
+	// Function for running deferred commands once the frame has been presented
+	void RunDeferredCommands();
+
 	// Function for resetting the game
 	void Reset();
 
+	// Function for setting the level as won, recording how long it took the first time
+	void Win();
+
+	// Functions for starting the stress benchmark, and for stopping it and going back to the current level
+	void StartStressBenchmark();
+	void StopStressBenchmark();
+
 	gef::InputManager* input_manager_;
 	gef::SpriteRenderer* sprite_renderer_;
 	class gef::Renderer3D* renderer_3d_;
 
 	float fps_;
 
+	// Frame time that hasn't yet been consumed by fixed simulation steps
+	float simulation_accumulator_;
+
 	// Handles the user interface & text
 	UIManager* ui_manager_;
 	// Handles the game objects, transforms, and configuration calculation
 	Level* level_;
+	// Gathers per-frame statistics
+	Profiler* profiler_;
+	// Records session events to file in the background
+	Telemetry* telemetry_;
+	// Sheds work when frames go over budget
+	FrameGovernor* governor_;
+	// Pre-baked scenes and textures, which stay loaded as levels are reloaded from them
+	AssetBundle* asset_bundle_;
+	// Camera intrinsics and lens distortion, used for the projection and for correcting marker transforms
+	CameraCalibration* camera_calibration_;
+	// Campaign's level pack, and the cache of scenes read ahead of the levels that use them
+	LevelStreamer* level_streamer_;
+	// Replays generated levels of increasing size to measure how the frame's cost scales
+	StressBenchmark* stress_benchmark_;
 
 	// Sprite holding the camera image data
 	gef::Sprite* camera_sprite_;
@@ -87,15 +162,35 @@ private:
 	float camera_image_scale_factor_;
 	bool marker_02_found_;
 	bool marker_01_found_;
+	// Whether both markers were found last frame, so losing and finding them can be recorded
+	bool markers_found_;
 
 	// Value that transforms are checked against to detect the correct transforms
 	float tolerance_value_;
 
+	// Number of frames between marker tracking updates while the markers are holding still
+	int tracking_interval_;
+
 	bool correct_transforms_;
 	bool show_controls_;
 	bool has_won_;
 	
 	int level_id_;
+	// Time the current level was started, for recording how long it took to win
+	gef::UInt64 level_start_time_;
+
+	// Commands read from the controller, waiting to be acted on
+	CommandQueue command_queue_;
+	gef::UInt32 frame_count_;
+
+	// Commands that reload assets are deferred until after the frame has been presented
+	bool reset_pending_;
+	bool switch_level_pending_;
+	bool stress_benchmark_pending_;
+	gef::UInt64 deferred_input_timestamp_;
+
+	// Time the oldest input whose result hasn't been presented yet was read, or 0 if there isn't one
+	gef::UInt64 pending_input_timestamp_;
 	
 };
 
@@ -0,0 +1,120 @@
+#include "asset_baker.h"
+#include <stdio.h>
+#include <string>
+#include <kernel.h>
+#include "level.h"
+#include "level_streamer.h"
+#include "mesh_simplifier.h"
+#include "asset_bundle.h"
+#include "ui_manager.h"
+
+bool AssetBaker::BakeAll(gef::Platform* platform_, const LevelStreamer* level_streamer, float tolerance_value)
+{
+
+	sceIoMkdir(LEVEL_DEFINITION_PATH, 0777);
+	sceIoMkdir(ASSET_BAKER_OUTPUT_PATH, 0777);
+
+	FILE* report = fopen(ASSET_BAKER_REPORT_FILE, "w");
+	bool success = true;
+
+	std::vector<int> level_identifiers;
+	int level_identifier = level_streamer->GetFirstLevel();
+	for (int level = 0; level < level_streamer->GetNumLevels(); level++)
+	{
+
+		level_identifiers.push_back(level_identifier);
+		level_identifier = level_streamer->GetNextLevel(level_identifier);
+
+	}
+
+	// Each scene's LODs only need simplifying once, however many levels use it
+	std::vector<std::string> lod_scene_files;
+	for (std::vector<int>::const_iterator level = level_identifiers.begin(); level != level_identifiers.end(); ++level)
+	{
+
+		LevelDefinition definition;
+		gef::UInt32 hash;
+		if (!Level::ReadDefinition(*level, tolerance_value, definition, hash))
+		{
+
+			continue;
+
+		}
+
+		for (std::vector<ObjectDefinition>::const_iterator it = definition.objects.begin(); it != definition.objects.end(); ++it)
+		{
+
+			bool is_baked = false;
+			for (std::vector<std::string>::const_iterator baked = lod_scene_files.begin(); baked != lod_scene_files.end(); ++baked)
+			{
+
+				is_baked = is_baked || *baked == it->lod_scene_file;
+
+			}
+
+			if (is_baked)
+			{
+
+				continue;
+
+			}
+
+			std::string lod_file = ASSET_BAKER_OUTPUT_PATH + it->lod_scene_file;
+			bool is_written = MeshSimplifier::BakeLodScene(platform_, it->scene_file.c_str(), lod_file.c_str());
+			success = success && is_written;
+			if (is_written)
+			{
+
+				lod_scene_files.push_back(it->lod_scene_file);
+
+			}
+
+			if (report)
+			{
+
+				fprintf(report, "lod %s %s\n", lod_file.c_str(), is_written ? "ok" : "FAILED");
+
+			}
+
+		}
+
+	}
+
+	// The symmetries are worked out from the full resolution meshes, so they don't depend on the LODs
+	for (std::vector<int>::const_iterator level = level_identifiers.begin(); level != level_identifiers.end(); ++level)
+	{
+
+		bool is_written = Level::BakeSymmetries(platform_, *level, tolerance_value);
+		success = success && is_written;
+
+		if (report)
+		{
+
+			fprintf(report, "symmetry %s %s\n", LevelDefinition::GetFileName(*level).c_str(), is_written ? "ok" : "FAILED");
+
+		}
+
+	}
+
+	std::vector<std::string> texture_files;
+	for (int texture = 0; texture < NUM_UI_TEXTURES; texture++)
+	{
+
+		texture_files.push_back(UIManager::GetTextureFile((UITexture)texture));
+
+	}
+
+	bool is_bundled = AssetBundle::Bake(*platform_, ASSET_BAKER_BUNDLE_FILE, lod_scene_files, texture_files, ASSET_BAKER_OUTPUT_PATH);
+	success = success && is_bundled;
+
+	if (report)
+	{
+
+		fprintf(report, "bundle %s %s\n", ASSET_BAKER_BUNDLE_FILE, is_bundled ? "ok" : "FAILED");
+		fclose(report);
+
+	}
+
+	return success;
+
+}
\ No newline at end of file
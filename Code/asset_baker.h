@@ -0,0 +1,40 @@
+#ifndef ASSET_BAKER_H
+#define ASSET_BAKER_H
+
+#include <vector>
+#include "level_definition.h"
+
+// Folder the baked LOD scenes and asset bundle are written to, to be copied into the app's media folder
+#define ASSET_BAKER_OUTPUT_PATH LEVEL_DEFINITION_PATH "baked/"
+// Name the bundle is baked to in the output folder, matching ASSET_BUNDLE_FILE
+#define ASSET_BAKER_BUNDLE_FILE ASSET_BAKER_OUTPUT_PATH "assets.bundle"
+// File listing what was baked and what failed, as there's no console to report it on
+#define ASSET_BAKER_REPORT_FILE ASSET_BAKER_OUTPUT_PATH "bake_report.txt"
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Platform;
+
+}
+
+class LevelStreamer;
+
+// Asset baker class
+// Precomputes the data the game otherwise has to work out as it loads, for every level in the pack
+// This is run by building with BAKE_ASSETS defined, which bakes everything at startup and then carries on into the game:
+//   each object scene's LOD scene, written to ASSET_BAKER_OUTPUT_PATH with the name the level gives it
+//   each level's shape symmetries, written into its level file in LEVEL_DEFINITION_PATH
+//   a bundle of the LOD scenes and the UI textures, written to ASSET_BAKER_BUNDLE_FILE
+class AssetBaker
+{
+
+public:
+
+	// Bake everything for the levels in a pack, returning false if any of it failed
+	static bool BakeAll(gef::Platform* platform_, const LevelStreamer* level_streamer, float tolerance_value);
+
+};
+
+#endif // !ASSET_BAKER_H
\ No newline at end of file
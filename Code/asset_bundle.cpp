@@ -0,0 +1,626 @@
+#include "asset_bundle.h"
+#include <stdio.h>
+#include <string.h>
+#include <system/platform.h>
+#include <graphics/scene.h>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/material.h>
+#include <graphics/texture.h>
+#include <graphics/image_data.h>
+#include <assets/png_loader.h>
+
+// Round a size up to the bundle's alignment
+static gef::UInt32 Align(gef::UInt32 size)
+{
+
+	return (size + ASSET_BUNDLE_ALIGNMENT - 1) & ~(ASSET_BUNDLE_ALIGNMENT - 1);
+
+}
+
+// Add an aligned, zeroed block to the end of the bundle being baked, returning its offset
+static gef::UInt32 Reserve(std::vector<gef::UInt8>& data, gef::UInt32 size)
+{
+
+	gef::UInt32 offset = Align((gef::UInt32)data.size());
+	data.resize(offset + size, 0);
+
+	return offset;
+
+}
+
+// Add an aligned copy of some data to the end of the bundle being baked, returning its offset
+static gef::UInt32 Append(std::vector<gef::UInt8>& data, const void* source, gef::UInt32 size)
+{
+
+	gef::UInt32 offset = Reserve(data, size);
+	if (size > 0)
+	{
+
+		memcpy(&data[offset], source, size);
+
+	}
+
+	return offset;
+
+}
+
+// Add a scene's meshes and materials to the bundle being baked, returning false if it can't be bundled
+static bool BakeScene(gef::Platform& platform, const char* file_name, std::vector<gef::UInt8>& data, BundleEntry& entry)
+{
+
+	gef::Scene scene;
+	if (!scene.ReadSceneFromFile(platform, file_name))
+	{
+
+		return false;
+
+	}
+
+	// Textures come from files the scene names, which we can't bundle, so textured scenes are loaded as normal
+	scene.CreateMaterials(platform);
+	for (std::vector<gef::Material*>::iterator it = scene.materials.begin(); it != scene.materials.end(); ++it)
+	{
+
+		if ((*it)->texture())
+		{
+
+			return false;
+
+		}
+
+	}
+
+	BundleScene bundle_scene;
+	bundle_scene.num_materials = (gef::UInt32)scene.material_data.size();
+	bundle_scene.num_meshes = (gef::UInt32)scene.mesh_data.size();
+
+	entry.type = BUNDLE_ENTRY_SCENE;
+	entry.offset = Reserve(data, sizeof(BundleScene));
+	bundle_scene.materials_offset = Reserve(data, bundle_scene.num_materials * sizeof(BundleMaterial));
+	bundle_scene.meshes_offset = Reserve(data, bundle_scene.num_meshes * sizeof(BundleMesh));
+	memcpy(&data[entry.offset], &bundle_scene, sizeof(BundleScene));
+
+	int material = 0;
+	for (std::list<gef::MaterialData>::iterator it = scene.material_data.begin(); it != scene.material_data.end(); ++it, ++material)
+	{
+
+		BundleMaterial bundle_material;
+		bundle_material.name_id = it->name_id;
+		bundle_material.colour = it->colour;
+		memcpy(&data[bundle_scene.materials_offset + material * sizeof(BundleMaterial)], &bundle_material, sizeof(BundleMaterial));
+
+	}
+
+	int mesh = 0;
+	for (std::list<gef::MeshData>::iterator it = scene.mesh_data.begin(); it != scene.mesh_data.end(); ++it, ++mesh)
+	{
+
+		BundleMesh bundle_mesh;
+		bundle_mesh.name_id = it->name_id;
+		bundle_mesh.num_vertices = it->vertex_data.num_vertices;
+		bundle_mesh.vertex_byte_size = it->vertex_data.vertex_byte_size;
+		bundle_mesh.num_primitives = (gef::UInt32)it->primitives.size();
+		bundle_mesh.aabb_min[0] = it->aabb.min_vtx().x();
+		bundle_mesh.aabb_min[1] = it->aabb.min_vtx().y();
+		bundle_mesh.aabb_min[2] = it->aabb.min_vtx().z();
+		bundle_mesh.aabb_max[0] = it->aabb.max_vtx().x();
+		bundle_mesh.aabb_max[1] = it->aabb.max_vtx().y();
+		bundle_mesh.aabb_max[2] = it->aabb.max_vtx().z();
+		bundle_mesh.sphere_position[0] = it->bounding_sphere.position().x();
+		bundle_mesh.sphere_position[1] = it->bounding_sphere.position().y();
+		bundle_mesh.sphere_position[2] = it->bounding_sphere.position().z();
+		bundle_mesh.sphere_radius = it->bounding_sphere.radius();
+
+		bundle_mesh.primitives_offset = Reserve(data, bundle_mesh.num_primitives * sizeof(BundlePrimitive));
+		bundle_mesh.vertices_offset = Append(data, it->vertex_data.vertices, bundle_mesh.num_vertices * bundle_mesh.vertex_byte_size);
+
+		for (gef::UInt32 primitive = 0; primitive < bundle_mesh.num_primitives; primitive++)
+		{
+
+			const gef::PrimitiveData* primitive_data = it->primitives[primitive];
+
+			BundlePrimitive bundle_primitive;
+			bundle_primitive.type = primitive_data->type;
+			bundle_primitive.num_indices = primitive_data->num_indices;
+			bundle_primitive.index_byte_size = primitive_data->index_byte_size;
+			bundle_primitive.material_name_id = primitive_data->material_name_id;
+			bundle_primitive.indices_offset = Append(data, primitive_data->indices, bundle_primitive.num_indices * bundle_primitive.index_byte_size);
+			memcpy(&data[bundle_mesh.primitives_offset + primitive * sizeof(BundlePrimitive)], &bundle_primitive, sizeof(BundlePrimitive));
+
+		}
+
+		memcpy(&data[bundle_scene.meshes_offset + mesh * sizeof(BundleMesh)], &bundle_mesh, sizeof(BundleMesh));
+
+	}
+
+	entry.size = (gef::UInt32)data.size() - entry.offset;
+
+	return true;
+
+}
+
+// Add a PNG's decoded texels to the bundle being baked, returning false if it can't be read
+static bool BakeTexture(gef::Platform& platform, const char* file_name, std::vector<gef::UInt8>& data, BundleEntry& entry)
+{
+
+	gef::PNGLoader png_loader;
+	gef::ImageData image_data;
+	png_loader.Load(file_name, platform, image_data);
+
+	if (!image_data.image() || image_data.width() > ASSET_BUNDLE_MAX_TEXTURE_SIZE || image_data.height() > ASSET_BUNDLE_MAX_TEXTURE_SIZE)
+	{
+
+		return false;
+
+	}
+
+	BundleTexture bundle_texture;
+	bundle_texture.width = image_data.width();
+	bundle_texture.height = image_data.height();
+	bundle_texture.padding = 0;
+
+	entry.type = BUNDLE_ENTRY_TEXTURE;
+	entry.offset = Reserve(data, sizeof(BundleTexture));
+
+	// The PNG loader always decodes to 32 bit RGBA
+	bundle_texture.texels_offset = Append(data, image_data.image(), bundle_texture.width * bundle_texture.height * 4);
+	memcpy(&data[entry.offset], &bundle_texture, sizeof(BundleTexture));
+
+	entry.size = (gef::UInt32)data.size() - entry.offset;
+
+	return true;
+
+}
+
+AssetBundle::AssetBundle() :
+	buffer_(NULL),
+	data_(NULL),
+	size_(0)
+{
+}
+
+AssetBundle::~AssetBundle()
+{
+
+	Unload();
+
+}
+
+bool AssetBundle::Load(const char* file_name)
+{
+
+	Unload();
+
+	FILE* file = fopen(file_name, "rb");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (size < (long)sizeof(BundleHeader))
+	{
+
+		fclose(file);
+		return false;
+
+	}
+
+	// There's no memory mapping of files, so read the whole bundle in one go into a buffer aligned like the file
+	buffer_ = new gef::UInt8[size + ASSET_BUNDLE_ALIGNMENT];
+	data_ = buffer_ + (ASSET_BUNDLE_ALIGNMENT - ((size_t)buffer_ & (ASSET_BUNDLE_ALIGNMENT - 1))) % ASSET_BUNDLE_ALIGNMENT;
+	size_ = (gef::UInt32)size;
+
+	bool success = fread(data_, 1, size, file) == (size_t)size;
+	fclose(file);
+
+	const BundleHeader* header = (const BundleHeader*)data_;
+	success = success && memcmp(header->magic, "SMAB", 4) == 0 && header->version == ASSET_BUNDLE_VERSION && header->file_size == size_;
+
+	if (!success || !ReadEntries())
+	{
+
+		Unload();
+		return false;
+
+	}
+
+	return true;
+
+}
+
+void AssetBundle::Unload()
+{
+
+	for (std::vector<BundledScene>::iterator scene = scenes_.begin(); scene != scenes_.end(); ++scene)
+	{
+
+		for (std::vector<gef::MeshData>::iterator it = scene->mesh_data.begin(); it != scene->mesh_data.end(); ++it)
+		{
+
+			for (std::vector<gef::PrimitiveData*>::iterator primitive = it->primitives.begin(); primitive != it->primitives.end(); ++primitive)
+			{
+
+				delete *primitive;
+
+			}
+
+		}
+
+		for (std::vector<gef::Material*>::iterator it = scene->materials.begin(); it != scene->materials.end(); ++it)
+		{
+
+			delete *it;
+
+		}
+
+	}
+	scenes_.clear();
+
+	delete[] buffer_;
+	buffer_ = NULL;
+	data_ = NULL;
+	size_ = 0;
+
+}
+
+bool AssetBundle::IsInBundle(gef::UInt32 offset, gef::UInt32 size) const
+{
+
+	return offset <= size_ && size <= size_ - offset && (offset & (ASSET_BUNDLE_ALIGNMENT - 1)) == 0;
+
+}
+
+bool AssetBundle::IsInBundle(gef::UInt32 offset, gef::UInt32 count, gef::UInt32 element_size) const
+{
+
+	if (!IsInBundle(offset, 0))
+	{
+
+		return false;
+
+	}
+
+	return element_size == 0 || count <= (size_ - offset) / element_size;
+
+}
+
+bool AssetBundle::ReadEntries()
+{
+
+	const BundleHeader* header = (const BundleHeader*)data_;
+	gef::UInt32 entries_offset = Align(sizeof(BundleHeader));
+
+	if (!IsInBundle(entries_offset, header->num_entries, sizeof(BundleEntry)))
+	{
+
+		return false;
+
+	}
+
+	const BundleEntry* entries = (const BundleEntry*)(data_ + entries_offset);
+
+	for (gef::UInt32 entry = 0; entry < header->num_entries; entry++)
+	{
+
+		if (!IsInBundle(entries[entry].offset, entries[entry].size) || entries[entry].name[ASSET_BUNDLE_NAME_LENGTH - 1] != '\0')
+		{
+
+			return false;
+
+		}
+
+		if (entries[entry].type == BUNDLE_ENTRY_TEXTURE)
+		{
+
+			const BundleTexture* texture = (const BundleTexture*)(data_ + entries[entry].offset);
+			if (entries[entry].size < sizeof(BundleTexture)
+				|| texture->width > ASSET_BUNDLE_MAX_TEXTURE_SIZE || texture->height > ASSET_BUNDLE_MAX_TEXTURE_SIZE
+				|| !IsInBundle(texture->texels_offset, texture->width * texture->height, 4))
+			{
+
+				return false;
+
+			}
+
+			continue;
+
+		}
+
+		if (entries[entry].type != BUNDLE_ENTRY_SCENE || entries[entry].size < sizeof(BundleScene))
+		{
+
+			return false;
+
+		}
+
+		// Point the scene's mesh data at the vertices and indices in the buffer
+		const BundleScene* bundle_scene = (const BundleScene*)(data_ + entries[entry].offset);
+		if (!IsInBundle(bundle_scene->materials_offset, bundle_scene->num_materials, sizeof(BundleMaterial))
+			|| !IsInBundle(bundle_scene->meshes_offset, bundle_scene->num_meshes, sizeof(BundleMesh)))
+		{
+
+			return false;
+
+		}
+
+		scenes_.push_back(BundledScene());
+		BundledScene& scene = scenes_.back();
+		scene.name = entries[entry].name;
+
+		const BundleMaterial* materials = (const BundleMaterial*)(data_ + bundle_scene->materials_offset);
+		for (gef::UInt32 material = 0; material < bundle_scene->num_materials; material++)
+		{
+
+			gef::Material* new_material = new gef::Material();
+			new_material->set_colour(materials[material].colour);
+			scene.materials.push_back(new_material);
+			scene.material_name_ids.push_back(materials[material].name_id);
+
+		}
+
+		const BundleMesh* meshes = (const BundleMesh*)(data_ + bundle_scene->meshes_offset);
+		for (gef::UInt32 mesh = 0; mesh < bundle_scene->num_meshes; mesh++)
+		{
+
+			const BundleMesh& bundle_mesh = meshes[mesh];
+			if (!IsInBundle(bundle_mesh.vertices_offset, bundle_mesh.num_vertices, bundle_mesh.vertex_byte_size)
+				|| !IsInBundle(bundle_mesh.primitives_offset, bundle_mesh.num_primitives, sizeof(BundlePrimitive)))
+			{
+
+				return false;
+
+			}
+
+			scene.mesh_data.push_back(gef::MeshData());
+			gef::MeshData& mesh_data = scene.mesh_data.back();
+			mesh_data.name_id = bundle_mesh.name_id;
+			mesh_data.vertex_data.num_vertices = bundle_mesh.num_vertices;
+			mesh_data.vertex_data.vertex_byte_size = bundle_mesh.vertex_byte_size;
+			mesh_data.vertex_data.vertices = data_ + bundle_mesh.vertices_offset;
+			mesh_data.aabb.set_min_vtx(gef::Vector4(bundle_mesh.aabb_min[0], bundle_mesh.aabb_min[1], bundle_mesh.aabb_min[2]));
+			mesh_data.aabb.set_max_vtx(gef::Vector4(bundle_mesh.aabb_max[0], bundle_mesh.aabb_max[1], bundle_mesh.aabb_max[2]));
+			mesh_data.bounding_sphere.set_position(gef::Vector4(bundle_mesh.sphere_position[0], bundle_mesh.sphere_position[1], bundle_mesh.sphere_position[2]));
+			mesh_data.bounding_sphere.set_radius(bundle_mesh.sphere_radius);
+
+			const BundlePrimitive* primitives = (const BundlePrimitive*)(data_ + bundle_mesh.primitives_offset);
+			for (gef::UInt32 primitive = 0; primitive < bundle_mesh.num_primitives; primitive++)
+			{
+
+				if (!IsInBundle(primitives[primitive].indices_offset, primitives[primitive].num_indices, primitives[primitive].index_byte_size))
+				{
+
+					return false;
+
+				}
+
+				gef::PrimitiveData* primitive_data = new gef::PrimitiveData();
+				primitive_data->type = (gef::PrimitiveType)primitives[primitive].type;
+				primitive_data->num_indices = primitives[primitive].num_indices;
+				primitive_data->index_byte_size = primitives[primitive].index_byte_size;
+				primitive_data->indices = data_ + primitives[primitive].indices_offset;
+				primitive_data->material_name_id = primitives[primitive].material_name_id;
+				mesh_data.primitives.push_back(primitive_data);
+
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+const BundleEntry* AssetBundle::FindEntry(const char* name, BundleEntryType type) const
+{
+
+	if (!IsLoaded())
+	{
+
+		return NULL;
+
+	}
+
+	const BundleHeader* header = (const BundleHeader*)data_;
+	const BundleEntry* entries = (const BundleEntry*)(data_ + Align(sizeof(BundleHeader)));
+
+	for (gef::UInt32 entry = 0; entry < header->num_entries; entry++)
+	{
+
+		if (entries[entry].type == (gef::UInt32)type && strcmp(entries[entry].name, name) == 0)
+		{
+
+			return &entries[entry];
+
+		}
+
+	}
+
+	return NULL;
+
+}
+
+const BundledScene* AssetBundle::FindScene(const char* name) const
+{
+
+	for (std::vector<BundledScene>::const_iterator it = scenes_.begin(); it != scenes_.end(); ++it)
+	{
+
+		if (it->name == name)
+		{
+
+			return &(*it);
+
+		}
+
+	}
+
+	return NULL;
+
+}
+
+gef::Mesh* AssetBundle::CreateMesh(gef::Platform& platform, const BundledScene* scene, int mesh) const
+{
+
+	const gef::MeshData& mesh_data = scene->mesh_data[mesh];
+
+	// The vertices and indices are already in the layout the GPU buffers want, so they're uploaded straight from the bundle
+	gef::Mesh* new_mesh = new gef::Mesh(platform);
+	new_mesh->set_aabb(mesh_data.aabb);
+	new_mesh->set_bounding_sphere(mesh_data.bounding_sphere);
+	new_mesh->InitVertexBuffer(platform, mesh_data.vertex_data.vertices, mesh_data.vertex_data.num_vertices, mesh_data.vertex_data.vertex_byte_size);
+	new_mesh->AllocatePrimitives((gef::UInt32)mesh_data.primitives.size());
+
+	for (size_t primitive = 0; primitive < mesh_data.primitives.size(); primitive++)
+	{
+
+		const gef::PrimitiveData* primitive_data = mesh_data.primitives[primitive];
+		gef::Primitive* new_primitive = new_mesh->GetPrimitive((gef::UInt32)primitive);
+		new_primitive->InitIndexBuffer(platform, primitive_data->indices, primitive_data->num_indices, primitive_data->index_byte_size);
+		new_primitive->set_type(primitive_data->type);
+
+		for (size_t material = 0; material < scene->material_name_ids.size(); material++)
+		{
+
+			if (scene->material_name_ids[material] == primitive_data->material_name_id)
+			{
+
+				new_primitive->set_material(scene->materials[material]);
+				break;
+
+			}
+
+		}
+
+	}
+
+	return new_mesh;
+
+}
+
+gef::Texture* AssetBundle::CreateTexture(gef::Platform& platform, const char* name) const
+{
+
+	const BundleEntry* entry = FindEntry(name, BUNDLE_ENTRY_TEXTURE);
+	if (!entry)
+	{
+
+		return NULL;
+
+	}
+
+	const BundleTexture* bundle_texture = (const BundleTexture*)(data_ + entry->offset);
+
+	gef::ImageData image_data;
+	image_data.set_width(bundle_texture->width);
+	image_data.set_height(bundle_texture->height);
+	image_data.set_image(data_ + bundle_texture->texels_offset);
+
+	gef::Texture* texture = gef::Texture::Create(platform, image_data);
+
+	// The texels belong to the bundle, so don't let the image data free them
+	image_data.set_image(NULL);
+
+	return texture;
+
+}
+
+bool AssetBundle::Bake(gef::Platform& platform, const char* bundle_file, const std::vector<std::string>& scene_files, const std::vector<std::string>& texture_files,
+	const char* source_path)
+{
+
+	std::vector<gef::UInt8> data;
+	std::vector<BundleEntry> entries;
+
+	gef::UInt32 num_entries = (gef::UInt32)(scene_files.size() + texture_files.size());
+	Reserve(data, sizeof(BundleHeader));
+	gef::UInt32 entries_offset = Reserve(data, num_entries * sizeof(BundleEntry));
+
+	for (gef::UInt32 file = 0; file < num_entries; file++)
+	{
+
+		bool is_scene = file < scene_files.size();
+		const std::string& file_name = is_scene ? scene_files[file] : texture_files[file - scene_files.size()];
+
+		if (file_name.size() >= ASSET_BUNDLE_NAME_LENGTH)
+		{
+
+			return false;
+
+		}
+
+		BundleEntry entry;
+		memset(&entry, 0, sizeof(BundleEntry));
+		strcpy(entry.name, file_name.c_str());
+
+		// Fall back to the game's own file if the source folder doesn't have the scene, undoing anything the first try added
+		size_t data_size = data.size();
+		bool is_baked;
+		if (is_scene)
+		{
+
+			is_baked = source_path && BakeScene(platform, (std::string(source_path) + file_name).c_str(), data, entry);
+			if (!is_baked)
+			{
+
+				data.resize(data_size);
+				is_baked = BakeScene(platform, file_name.c_str(), data, entry);
+
+			}
+
+		}
+		else
+		{
+
+			is_baked = BakeTexture(platform, file_name.c_str(), data, entry);
+
+		}
+
+		if (!is_baked)
+		{
+
+			return false;
+
+		}
+
+		entries.push_back(entry);
+
+	}
+
+	// Pad the end so the file size matches the alignment the reader expects
+	data.resize(Align((gef::UInt32)data.size()), 0);
+
+	BundleHeader header;
+	memcpy(header.magic, "SMAB", 4);
+	header.version = ASSET_BUNDLE_VERSION;
+	header.num_entries = num_entries;
+	header.file_size = (gef::UInt32)data.size();
+	memcpy(&data[0], &header, sizeof(BundleHeader));
+	if (num_entries > 0)
+	{
+
+		memcpy(&data[entries_offset], &entries[0], num_entries * sizeof(BundleEntry));
+
+	}
+
+	FILE* file = fopen(bundle_file, "wb");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	bool success = fwrite(&data[0], 1, data.size(), file) == data.size();
+	fclose(file);
+
+	return success;
+
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <vector>
+#include <string>
+#include <gef.h>
+#include <graphics/mesh_data.h>
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Platform;
+	class Mesh;
+	class Material;
+	class Texture;
+
+}
+
+// Bundle the game's assets are loaded from when it's present, otherwise they're loaded from their own files
+#define ASSET_BUNDLE_FILE "app0:media/assets.bundle"
+
+// Largest texture that can be stored in the bundle, in each dimension
+#define ASSET_BUNDLE_MAX_TEXTURE_SIZE 4096
+
+// Version written to the bundle's header, bundles with any other version are ignored
+#define ASSET_BUNDLE_VERSION 1
+
+// Alignment of everything in the bundle, relative to the start of the file
+#define ASSET_BUNDLE_ALIGNMENT 16
+
+// Longest asset name that can be stored in the bundle, including the terminator
+#define ASSET_BUNDLE_NAME_LENGTH 48
+
+// Enumerated type for the kinds of asset held in a bundle
+enum BundleEntryType
+{
+
+	BUNDLE_ENTRY_SCENE,					// Meshes and their materials, from a scene file
+	BUNDLE_ENTRY_TEXTURE,				// Decoded RGBA texels, from a PNG file
+	NUM_BUNDLE_ENTRY_TYPES
+
+};
+
+// Layout of the bundle file
+// Everything's stored in the layout it's used in at runtime, so loading is one read and a few pointer fixups
+// Offsets are from the start of the file, and everything they point to is aligned to ASSET_BUNDLE_ALIGNMENT
+//
+//   BundleHeader
+//   BundleEntry for each asset
+//   for a scene: BundleScene, then its BundleMaterials, BundleMeshes and BundlePrimitives, then vertex and index data
+//   for a texture: BundleTexture, then its texels
+struct BundleHeader
+{
+
+	char magic[4];
+	gef::UInt32 version;
+	gef::UInt32 num_entries;
+	gef::UInt32 file_size;
+
+};
+
+struct BundleEntry
+{
+
+	char name[ASSET_BUNDLE_NAME_LENGTH];
+	gef::UInt32 type;
+	gef::UInt32 offset;
+	gef::UInt32 size;
+	gef::UInt32 padding;
+
+};
+
+struct BundleScene
+{
+
+	gef::UInt32 num_materials;
+	gef::UInt32 num_meshes;
+	gef::UInt32 materials_offset;
+	gef::UInt32 meshes_offset;
+
+};
+
+struct BundleMaterial
+{
+
+	gef::StringId name_id;
+	gef::UInt32 colour;
+
+};
+
+struct BundleMesh
+{
+
+	gef::StringId name_id;
+	gef::UInt32 num_vertices;
+	gef::UInt32 vertex_byte_size;
+	gef::UInt32 vertices_offset;
+	gef::UInt32 num_primitives;
+	gef::UInt32 primitives_offset;
+	float aabb_min[3];
+	float aabb_max[3];
+	float sphere_position[3];
+	float sphere_radius;
+
+};
+
+struct BundlePrimitive
+{
+
+	gef::UInt32 type;
+	gef::UInt32 num_indices;
+	gef::UInt32 index_byte_size;
+	gef::UInt32 indices_offset;
+	gef::StringId material_name_id;
+
+};
+
+struct BundleTexture
+{
+
+	gef::UInt32 width;
+	gef::UInt32 height;
+	gef::UInt32 texels_offset;
+	gef::UInt32 padding;
+
+};
+
+// A scene in a loaded bundle, with its mesh data pointing into the bundle's buffer
+struct BundledScene
+{
+
+	std::string name;
+	std::vector<gef::MeshData> mesh_data;
+	std::vector<gef::StringId> material_name_ids;
+	std::vector<gef::Material*> materials;
+
+};
+
+// Asset bundle class
+// Holds the game's scenes and textures in one pre-baked file, so starting up doesn't parse scenes or decode PNGs
+// The file is read with a single read into an aligned buffer that stays resident, and the meshes and textures are
+// uploaded straight from it
+// Only untextured scenes can be bundled, and the font is still loaded from its own files, as GEF can only load it by name
+class AssetBundle
+{
+
+public:
+
+	AssetBundle();
+	~AssetBundle();
+
+	// Read a bundle, returning false if it's missing or was baked for a different version
+	bool Load(const char* file_name);
+	// Release the bundle along with the materials created from it
+	void Unload();
+	inline bool IsLoaded() const { return buffer_ != NULL; };
+
+	// Find a scene by the file it was baked from, returning NULL if it isn't in the bundle
+	const BundledScene* FindScene(const char* name) const;
+	// Create a mesh from one of a scene's mesh data, using the bundle's materials
+	gef::Mesh* CreateMesh(gef::Platform& platform, const BundledScene* scene, int mesh) const;
+	// Check if the texels baked from a PNG file are in the bundle
+	inline bool HasTexture(const char* name) const { return FindEntry(name, BUNDLE_ENTRY_TEXTURE) != NULL; };
+	// Create a texture from the texels baked from a PNG file, returning NULL if it isn't in the bundle
+	gef::Texture* CreateTexture(gef::Platform& platform, const char* name) const;
+
+	// Bake scene files and PNG files into a bundle, returning false if any of them can't be read or bundled
+	// This is an offline step run by AssetBaker, the files should be the ones the game would otherwise load, e.g. the LOD scenes
+	// Scenes are read from the source folder first if there is one, e.g. where the LOD scenes were just baked to,
+	// but are still named in the bundle by the files the game loads
+	static bool Bake(gef::Platform& platform, const char* bundle_file, const std::vector<std::string>& scene_files, const std::vector<std::string>& texture_files,
+		const char* source_path = NULL);
+
+private:
+
+	// Check the bundle's tables are consistent and set up the scenes' mesh data and materials
+	bool ReadEntries();
+	// Check a range of the bundle lies inside it
+	bool IsInBundle(gef::UInt32 offset, gef::UInt32 size) const;
+	// Check an array of elements lies inside the bundle, without multiplying out a size that could wrap
+	bool IsInBundle(gef::UInt32 offset, gef::UInt32 count, gef::UInt32 element_size) const;
+	const BundleEntry* FindEntry(const char* name, BundleEntryType type) const;
+
+	// Buffer the bundle was read into, and the aligned start of the bundle within it
+	gef::UInt8* buffer_;
+	gef::UInt8* data_;
+	gef::UInt32 size_;
+
+	std::vector<BundledScene> scenes_;
+
+};
+
+#endif // !ASSET_BUNDLE_H
\ No newline at end of file
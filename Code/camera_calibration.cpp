@@ -0,0 +1,1000 @@
+#include "camera_calibration.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <kernel.h>
+
+// Number of intrinsic parameters fitted: focal lengths, centre, then k1, k2, p1, p2, k3
+#define NUM_CALIBRATION_PARAMETERS 9
+
+// Number of parameters fitted for each board pose: a small rotation, then a translation
+#define NUM_POSE_PARAMETERS 6
+
+// Number of unknowns in a homography, with its last element fixed at 1
+#define NUM_HOMOGRAPHY_PARAMETERS 8
+
+// Largest RMS reprojection error in pixels a fit can end with and still be used
+static const float max_rms_error = 5.0f;
+
+// Number of iterations used to invert the distortion when building the undistortion map
+static const int undistort_iterations = 20;
+
+// One recorded frame of the calibration board, and the board's pose in it
+struct BoardView
+{
+
+	// Range of samples seen in the frame
+	size_t first_sample;
+	size_t last_sample;
+
+	// Board to camera space, with the camera looking down +z and y pointing down the image as it does in pixels
+	double rotation[3][3];
+	double translation[3];
+
+};
+
+// Solve the linear system a * x = b in place by Gaussian elimination with partial pivoting, leaving x in b
+// a is size by size and stored a row at a time
+static bool Solve(std::vector<double>& a, std::vector<double>& b, int size)
+{
+
+	for (int column = 0; column < size; column++)
+	{
+
+		int pivot = column;
+		for (int row = column + 1; row < size; row++)
+		{
+
+			if (fabs(a[row * size + column]) > fabs(a[pivot * size + column]))
+			{
+
+				pivot = row;
+
+			}
+
+		}
+
+		if (fabs(a[pivot * size + column]) < 1.0e-12)
+		{
+
+			return false;
+
+		}
+
+		for (int k = 0; k < size; k++)
+		{
+
+			double swap = a[column * size + k];
+			a[column * size + k] = a[pivot * size + k];
+			a[pivot * size + k] = swap;
+
+		}
+
+		double swap = b[column];
+		b[column] = b[pivot];
+		b[pivot] = swap;
+
+		for (int row = column + 1; row < size; row++)
+		{
+
+			double factor = a[row * size + column] / a[column * size + column];
+			if (factor == 0.0)
+			{
+
+				continue;
+
+			}
+
+			for (int k = column; k < size; k++)
+			{
+
+				a[row * size + k] -= factor * a[column * size + k];
+
+			}
+
+			b[row] -= factor * b[column];
+
+		}
+
+	}
+
+	for (int row = size - 1; row >= 0; row--)
+	{
+
+		for (int k = row + 1; k < size; k++)
+		{
+
+			b[row] -= a[row * size + k] * b[k];
+
+		}
+
+		b[row] /= a[row * size + row];
+
+	}
+
+	return true;
+
+}
+
+// Build the rotation matrix for a rotation vector, whose direction is the axis and whose length is the angle
+static void GetRotation(const double vector[3], double rotation[3][3])
+{
+
+	double angle = sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+
+	// Rodrigues' formula, I + a * K + b * K^2 where K is the cross product matrix of the vector, using the series for tiny angles
+	double a = angle > 1.0e-8 ? sin(angle) / angle : 1.0;
+	double b = angle > 1.0e-8 ? (1.0 - cos(angle)) / (angle * angle) : 0.5;
+
+	double cross[3][3] =
+	{
+		{ 0.0, -vector[2], vector[1] },
+		{ vector[2], 0.0, -vector[0] },
+		{ -vector[1], vector[0], 0.0 }
+	};
+
+	for (int row = 0; row < 3; row++)
+	{
+
+		for (int column = 0; column < 3; column++)
+		{
+
+			double cross_squared = 0.0;
+			for (int k = 0; k < 3; k++)
+			{
+
+				cross_squared += cross[row][k] * cross[k][column];
+
+			}
+
+			rotation[row][column] = (row == column ? 1.0 : 0.0) + a * cross[row][column] + b * cross_squared;
+
+		}
+
+	}
+
+}
+
+// Get a sample's position in camera space, and its position rotated into camera space but not yet translated
+static void GetCameraPosition(const BoardView& view, const CalibrationSample& sample, double rotated[3], double position[3])
+{
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		rotated[axis] = view.rotation[axis][0] * sample.board[0] + view.rotation[axis][1] * sample.board[1];
+		position[axis] = rotated[axis] + view.translation[axis];
+
+	}
+
+}
+
+// Project a camera space point with a set of intrinsics, optionally filling in the derivatives of the pixel
+// with respect to the intrinsics and to the point
+// Returns false if the point is behind the camera
+static bool Project(const double parameters[NUM_CALIBRATION_PARAMETERS], const double position[3], double pixel[2],
+	double jacobian[2][NUM_CALIBRATION_PARAMETERS], double position_jacobian[2][3])
+{
+
+	double depth = position[2];
+	if (depth <= 0.0)
+	{
+
+		return false;
+
+	}
+
+	// Normalised image coordinates
+	double x = position[0] / depth;
+	double y = position[1] / depth;
+
+	double focal_x = parameters[0];
+	double focal_y = parameters[1];
+	double k1 = parameters[4];
+	double k2 = parameters[5];
+	double p1 = parameters[6];
+	double p2 = parameters[7];
+	double k3 = parameters[8];
+
+	double r2 = x * x + y * y;
+	double r4 = r2 * r2;
+	double r6 = r4 * r2;
+	double radial = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+	double distorted_x = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+	double distorted_y = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+
+	pixel[0] = focal_x * distorted_x + parameters[2];
+	pixel[1] = focal_y * distorted_y + parameters[3];
+
+	if (jacobian)
+	{
+
+		jacobian[0][0] = distorted_x;
+		jacobian[0][1] = 0.0;
+		jacobian[0][2] = 1.0;
+		jacobian[0][3] = 0.0;
+		jacobian[0][4] = focal_x * x * r2;
+		jacobian[0][5] = focal_x * x * r4;
+		jacobian[0][6] = focal_x * 2.0 * x * y;
+		jacobian[0][7] = focal_x * (r2 + 2.0 * x * x);
+		jacobian[0][8] = focal_x * x * r6;
+
+		jacobian[1][0] = 0.0;
+		jacobian[1][1] = distorted_y;
+		jacobian[1][2] = 0.0;
+		jacobian[1][3] = 1.0;
+		jacobian[1][4] = focal_y * y * r2;
+		jacobian[1][5] = focal_y * y * r4;
+		jacobian[1][6] = focal_y * (r2 + 2.0 * y * y);
+		jacobian[1][7] = focal_y * 2.0 * x * y;
+		jacobian[1][8] = focal_y * y * r6;
+
+	}
+
+	if (position_jacobian)
+	{
+
+		// Derivatives of the distorted coordinates with respect to the normalised ones
+		double radial_slope = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+		double dx_dx = radial + 2.0 * x * x * radial_slope + 2.0 * p1 * y + 6.0 * p2 * x;
+		double dx_dy = 2.0 * x * y * radial_slope + 2.0 * p1 * x + 2.0 * p2 * y;
+		double dy_dx = dx_dy;
+		double dy_dy = radial + 2.0 * y * y * radial_slope + 6.0 * p1 * y + 2.0 * p2 * x;
+
+		// Then chain them with the perspective divide
+		position_jacobian[0][0] = focal_x * dx_dx / depth;
+		position_jacobian[0][1] = focal_x * dx_dy / depth;
+		position_jacobian[0][2] = -focal_x * (dx_dx * x + dx_dy * y) / depth;
+
+		position_jacobian[1][0] = focal_y * dy_dx / depth;
+		position_jacobian[1][1] = focal_y * dy_dy / depth;
+		position_jacobian[1][2] = -focal_y * (dy_dx * x + dy_dy * y) / depth;
+
+	}
+
+	return true;
+
+}
+
+// Get the RMS reprojection error of the samples in front of the camera with a set of intrinsics and board poses
+static double GetRMSError(const double parameters[NUM_CALIBRATION_PARAMETERS], const std::vector<BoardView>& views, const std::vector<CalibrationSample>& samples)
+{
+
+	double sum = 0.0;
+	int count = 0;
+
+	for (std::vector<BoardView>::const_iterator view = views.begin(); view != views.end(); ++view)
+	{
+
+		for (size_t sample = view->first_sample; sample < view->last_sample; sample++)
+		{
+
+			double rotated[3];
+			double position[3];
+			double pixel[2];
+			GetCameraPosition(*view, samples[sample], rotated, position);
+
+			if (Project(parameters, position, pixel, NULL, NULL))
+			{
+
+				double error_x = pixel[0] - samples[sample].pixel[0];
+				double error_y = pixel[1] - samples[sample].pixel[1];
+				sum += error_x * error_x + error_y * error_y;
+				count++;
+
+			}
+
+		}
+
+	}
+
+	return count > 0 ? sqrt(sum / count) : 0.0;
+
+}
+
+// Solve the pose of the board in a frame from the homography between the board and the image, as in Zhang's method
+// The homography is fitted to the image with the current intrinsics taken out, so it's the board pose up to scale
+// Lens distortion is ignored here, as the poses are only a starting point for the joint refinement
+static bool SolveBoardPose(const double parameters[NUM_CALIBRATION_PARAMETERS], const std::vector<CalibrationSample>& samples, BoardView& view)
+{
+
+	std::vector<double> normal(NUM_HOMOGRAPHY_PARAMETERS * NUM_HOMOGRAPHY_PARAMETERS, 0.0);
+	std::vector<double> homography(NUM_HOMOGRAPHY_PARAMETERS, 0.0);
+
+	// Each sample gives two linear equations in the homography's elements, solved by least squares
+	for (size_t sample = view.first_sample; sample < view.last_sample; sample++)
+	{
+
+		double board_x = samples[sample].board[0];
+		double board_y = samples[sample].board[1];
+		double image[2] =
+		{
+			(samples[sample].pixel[0] - parameters[2]) / parameters[0],
+			(samples[sample].pixel[1] - parameters[3]) / parameters[1]
+		};
+
+		for (int axis = 0; axis < 2; axis++)
+		{
+
+			double row[NUM_HOMOGRAPHY_PARAMETERS];
+			memset(row, 0, sizeof(row));
+			row[axis * 3 + 0] = board_x;
+			row[axis * 3 + 1] = board_y;
+			row[axis * 3 + 2] = 1.0;
+			row[6] = -image[axis] * board_x;
+			row[7] = -image[axis] * board_y;
+
+			for (int i = 0; i < NUM_HOMOGRAPHY_PARAMETERS; i++)
+			{
+
+				homography[i] += row[i] * image[axis];
+
+				for (int j = 0; j < NUM_HOMOGRAPHY_PARAMETERS; j++)
+				{
+
+					normal[i * NUM_HOMOGRAPHY_PARAMETERS + j] += row[i] * row[j];
+
+				}
+
+			}
+
+		}
+
+	}
+
+	if (!Solve(normal, homography, NUM_HOMOGRAPHY_PARAMETERS))
+	{
+
+		return false;
+
+	}
+
+	// The homography's columns are the board's x and y axes and its origin in camera space, all scaled by the same amount
+	double axis_x[3] = { homography[0], homography[3], homography[6] };
+	double axis_y[3] = { homography[1], homography[4], homography[7] };
+	double origin[3] = { homography[2], homography[5], 1.0 };
+
+	double length_x = sqrt(axis_x[0] * axis_x[0] + axis_x[1] * axis_x[1] + axis_x[2] * axis_x[2]);
+	double length_y = sqrt(axis_y[0] * axis_y[0] + axis_y[1] * axis_y[1] + axis_y[2] * axis_y[2]);
+	if (!(length_x > 1.0e-12) || !(length_y > 1.0e-12))
+	{
+
+		return false;
+
+	}
+
+	// The origin is in front of the camera, since its homogeneous coordinate is 1
+	double scale = 2.0 / (length_x + length_y);
+
+	// The axes won't be quite orthonormal because of noise, so straighten them up
+	double dot = 0.0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		axis_x[axis] /= length_x;
+		dot += axis_x[axis] * axis_y[axis];
+
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		axis_y[axis] -= dot * axis_x[axis];
+
+	}
+
+	length_y = sqrt(axis_y[0] * axis_y[0] + axis_y[1] * axis_y[1] + axis_y[2] * axis_y[2]);
+	if (!(length_y > 1.0e-12))
+	{
+
+		return false;
+
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		axis_y[axis] /= length_y;
+
+	}
+
+	double axis_z[3] =
+	{
+		axis_x[1] * axis_y[2] - axis_x[2] * axis_y[1],
+		axis_x[2] * axis_y[0] - axis_x[0] * axis_y[2],
+		axis_x[0] * axis_y[1] - axis_x[1] * axis_y[0]
+	};
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		view.rotation[axis][0] = axis_x[axis];
+		view.rotation[axis][1] = axis_y[axis];
+		view.rotation[axis][2] = axis_z[axis];
+		view.translation[axis] = origin[axis] * scale;
+
+	}
+
+	return true;
+
+}
+
+// Apply a step of the joint fit to the intrinsics and every board pose
+static void ApplyStep(const std::vector<double>& step, double parameters[NUM_CALIBRATION_PARAMETERS], std::vector<BoardView>& views)
+{
+
+	for (int parameter = 0; parameter < NUM_CALIBRATION_PARAMETERS; parameter++)
+	{
+
+		parameters[parameter] += step[parameter];
+
+	}
+
+	for (size_t view = 0; view < views.size(); view++)
+	{
+
+		const double* pose_step = &step[NUM_CALIBRATION_PARAMETERS + view * NUM_POSE_PARAMETERS];
+
+		// The rotation is stepped by composing a small rotation in camera space onto it
+		double step_rotation[3][3];
+		double rotation[3][3];
+		GetRotation(pose_step, step_rotation);
+		memcpy(rotation, views[view].rotation, sizeof(rotation));
+
+		for (int row = 0; row < 3; row++)
+		{
+
+			for (int column = 0; column < 3; column++)
+			{
+
+				views[view].rotation[row][column] = step_rotation[row][0] * rotation[0][column] + step_rotation[row][1] * rotation[1][column] + step_rotation[row][2] * rotation[2][column];
+
+			}
+
+			views[view].translation[row] += pose_step[3 + row];
+
+		}
+
+	}
+
+}
+
+CameraCalibration::CameraCalibration() :
+	map_width_(0),
+	map_height_(0)
+{
+
+	SetDefault(1.0f, 640, 480);
+
+}
+
+CameraCalibration::~CameraCalibration()
+{
+
+
+
+}
+
+void CameraCalibration::SetDefault(float fov, int width, int height)
+{
+
+	width_ = width;
+	height_ = height;
+
+	// The field of view is vertical, as it is for PerspectiveFovGL, and pixels are square
+	nominal_focal_ = (height * 0.5f) / tanf(fov * 0.5f);
+	focal_x_ = nominal_focal_;
+	focal_y_ = nominal_focal_;
+	centre_x_ = width * 0.5f;
+	centre_y_ = height * 0.5f;
+
+	k1_ = 0.0f;
+	k2_ = 0.0f;
+	k3_ = 0.0f;
+	p1_ = 0.0f;
+	p2_ = 0.0f;
+
+	is_calibrated_ = false;
+	undistortion_map_.clear();
+
+}
+
+bool CameraCalibration::Load(const char* file_name)
+{
+
+	std::string text;
+	if (!LevelDefinition::ReadFile(file_name, text))
+	{
+
+		return false;
+
+	}
+
+	float intrinsics[4];
+	float distortion[5];
+	bool has_intrinsics = false;
+	bool has_distortion = false;
+
+	size_t line_start = 0;
+	while (line_start < text.size())
+	{
+
+		size_t line_end = text.find('\n', line_start);
+		if (line_end == std::string::npos)
+		{
+
+			line_end = text.size();
+
+		}
+
+		std::string line = text.substr(line_start, line_end - line_start);
+		line_start = line_end + 1;
+
+		char keyword[32];
+		if (sscanf(line.c_str(), "%31s", keyword) != 1 || keyword[0] == '#')
+		{
+
+			continue;
+
+		}
+
+		if (strcmp(keyword, "intrinsics") == 0)
+		{
+
+			has_intrinsics = sscanf(line.c_str(), "%*s %f %f %f %f", &intrinsics[0], &intrinsics[1], &intrinsics[2], &intrinsics[3]) == 4;
+
+		}
+		else if (strcmp(keyword, "distortion") == 0)
+		{
+
+			has_distortion = sscanf(line.c_str(), "%*s %f %f %f %f %f", &distortion[0], &distortion[1], &distortion[2], &distortion[3], &distortion[4]) == 5;
+
+		}
+
+	}
+
+	// A calibration is only any use if it's complete and has sensible focal lengths
+	if (!has_intrinsics || !has_distortion || !(intrinsics[0] > 0.0f) || !(intrinsics[1] > 0.0f))
+	{
+
+		return false;
+
+	}
+
+	focal_x_ = intrinsics[0];
+	focal_y_ = intrinsics[1];
+	centre_x_ = intrinsics[2];
+	centre_y_ = intrinsics[3];
+	k1_ = distortion[0];
+	k2_ = distortion[1];
+	p1_ = distortion[2];
+	p2_ = distortion[3];
+	k3_ = distortion[4];
+
+	is_calibrated_ = true;
+	undistortion_map_.clear();
+
+	return true;
+
+}
+
+bool CameraCalibration::Save(const char* file_name) const
+{
+
+	// Make sure the folder exists, it's fine if it already does
+	sceIoMkdir(LEVEL_DEFINITION_PATH, 0777);
+
+	FILE* file = fopen(file_name, "w");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	fprintf(file, "# Shape Matcher camera calibration for a %i x %i image\n", width_, height_);
+	fprintf(file, "# intrinsics focal_x focal_y centre_x centre_y\n");
+	fprintf(file, "intrinsics %f %f %f %f\n", focal_x_, focal_y_, centre_x_, centre_y_);
+	fprintf(file, "# distortion k1 k2 p1 p2 k3\n");
+	fprintf(file, "distortion %f %f %f %f %f\n", k1_, k2_, p1_, p2_, k3_);
+
+	fclose(file);
+
+	return true;
+
+}
+
+bool CameraCalibration::ReadSamples(const char* file_name, std::vector<CalibrationSample>& samples)
+{
+
+	std::string text;
+	if (!LevelDefinition::ReadFile(file_name, text))
+	{
+
+		return false;
+
+	}
+
+	samples.clear();
+
+	size_t line_start = 0;
+	while (line_start < text.size())
+	{
+
+		size_t line_end = text.find('\n', line_start);
+		if (line_end == std::string::npos)
+		{
+
+			line_end = text.size();
+
+		}
+
+		std::string line = text.substr(line_start, line_end - line_start);
+		line_start = line_end + 1;
+
+		// Each sample is the frame a board corner was seen in, its position on the board, and the pixel it was seen at
+		CalibrationSample sample;
+		if (sscanf(line.c_str(), "sample %i %f %f %f %f", &sample.frame, &sample.board[0], &sample.board[1], &sample.pixel[0], &sample.pixel[1]) == 5)
+		{
+
+			samples.push_back(sample);
+
+		}
+
+	}
+
+	return !samples.empty();
+
+}
+
+bool CameraCalibration::Fit(const std::vector<CalibrationSample>& samples, float& rms_error)
+{
+
+	double parameters[NUM_CALIBRATION_PARAMETERS] = { focal_x_, focal_y_, centre_x_, centre_y_, k1_, k2_, p1_, p2_, k3_ };
+
+	// Split the samples into frames, and solve the board's pose in each frame that has enough corners
+	std::vector<BoardView> views;
+	size_t num_samples = 0;
+	size_t first_sample = 0;
+
+	while (first_sample < samples.size())
+	{
+
+		BoardView view;
+		view.first_sample = first_sample;
+		view.last_sample = first_sample + 1;
+		while (view.last_sample < samples.size() && samples[view.last_sample].frame == samples[first_sample].frame)
+		{
+
+			view.last_sample++;
+
+		}
+
+		first_sample = view.last_sample;
+
+		if ((int)(view.last_sample - view.first_sample) >= MIN_FRAME_SAMPLES && SolveBoardPose(parameters, samples, view))
+		{
+
+			views.push_back(view);
+			num_samples += view.last_sample - view.first_sample;
+
+		}
+
+	}
+
+	if ((int)views.size() < MIN_CALIBRATION_FRAMES || (int)num_samples < MIN_CALIBRATION_SAMPLES)
+	{
+
+		return false;
+
+	}
+
+	// The intrinsics come first, then each board pose
+	int size = NUM_CALIBRATION_PARAMETERS + (int)views.size() * NUM_POSE_PARAMETERS;
+	std::vector<double> normal(size * size);
+	std::vector<double> gradient(size);
+
+	double error = GetRMSError(parameters, views, samples);
+
+	// Levenberg-Marquardt over the intrinsics and the board poses together,
+	// damping the Gauss-Newton steps more whenever one makes the fit worse
+	double damping = 1.0e-3;
+
+	for (int iteration = 0; iteration < CALIBRATION_FIT_ITERATIONS; iteration++)
+	{
+
+		std::fill(normal.begin(), normal.end(), 0.0);
+		std::fill(gradient.begin(), gradient.end(), 0.0);
+
+		// Accumulate J^T J and J^T r over both pixel coordinates of every sample
+		for (size_t view = 0; view < views.size(); view++)
+		{
+
+			int pose_parameter = NUM_CALIBRATION_PARAMETERS + (int)view * NUM_POSE_PARAMETERS;
+
+			for (size_t sample = views[view].first_sample; sample < views[view].last_sample; sample++)
+			{
+
+				double rotated[3];
+				double position[3];
+				double pixel[2];
+				double jacobian[2][NUM_CALIBRATION_PARAMETERS];
+				double position_jacobian[2][3];
+				GetCameraPosition(views[view], samples[sample], rotated, position);
+
+				if (!Project(parameters, position, pixel, jacobian, position_jacobian))
+				{
+
+					continue;
+
+				}
+
+				for (int axis = 0; axis < 2; axis++)
+				{
+
+					// Each pixel coordinate only depends on the intrinsics and its own frame's pose
+					int indices[NUM_CALIBRATION_PARAMETERS + NUM_POSE_PARAMETERS];
+					double derivatives[NUM_CALIBRATION_PARAMETERS + NUM_POSE_PARAMETERS];
+
+					for (int parameter = 0; parameter < NUM_CALIBRATION_PARAMETERS; parameter++)
+					{
+
+						indices[parameter] = parameter;
+						derivatives[parameter] = jacobian[axis][parameter];
+
+					}
+
+					// A small rotation about each camera axis moves the point by that axis crossed with it
+					const double* moved = position_jacobian[axis];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 0] = moved[2] * rotated[1] - moved[1] * rotated[2];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 1] = moved[0] * rotated[2] - moved[2] * rotated[0];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 2] = moved[1] * rotated[0] - moved[0] * rotated[1];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 3] = moved[0];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 4] = moved[1];
+					derivatives[NUM_CALIBRATION_PARAMETERS + 5] = moved[2];
+
+					for (int parameter = 0; parameter < NUM_POSE_PARAMETERS; parameter++)
+					{
+
+						indices[NUM_CALIBRATION_PARAMETERS + parameter] = pose_parameter + parameter;
+
+					}
+
+					double residual = samples[sample].pixel[axis] - pixel[axis];
+
+					for (int row = 0; row < NUM_CALIBRATION_PARAMETERS + NUM_POSE_PARAMETERS; row++)
+					{
+
+						gradient[indices[row]] += derivatives[row] * residual;
+
+						for (int column = 0; column < NUM_CALIBRATION_PARAMETERS + NUM_POSE_PARAMETERS; column++)
+						{
+
+							normal[indices[row] * size + indices[column]] += derivatives[row] * derivatives[column];
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+
+		for (int row = 0; row < size; row++)
+		{
+
+			normal[row * size + row] *= 1.0 + damping;
+
+		}
+
+		if (!Solve(normal, gradient, size))
+		{
+
+			return false;
+
+		}
+
+		double trial[NUM_CALIBRATION_PARAMETERS];
+		std::vector<BoardView> trial_views = views;
+		memcpy(trial, parameters, sizeof(trial));
+		ApplyStep(gradient, trial, trial_views);
+
+		double trial_error = GetRMSError(trial, trial_views, samples);
+		if (trial_error < error)
+		{
+
+			memcpy(parameters, trial, sizeof(parameters));
+			views.swap(trial_views);
+			error = trial_error;
+			damping *= 0.1;
+
+		}
+		else
+		{
+
+			damping *= 10.0;
+
+		}
+
+	}
+
+	if (!(error <= max_rms_error) || !(parameters[0] > 0.0) || !(parameters[1] > 0.0))
+	{
+
+		return false;
+
+	}
+
+	focal_x_ = (float)parameters[0];
+	focal_y_ = (float)parameters[1];
+	centre_x_ = (float)parameters[2];
+	centre_y_ = (float)parameters[3];
+	k1_ = (float)parameters[4];
+	k2_ = (float)parameters[5];
+	p1_ = (float)parameters[6];
+	p2_ = (float)parameters[7];
+	k3_ = (float)parameters[8];
+
+	is_calibrated_ = true;
+	undistortion_map_.clear();
+	rms_error = (float)error;
+
+	return true;
+
+}
+
+void CameraCalibration::BuildUndistortionMap()
+{
+
+	// Cover the whole image, including its far edges
+	map_width_ = (width_ + UNDISTORTION_MAP_STEP - 1) / UNDISTORTION_MAP_STEP + 1;
+	map_height_ = (height_ + UNDISTORTION_MAP_STEP - 1) / UNDISTORTION_MAP_STEP + 1;
+	undistortion_map_.resize(map_width_ * map_height_ * 2);
+
+	for (int map_y = 0; map_y < map_height_; map_y++)
+	{
+
+		for (int map_x = 0; map_x < map_width_; map_x++)
+		{
+
+			float distorted_x = (map_x * UNDISTORTION_MAP_STEP - centre_x_) / focal_x_;
+			float distorted_y = (map_y * UNDISTORTION_MAP_STEP - centre_y_) / focal_y_;
+
+			// There's no closed form inverse, so refine by fixed point iteration starting from the distorted point
+			float x = distorted_x;
+			float y = distorted_y;
+			for (int iteration = 0; iteration < undistort_iterations; iteration++)
+			{
+
+				float redistorted_x;
+				float redistorted_y;
+				Distort(x, y, redistorted_x, redistorted_y);
+
+				x += distorted_x - redistorted_x;
+				y += distorted_y - redistorted_y;
+
+			}
+
+			float* entry = &undistortion_map_[(map_y * map_width_ + map_x) * 2];
+			entry[0] = x;
+			entry[1] = y;
+
+		}
+
+	}
+
+}
+
+void CameraCalibration::Undistort(float pixel_x, float pixel_y, float& x, float& y) const
+{
+
+	if (undistortion_map_.empty())
+	{
+
+		x = (pixel_x - centre_x_) / focal_x_;
+		y = (pixel_y - centre_y_) / focal_y_;
+		return;
+
+	}
+
+	// Clamp to the map, then interpolate between the four surrounding entries
+	float map_x = pixel_x / UNDISTORTION_MAP_STEP;
+	float map_y = pixel_y / UNDISTORTION_MAP_STEP;
+	map_x = map_x < 0.0f ? 0.0f : (map_x > map_width_ - 1.001f ? map_width_ - 1.001f : map_x);
+	map_y = map_y < 0.0f ? 0.0f : (map_y > map_height_ - 1.001f ? map_height_ - 1.001f : map_y);
+
+	int cell_x = (int)map_x;
+	int cell_y = (int)map_y;
+	float blend_x = map_x - cell_x;
+	float blend_y = map_y - cell_y;
+
+	const float* top = &undistortion_map_[(cell_y * map_width_ + cell_x) * 2];
+	const float* bottom = top + map_width_ * 2;
+
+	x = (top[0] * (1.0f - blend_x) + top[2] * blend_x) * (1.0f - blend_y) + (bottom[0] * (1.0f - blend_x) + bottom[2] * blend_x) * blend_y;
+	y = (top[1] * (1.0f - blend_x) + top[3] * blend_x) * (1.0f - blend_y) + (bottom[1] * (1.0f - blend_x) + bottom[3] * blend_x) * blend_y;
+
+}
+
+void CameraCalibration::CorrectTransform(gef::Matrix44& transform) const
+{
+
+	gef::Vector4 translation = transform.GetTranslation();
+	float depth = -translation.z();
+
+	// Without a calibration the tracking library's pinhole camera is already the best we have
+	if (!is_calibrated_ || depth <= 0.0f)
+	{
+
+		return;
+
+	}
+
+	// Work out the pixel the tracking library saw the marker at with its pinhole camera
+	float pixel_x = nominal_focal_ * translation.x() / depth + width_ * 0.5f;
+	float pixel_y = height_ * 0.5f - nominal_focal_ * translation.y() / depth;
+
+	float x;
+	float y;
+	Undistort(pixel_x, pixel_y, x, y);
+
+	// The marker really lies on the true ray through that pixel, and was seen from the same angle along it as along the pinhole ray,
+	// so swing the whole transform, orientation included, about the camera from one ray onto the other
+	gef::Vector4 pinhole_ray(translation.x(), translation.y(), translation.z());
+	gef::Vector4 true_ray(x, -y, -1.0f);
+	pinhole_ray.Normalise();
+	true_ray.Normalise();
+
+	gef::Vector4 axis = pinhole_ray.CrossProduct(true_ray);
+	float sine = axis.Length();
+	float cosine = pinhole_ray.DotProduct(true_ray);
+	if (sine < 1.0e-7f)
+	{
+
+		return;
+
+	}
+
+	axis.Normalise();
+
+	// Rodrigues' formula, laid out for GEF's row vectors
+	float a[3] = { axis.x(), axis.y(), axis.z() };
+	float cross[3][3] =
+	{
+		{ 0.0f, -a[2], a[1] },
+		{ a[2], 0.0f, -a[0] },
+		{ -a[1], a[0], 0.0f }
+	};
+
+	gef::Matrix44 correction;
+	correction.SetIdentity();
+	for (int row = 0; row < 3; row++)
+	{
+
+		for (int column = 0; column < 3; column++)
+		{
+
+			float rotation = (row == column ? cosine : 0.0f) + sine * cross[row][column] + (1.0f - cosine) * a[row] * a[column];
+			correction.set_m(column, row, rotation);
+
+		}
+
+	}
+
+	transform = transform * correction;
+
+}
+
+void CameraCalibration::Distort(float x, float y, float& distorted_x, float& distorted_y) const
+{
+
+	float r2 = x * x + y * y;
+	float radial = 1.0f + r2 * (k1_ + r2 * (k2_ + r2 * k3_));
+
+	distorted_x = x * radial + 2.0f * p1_ * x * y + p2_ * (r2 + 2.0f * x * x);
+	distorted_y = y * radial + p1_ * (r2 + 2.0f * y * y) + 2.0f * p2_ * x * y;
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef CAMERA_CALIBRATION_H
+#define CAMERA_CALIBRATION_H
+
+#include <vector>
+#include <maths/matrix44.h>
+#include "level_definition.h"
+
+// File the fitted calibration is saved to and loaded from
+#define CAMERA_CALIBRATION_FILE LEVEL_DEFINITION_PATH "camera_calibration.txt"
+// File of recorded calibration samples, which are fitted if there's no calibration file yet
+#define CAMERA_CALIBRATION_SAMPLES_FILE LEVEL_DEFINITION_PATH "calibration_samples.txt"
+
+// Number of pixels between points in the undistortion map
+#define UNDISTORTION_MAP_STEP 16
+// Fewest samples a fit will be attempted with, since the model has nine parameters
+#define MIN_CALIBRATION_SAMPLES 20
+// Fewest board frames a fit will be attempted with, since the focal lengths can't be told apart from the board's distance in fewer
+#define MIN_CALIBRATION_FRAMES 3
+// Fewest corners a frame needs for the board's pose in it to be solved from a homography
+#define MIN_FRAME_SAMPLES 4
+// Number of Levenberg-Marquardt iterations used when fitting
+#define CALIBRATION_FIT_ITERATIONS 30
+
+// A corner of the calibration board, e.g. a checkerboard, seen in a recorded frame
+// These are what a corner detector gives, so the board's pose in each frame doesn't need to be known
+struct CalibrationSample
+{
+
+	// Frame the corner was seen in, with each frame's samples listed together
+	int frame;
+	// Position on the board, which lies in its own z = 0 plane
+	float board[2];
+	// Pixel the corner was seen at in the camera image
+	float pixel[2];
+
+};
+
+// Camera calibration class
+// Holds the camera's intrinsics and its radial and tangential (Brown-Conrady) lens distortion
+// The tracking library assumes an ideal pinhole camera with the nominal field of view, so marker transforms it reports
+// are corrected by looking up the true ray for the pixel the marker was seen at in a precomputed undistortion map
+// Only the transforms used for matching are corrected, since the camera image is drawn as it was captured, distortion and all
+class CameraCalibration
+{
+
+public:
+
+	CameraCalibration();
+	~CameraCalibration();
+
+	// Set up the pinhole camera the tracking library assumes, with no distortion
+	void SetDefault(float fov, int width, int height);
+
+	// Load or save the calibration, in the same plain text format as the level files
+	bool Load(const char* file_name);
+	bool Save(const char* file_name) const;
+
+	// Read the samples recorded for fitting
+	static bool ReadSamples(const char* file_name, std::vector<CalibrationSample>& samples);
+
+	// Fit the intrinsics and distortion to recorded samples by least squares, starting from the current values
+	// The board's pose in each frame is solved from its homography as in Zhang's method, then refined along with the calibration
+	// Returns false, leaving the calibration untouched, if there aren't enough samples or the fit doesn't converge
+	bool Fit(const std::vector<CalibrationSample>& samples, float& rms_error);
+
+	// Build the map from pixels to undistorted camera rays, which must be done before Undistort or CorrectTransform
+	void BuildUndistortionMap();
+
+	// Get the undistorted normalised image coordinates for a pixel from the map
+	void Undistort(float pixel_x, float pixel_y, float& x, float& y) const;
+
+	// Rotate a transform reported by the tracking library about the camera onto the true ray through the pixel it was seen at
+	void CorrectTransform(gef::Matrix44& transform) const;
+
+	inline bool IsCalibrated() const { return is_calibrated_; };
+
+private:
+
+	// Distort undistorted normalised image coordinates
+	void Distort(float x, float y, float& distorted_x, float& distorted_y) const;
+
+	// Intrinsics, in pixels
+	float focal_x_;
+	float focal_y_;
+	float centre_x_;
+	float centre_y_;
+
+	// Radial and tangential distortion coefficients
+	float k1_;
+	float k2_;
+	float k3_;
+	float p1_;
+	float p2_;
+
+	// Focal length of the pinhole camera the tracking library assumes
+	float nominal_focal_;
+
+	int width_;
+	int height_;
+
+	// Undistorted normalised coordinates at every UNDISTORTION_MAP_STEP pixels, as x, y pairs
+	std::vector<float> undistortion_map_;
+	int map_width_;
+	int map_height_;
+
+	bool is_calibrated_;
+
+};
+
+#endif // !CAMERA_CALIBRATION_H
\ No newline at end of file
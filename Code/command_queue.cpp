@@ -0,0 +1,52 @@
+#include "command_queue.h"
+
+CommandQueue::CommandQueue() :
+	read_index_(0),
+	write_index_(0)
+{
+}
+
+CommandQueue::~CommandQueue()
+{
+
+
+
+}
+
+bool CommandQueue::Push(CommandType type, gef::UInt32 frame, gef::UInt64 timestamp)
+{
+
+	if (write_index_ - read_index_ >= COMMAND_QUEUE_SIZE)
+	{
+
+		return false;
+
+	}
+
+	Command& command = commands_[write_index_ & (COMMAND_QUEUE_SIZE - 1)];
+	command.type = type;
+	command.frame = frame;
+	command.timestamp = timestamp;
+
+	write_index_++;
+
+	return true;
+
+}
+
+bool CommandQueue::Pop(Command& command)
+{
+
+	if (IsEmpty())
+	{
+
+		return false;
+
+	}
+
+	command = commands_[read_index_ & (COMMAND_QUEUE_SIZE - 1)];
+	read_index_++;
+
+	return true;
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <gef.h>
+
+// Number of commands the queue can hold, must be a power of two
+#define COMMAND_QUEUE_SIZE 32
+
+// Enumerated type for the commands the player can issue
+enum CommandType
+{
+
+	COMMAND_CHECK_CONFIGURATION,	// Check if the configuration is correct on normal difficulty
+	COMMAND_CONFIRM,				// Move on from the win screen, or hide/show the instructions
+	COMMAND_TOGGLE_DIFFICULTY,		// Switch between easy and normal difficulty
+	COMMAND_RESET,					// Reset the game
+	COMMAND_SWITCH_LEVEL,			// Switch to the other level
+	COMMAND_TOGGLE_TRANSFORMS,		// Show/hide the transform debug text
+	COMMAND_CAPTURE_REFERENCE,		// Record the current configuration as the level's solution
+	COMMAND_STRESS_BENCHMARK,		// Start or stop the stress benchmark
+	COMMAND_TOGGLE_REWIND,			// Start or stop looking back through the pose history
+	COMMAND_REWIND_BACK,			// Look at an earlier frame of the pose history
+	COMMAND_REWIND_FORWARD			// Look at a later frame of the pose history
+
+};
+
+// A command along with when it was issued
+struct Command
+{
+
+	CommandType type;
+	// Frame the input was read on
+	gef::UInt32 frame;
+	// Time the input was read, in microseconds
+	gef::UInt64 timestamp;
+
+};
+
+// Command queue class
+// Fixed size ring buffer of commands, so input can be read in one place and acted on in another
+class CommandQueue
+{
+
+public:
+
+	CommandQueue();
+	~CommandQueue();
+
+	// Add a command to the back of the queue, returning false if the queue is full
+	bool Push(CommandType type, gef::UInt32 frame, gef::UInt64 timestamp);
+	// Take the command from the front of the queue, returning false if the queue is empty
+	bool Pop(Command& command);
+
+	inline bool IsEmpty() { return read_index_ == write_index_; };
+
+private:
+
+	Command commands_[COMMAND_QUEUE_SIZE];
+
+	// The indices only ever increase and are wrapped when used, so full and empty can be told apart
+	gef::UInt32 read_index_;
+	gef::UInt32 write_index_;
+
+};
+
+#endif // !COMMAND_QUEUE_H
\ No newline at end of file
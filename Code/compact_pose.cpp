@@ -0,0 +1,284 @@
+#include "compact_pose.h"
+#include "pose_maths.h"
+#include <stdio.h>
+#include <math.h>
+#include <maths/matrix44.h>
+
+// Identifies a compact pose file, and the version of its layout
+static const gef::UInt32 pose_file_magic = 0x46504d53; // "SMPF"
+static const gef::UInt32 pose_file_version = 1;
+
+// Header at the start of a compact pose file
+struct PoseFileHeader
+{
+
+	gef::UInt32 magic;
+	gef::UInt32 version;
+	gef::UInt32 count;
+
+};
+
+// The smallest three quaternion components always lie within +/- 1 / sqrt(2)
+static const float rotation_component_range = 0.70710678f;
+
+// Quantise a value in the range +/- range to a signed 16 bit integer
+static gef::Int16 QuantiseSigned(float value, float range)
+{
+
+	float scaled = value / range * 32767.0f;
+
+	if (scaled > 32767.0f)
+	{
+
+		scaled = 32767.0f;
+
+	}
+	else if (scaled < -32767.0f)
+	{
+
+		scaled = -32767.0f;
+
+	}
+
+	return (gef::Int16)floorf(scaled + 0.5f);
+
+}
+
+// Quantise a value in the range min to max to an unsigned integer with the given maximum
+static gef::UInt32 QuantiseUnsigned(float value, float min, float max, float steps)
+{
+
+	float scaled = (value - min) / (max - min) * steps;
+
+	if (scaled > steps)
+	{
+
+		scaled = steps;
+
+	}
+	else if (scaled < 0.0f)
+	{
+
+		scaled = 0.0f;
+
+	}
+
+	return (gef::UInt32)floorf(scaled + 0.5f);
+
+}
+
+void PoseCodec::Encode(const gef::Matrix44& transform, CompactPose& pose)
+{
+
+	gef::Vector4 translation;
+	gef::Quaternion rotation;
+	float scale;
+
+	PoseMaths::Decompose(transform, translation, rotation, scale);
+
+	pose.translation[0] = QuantiseSigned(translation.x(), COMPACT_POSE_TRANSLATION_RANGE);
+	pose.translation[1] = QuantiseSigned(translation.y(), COMPACT_POSE_TRANSLATION_RANGE);
+	pose.translation[2] = QuantiseSigned(translation.z(), COMPACT_POSE_TRANSLATION_RANGE);
+
+	// Find the largest quaternion component, that's the one we drop
+	float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+	int largest = 0;
+	for (int component = 1; component < 4; component++)
+	{
+
+		if (fabsf(components[component]) > fabsf(components[largest]))
+		{
+
+			largest = component;
+
+		}
+
+	}
+
+	// q and -q are the same rotation, so flip the sign to make the dropped component positive
+	float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+	int stored = 0;
+	for (int component = 0; component < 4; component++)
+	{
+
+		if (component != largest)
+		{
+
+			pose.rotation[stored] = (gef::UInt16)QuantiseUnsigned(components[component] * sign, -rotation_component_range, rotation_component_range, 65535.0f);
+			stored++;
+
+		}
+
+	}
+
+	pose.largest_component = (gef::UInt8)largest;
+
+	float log_scale = scale > 0.0f ? logf(scale) / logf(2.0f) : COMPACT_POSE_MIN_LOG_SCALE;
+	pose.log_scale = (gef::UInt8)QuantiseUnsigned(log_scale, COMPACT_POSE_MIN_LOG_SCALE, COMPACT_POSE_MAX_LOG_SCALE, 255.0f);
+
+}
+
+void PoseCodec::Decode(const CompactPose& pose, gef::Matrix44& transform)
+{
+
+	gef::Vector4 translation = gef::Vector4(
+		pose.translation[0] * (COMPACT_POSE_TRANSLATION_RANGE / 32767.0f),
+		pose.translation[1] * (COMPACT_POSE_TRANSLATION_RANGE / 32767.0f),
+		pose.translation[2] * (COMPACT_POSE_TRANSLATION_RANGE / 32767.0f));
+
+	// Rebuild the dropped component from the other three, as the quaternion has unit length
+	int largest = pose.largest_component & 3;
+	float components[4];
+	float sum_squares = 0.0f;
+	int stored = 0;
+	for (int component = 0; component < 4; component++)
+	{
+
+		if (component != largest)
+		{
+
+			components[component] = pose.rotation[stored] * (2.0f * rotation_component_range / 65535.0f) - rotation_component_range;
+			sum_squares += components[component] * components[component];
+			stored++;
+
+		}
+
+	}
+
+	components[largest] = sum_squares < 1.0f ? sqrtf(1.0f - sum_squares) : 0.0f;
+
+	gef::Quaternion rotation;
+	rotation.x = components[0];
+	rotation.y = components[1];
+	rotation.z = components[2];
+	rotation.w = components[3];
+
+	float log_scale = COMPACT_POSE_MIN_LOG_SCALE + pose.log_scale * ((COMPACT_POSE_MAX_LOG_SCALE - COMPACT_POSE_MIN_LOG_SCALE) / 255.0f);
+	float scale = powf(2.0f, log_scale);
+
+	PoseMaths::Compose(translation, rotation, scale, transform);
+
+}
+
+void PoseCodec::EncodePoses(const gef::Matrix44* transforms, CompactPose* poses, int count)
+{
+
+	for (int pose = 0; pose < count; pose++)
+	{
+
+		Encode(transforms[pose], poses[pose]);
+
+	}
+
+}
+
+void PoseCodec::DecodePoses(const CompactPose* poses, gef::Matrix44* transforms, int count)
+{
+
+	for (int pose = 0; pose < count; pose++)
+	{
+
+		Decode(poses[pose], transforms[pose]);
+
+	}
+
+}
+
+bool PoseCodec::WritePoseFile(const char* file_name, const gef::Matrix44* transforms, int count)
+{
+
+	FILE* file = fopen(file_name, "wb");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	PoseFileHeader header;
+	header.magic = pose_file_magic;
+	header.version = pose_file_version;
+	header.count = count;
+
+	std::vector<CompactPose> poses(count);
+	if (count > 0)
+	{
+
+		EncodePoses(transforms, &poses[0], count);
+
+	}
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (success && count > 0)
+	{
+
+		success = fwrite(&poses[0], sizeof(CompactPose), count, file) == (size_t)count;
+
+	}
+
+	fclose(file);
+
+	return success;
+
+}
+
+bool PoseCodec::ReadPoseFile(const char* file_name, std::vector<gef::Matrix44>& transforms)
+{
+
+	FILE* file = fopen(file_name, "rb");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	PoseFileHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != pose_file_magic || header.version != pose_file_version)
+	{
+
+		fclose(file);
+		return false;
+
+	}
+
+	// The count comes from the file, so check the file really holds that many poses before making room for them
+	long poses_start = ftell(file);
+	long file_size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+	if (poses_start < 0 || file_size < poses_start || header.count > (gef::UInt32)(file_size - poses_start) / sizeof(CompactPose)
+		|| fseek(file, poses_start, SEEK_SET) != 0)
+	{
+
+		fclose(file);
+		return false;
+
+	}
+
+	std::vector<CompactPose> poses(header.count);
+	bool success = true;
+	if (header.count > 0)
+	{
+
+		success = fread(&poses[0], sizeof(CompactPose), header.count, file) == header.count;
+
+	}
+
+	fclose(file);
+
+	if (success)
+	{
+
+		transforms.resize(header.count);
+		if (header.count > 0)
+		{
+
+			DecodePoses(&poses[0], &transforms[0], header.count);
+
+		}
+
+	}
+
+	return success;
+
+}
\ No newline at end of file
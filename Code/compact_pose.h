@@ -0,0 +1,59 @@
+#ifndef COMPACT_POSE_H
+#define COMPACT_POSE_H
+
+#include <vector>
+#include <gef.h>
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Matrix44;
+
+}
+
+// Translations are stored in the range +/- this many metres
+#define COMPACT_POSE_TRANSLATION_RANGE 4.0f
+
+// Scales are stored as log2 in this range, which covers the tiny scales used by the levels
+#define COMPACT_POSE_MIN_LOG_SCALE -10.0f
+#define COMPACT_POSE_MAX_LOG_SCALE 2.0f
+
+// A quantised uniformly scaled rigid transform, 14 bytes instead of the 64 of a gef::Matrix44
+struct CompactPose
+{
+
+	// Translation quantised to 16 bits per axis
+	gef::Int16 translation[3];
+	// The three smallest quaternion components, the largest is rebuilt from them
+	gef::UInt16 rotation[3];
+	// Index of the quaternion component that was dropped
+	gef::UInt8 largest_component;
+	// Log2 of the uniform scale quantised to 8 bits
+	gef::UInt8 log_scale;
+
+};
+
+// Pose codec class
+// Converts transforms to and from compact poses, for the stress benchmark's pose traces and pose history dumps
+class PoseCodec
+{
+
+public:
+
+	// Encode and decode a single transform
+	static void Encode(const gef::Matrix44& transform, CompactPose& pose);
+	static void Decode(const CompactPose& pose, gef::Matrix44& transform);
+
+	// Encode and decode arrays of transforms
+	static void EncodePoses(const gef::Matrix44* transforms, CompactPose* poses, int count);
+	static void DecodePoses(const CompactPose* poses, gef::Matrix44* transforms, int count);
+
+	// Write transforms to a file as compact poses
+	static bool WritePoseFile(const char* file_name, const gef::Matrix44* transforms, int count);
+	// Read transforms from a compact pose file, returning false if the file is missing or invalid
+	static bool ReadPoseFile(const char* file_name, std::vector<gef::Matrix44>& transforms);
+
+};
+
+#endif // !COMPACT_POSE_H
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "frame_governor.h"
+
+// Fraction of the budget the smoothed cost has to go over before work is shed, and drop under before it's restored
+static const float over_budget_fraction = 0.9f;
+static const float under_budget_fraction = 0.6f;
+
+// Frames the cost has to stay over or under for before a knob changes
+// Restoring work waits much longer, so the governor doesn't flip back and forth
+static const int frames_before_engaging = 10;
+static const int frames_before_releasing = 120;
+
+// How quickly the smoothed cost follows the measured cost
+static const float cost_smoothing = 0.1f;
+
+// The stage of the frame each knob makes cheaper
+static const ProfilerTimer knob_stages[NUM_GOVERNOR_KNOBS] = { PROFILER_TIMER_UI, PROFILER_TIMER_RENDER, PROFILER_TIMER_TRACKING };
+
+// How willing we are to use each knob, as lowering the tracking rate costs matching accuracy
+static const float knob_weights[NUM_GOVERNOR_KNOBS] = { 1.0f, 1.0f, 0.5f };
+
+FrameGovernor::FrameGovernor() :
+	num_engaged_(0),
+	frame_cost_(0.0f),
+	frames_over_budget_(0),
+	frames_under_budget_(0)
+{
+
+	for (int knob = 0; knob < NUM_GOVERNOR_KNOBS; knob++)
+	{
+
+		engaged_[knob] = false;
+
+	}
+
+}
+
+FrameGovernor::~FrameGovernor()
+{
+
+
+
+}
+
+void FrameGovernor::Update(Profiler* profiler_)
+{
+
+	// Only the timed stages count, the rest of the frame is mostly waiting for the display
+	float cost = 0.0f;
+	for (int timer = 0; timer < NUM_PROFILER_TIMERS; timer++)
+	{
+
+		cost += profiler_->GetTimer((ProfilerTimer)timer);
+
+	}
+
+	frame_cost_ += (cost - frame_cost_) * cost_smoothing;
+
+	frames_over_budget_ = frame_cost_ > GOVERNOR_FRAME_BUDGET * over_budget_fraction ? frames_over_budget_ + 1 : 0;
+	frames_under_budget_ = frame_cost_ < GOVERNOR_FRAME_BUDGET * under_budget_fraction ? frames_under_budget_ + 1 : 0;
+
+	if (frames_over_budget_ >= frames_before_engaging && num_engaged_ < NUM_GOVERNOR_KNOBS)
+	{
+
+		// Cut whichever stage is costing the most that we haven't already cut
+		int best_knob = -1;
+		float best_saving = -1.0f;
+		for (int knob = 0; knob < NUM_GOVERNOR_KNOBS; knob++)
+		{
+
+			float saving = profiler_->GetTimer(knob_stages[knob]) * knob_weights[knob];
+			if (!engaged_[knob] && saving > best_saving)
+			{
+
+				best_knob = knob;
+				best_saving = saving;
+
+			}
+
+		}
+
+		engaged_[best_knob] = true;
+		engaged_order_[num_engaged_++] = (GovernorKnob)best_knob;
+		frames_over_budget_ = 0;
+
+	}
+	else if (frames_under_budget_ >= frames_before_releasing && num_engaged_ > 0)
+	{
+
+		engaged_[engaged_order_[--num_engaged_]] = false;
+		frames_under_budget_ = 0;
+
+	}
+
+}
\ No newline at end of file
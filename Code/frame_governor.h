@@ -0,0 +1,55 @@
+#ifndef FRAME_GOVERNOR_H
+#define FRAME_GOVERNOR_H
+
+#include "profiler.h"
+
+// Time the timed stages of a frame should fit in, in milliseconds
+#define GOVERNOR_FRAME_BUDGET (1000.0f / 60.0f)
+
+// Enumerated type for the ways the governor can cut the cost of a frame
+enum GovernorKnob
+{
+
+	GOVERNOR_KNOB_DEBUG_TEXT,				// Hide the transform debug text
+	GOVERNOR_KNOB_MESH_LOD,					// Draw coarser mesh LODs
+	GOVERNOR_KNOB_TRACKING_RATE,			// Only track the markers every other frame
+	NUM_GOVERNOR_KNOBS
+
+};
+
+// Frame governor class
+// Watches how long each stage of the frame takes and sheds work when the frame goes over budget
+// Each time the frame stays over budget, the knob for whichever stage is costing the most is engaged,
+// and once there's plenty of headroom again the knobs are released in the reverse order
+class FrameGovernor
+{
+
+public:
+
+	FrameGovernor();
+	~FrameGovernor();
+
+	// Update the governor with the stage timings from the last frame
+	void Update(Profiler* profiler_);
+
+	inline bool IsEngaged(GovernorKnob knob) { return engaged_[knob]; };
+	inline int GetNumEngaged() { return num_engaged_; };
+
+	// Get the smoothed time the timed stages are taking, in milliseconds
+	inline float GetFrameCost() { return frame_cost_; };
+
+private:
+
+	bool engaged_[NUM_GOVERNOR_KNOBS];
+	// Knobs in the order they were engaged, so they can be released in the reverse order
+	GovernorKnob engaged_order_[NUM_GOVERNOR_KNOBS];
+	int num_engaged_;
+
+	float frame_cost_;
+	// Number of frames in a row the frame has been over, or well under, budget
+	int frames_over_budget_;
+	int frames_under_budget_;
+
+};
+
+#endif // !FRAME_GOVERNOR_H
\ No newline at end of file
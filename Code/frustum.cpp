@@ -0,0 +1,100 @@
+#include "frustum.h"
+#include <math.h>
+
+// Combine two matrix columns into a plane, keeping all four components
+static gef::Vector4 AddPlane(const gef::Vector4& a, const gef::Vector4& b, float sign)
+{
+
+	return gef::Vector4(a.x() + b.x() * sign, a.y() + b.y() * sign, a.z() + b.z() * sign, a.w() + b.w() * sign);
+
+}
+
+Frustum::Frustum()
+{
+
+	// Default to planes that accept everything
+	for (int plane = 0; plane < 6; plane++)
+	{
+
+		planes_[plane] = gef::Vector4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	}
+
+}
+
+Frustum::~Frustum()
+{
+
+
+
+}
+
+void Frustum::SetFromMatrix(const gef::Matrix44& view_projection)
+{
+
+	// GEF transforms row vectors, so the clip planes are built from the matrix columns
+	gef::Vector4 row0 = view_projection.GetRow(0);
+	gef::Vector4 row1 = view_projection.GetRow(1);
+	gef::Vector4 row2 = view_projection.GetRow(2);
+	gef::Vector4 row3 = view_projection.GetRow(3);
+
+	gef::Vector4 column0 = gef::Vector4(row0.x(), row1.x(), row2.x(), row3.x());
+	gef::Vector4 column1 = gef::Vector4(row0.y(), row1.y(), row2.y(), row3.y());
+	gef::Vector4 column2 = gef::Vector4(row0.z(), row1.z(), row2.z(), row3.z());
+	gef::Vector4 column3 = gef::Vector4(row0.w(), row1.w(), row2.w(), row3.w());
+
+	// Left, right, bottom, top, near, far
+	planes_[0] = AddPlane(column3, column0, 1.0f);
+	planes_[1] = AddPlane(column3, column0, -1.0f);
+	planes_[2] = AddPlane(column3, column1, 1.0f);
+	planes_[3] = AddPlane(column3, column1, -1.0f);
+	planes_[4] = AddPlane(column3, column2, 1.0f);
+	planes_[5] = AddPlane(column3, column2, -1.0f);
+
+	// Normalise the planes so the sphere test can compare against the radius directly
+	for (int plane = 0; plane < 6; plane++)
+	{
+
+		float length = sqrtf(planes_[plane].x() * planes_[plane].x()
+			+ planes_[plane].y() * planes_[plane].y()
+			+ planes_[plane].z() * planes_[plane].z());
+
+		if (length > 0.0f)
+		{
+
+			planes_[plane] = gef::Vector4(
+				planes_[plane].x() / length,
+				planes_[plane].y() / length,
+				planes_[plane].z() / length,
+				planes_[plane].w() / length);
+
+		}
+
+	}
+
+}
+
+bool Frustum::IsSphereVisible(const gef::Vector4& centre, float radius) const
+{
+
+	for (int plane = 0; plane < 6; plane++)
+	{
+
+		float distance = planes_[plane].x() * centre.x()
+			+ planes_[plane].y() * centre.y()
+			+ planes_[plane].z() * centre.z()
+			+ planes_[plane].w();
+
+		// Entirely behind one of the planes, so it can't be seen
+		if (distance < -radius)
+		{
+
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
\ No newline at end of file
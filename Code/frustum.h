@@ -0,0 +1,30 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <maths/vector4.h>
+#include <maths/matrix44.h>
+
+// Frustum class
+// Holds the six clip planes of a view-projection matrix for culling bounding volumes
+class Frustum
+{
+
+public:
+
+	Frustum();
+	~Frustum();
+
+	// Extract the clip planes from a combined view and projection matrix
+	void SetFromMatrix(const gef::Matrix44& view_projection);
+
+	// Check if a sphere is at least partly inside the frustum
+	bool IsSphereVisible(const gef::Vector4& centre, float radius) const;
+
+private:
+
+	// Planes stored as (normal, distance), normalised so distances are in world units
+	gef::Vector4 planes_[6];
+
+};
+
+#endif // !FRUSTUM_H
\ No newline at end of file
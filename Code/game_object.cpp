@@ -1,24 +1,42 @@
 #include "game_object.h"
 
-GameObject::GameObject()
+// Projected screen height below which each coarser LOD is used
+static const float lod_screen_sizes[MAX_MESH_LODS - 1] = { 0.3f, 0.12f };
+
+// Fraction either side of a threshold that the screen size has to move past before the LOD changes, to stop popping
+static const float lod_hysteresis = 0.2f;
+
+GameObject::GameObject() :
+	cold_data_(NULL)
+{
+}
+
+void GameObject::reset(GameObjectColdData* cold_data)
 {
 
+	cold_data_ = cold_data;
+
 	position_ = gef::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
-	rotation_x_ = 0.0f;
-	rotation_y_ = 0.0f;
-	rotation_z_ = 0.0f;
-	scale_ = 1.0f;
+	previous_position_ = position_;
+	cold_data_->rotation_x = 0.0f;
+	cold_data_->rotation_y = 0.0f;
+	cold_data_->rotation_z = 0.0f;
+	cold_data_->scale = 1.0f;
 	velocity_ = gef::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+	update_scale_rotation();
 
 	requires_transform_update_ = false;
 	is_active_ = false;
 	is_marker_object_ = false;
 	is_local_ = false;
+	is_anchored_ = false;
 
 	marker_transform_.SetIdentity();
 	marker_ = 0;
 	local_transform_.SetIdentity();
 
+	clear_lod_meshes();
+
 }
 
 GameObject::~GameObject()
@@ -28,51 +46,43 @@ GameObject::~GameObject()
 
 }
 
-void GameObject::update()
+void GameObject::step()
 {
 
-	// Update transform if we need to do so
-	// Order is scale - rotate - translate
-	if (requires_transform_update_ == true || is_moving())
-	{
-
-		// Get a new transform
-		gef::Matrix44 transform_;
-		transform_.SetIdentity();
+	// Keep the last simulated position so rendering can interpolate from it
+	previous_position_ = position_;
 
-		// Make a new scale matrix
-		gef::Matrix44 scale_matrix_;
+	// Velocity is in units per second, so scale it by the fixed timestep
+	position_ = gef::Vector4(
+		position_.x() + velocity_.x() * SIMULATION_TIMESTEP,
+		position_.y() + velocity_.y() * SIMULATION_TIMESTEP,
+		position_.z() + velocity_.z() * SIMULATION_TIMESTEP);
 
-		// Set the scale matrix to the scale
-		scale_matrix_.Scale(gef::Vector4(scale_, scale_, scale_));
-
-		// Apply the scale transformation
-		transform_ = transform_ * scale_matrix_;
+}
 
-		// Make some rotation matrices
-		gef::Matrix44 rotation_x_matrix_;
-		gef::Matrix44 rotation_y_matrix_;
-		gef::Matrix44 rotation_z_matrix_;
+void GameObject::update(float alpha)
+{
 
-		// Set the rotation matrices using class data
-		rotation_x_matrix_.RotationX(rotation_x_);
-		rotation_y_matrix_.RotationY(rotation_y_);
-		rotation_z_matrix_.RotationZ(rotation_z_);
+	// Update transform if we need to do so
+	// Order is scale - rotate - translate
+	if (requires_transform_update_ == true || is_moving())
+	{
 
-		// Apply the rotation transformations
-		transform_ = transform_ * rotation_x_matrix_;
-		transform_ = transform_ * rotation_y_matrix_;
-		transform_ = transform_ * rotation_z_matrix_;
+		// Start from the scale and rotation, which are only rebuilt when they change
+		gef::Matrix44 transform_ = scale_rotation_;
 
-		// Update position based on velocity
-		position_ = gef::Vector4(position_.x() + velocity_.x(), position_.y() + velocity_.y(), position_.z() + velocity_.z());
+		// Interpolate between the previous and current simulated positions
+		gef::Vector4 render_position_ = gef::Vector4(
+			previous_position_.x() + (position_.x() - previous_position_.x()) * alpha,
+			previous_position_.y() + (position_.y() - previous_position_.y()) * alpha,
+			previous_position_.z() + (position_.z() - previous_position_.z()) * alpha);
 
 		// Make a new translation matrix
 		gef::Matrix44 translation_;
 		translation_.SetIdentity();
 
 		// Set the translation matrix
-		translation_.SetTranslation(position_);
+		translation_.SetTranslation(render_position_);
 
 		// Apply the translation transformation
 		transform_ = transform_ * translation_;
@@ -85,8 +95,8 @@ void GameObject::update()
 
 		}
 
-		// If this is a marker object, transform by the marker transform
-		if (is_marker_object_)
+		// If this is a marker object, transform by the marker transform, unless the view does that for us
+		if (is_marker_object_ && !is_anchored_)
 		{
 
 			transform_ = transform_ * marker_transform_;
@@ -109,6 +119,9 @@ void GameObject::set_position(float x, float y, float z)
 
 	position_ = gef::Vector4(x, y, z);
 
+	// Snap the previous position too, so we don't interpolate across the jump
+	previous_position_ = position_;
+
 	requires_transform_update_ = true;
 
 }
@@ -123,9 +136,10 @@ void GameObject::set_velocity(float x, float y, float z)
 void GameObject::set_rotation(float x, float y, float z)
 {
 
-	rotation_x_ = x;
-	rotation_y_ = y;
-	rotation_z_ = z;
+	cold_data_->rotation_x = x;
+	cold_data_->rotation_y = y;
+	cold_data_->rotation_z = z;
+	update_scale_rotation();
 
 	requires_transform_update_ = true;
 
@@ -134,12 +148,35 @@ void GameObject::set_rotation(float x, float y, float z)
 void GameObject::set_scale(float scale)
 {
 
-	scale_ = scale;
+	cold_data_->scale = scale;
+	update_scale_rotation();
 
 	requires_transform_update_ = true;
 
 }
 
+void GameObject::update_scale_rotation()
+{
+
+	// Order is scale - rotate, the translation is applied on top each update
+	gef::Matrix44 scale_matrix_;
+	scale_matrix_.Scale(gef::Vector4(cold_data_->scale, cold_data_->scale, cold_data_->scale));
+
+	// Make some rotation matrices
+	gef::Matrix44 rotation_x_matrix_;
+	gef::Matrix44 rotation_y_matrix_;
+	gef::Matrix44 rotation_z_matrix_;
+
+	// Set the rotation matrices using the cold data
+	rotation_x_matrix_.RotationX(cold_data_->rotation_x);
+	rotation_y_matrix_.RotationY(cold_data_->rotation_y);
+	rotation_z_matrix_.RotationZ(cold_data_->rotation_z);
+
+	// Apply the rotation transformations
+	scale_rotation_ = scale_matrix_ * rotation_x_matrix_ * rotation_y_matrix_ * rotation_z_matrix_;
+
+}
+
 gef::Matrix44 GameObject::get_local_transform()
 {
 
@@ -147,6 +184,20 @@ gef::Matrix44 GameObject::get_local_transform()
 
 }
 
+gef::Matrix44 GameObject::get_camera_transform()
+{
+
+	if (is_marker_object_ && is_anchored_)
+	{
+
+		return transform() * marker_transform_;
+
+	}
+
+	return transform();
+
+}
+
 gef::Vector4 GameObject::get_position()
 {
 
@@ -209,4 +260,87 @@ void GameObject::set_local_transform(gef::Matrix44 local_transform)
 
 	local_transform_ = local_transform;
 
+}
+
+void GameObject::set_anchored(bool value)
+{
+
+	is_anchored_ = value;
+
+	requires_transform_update_ = true;
+
+}
+
+void GameObject::set_lod_mesh(int lod, const gef::Mesh* mesh)
+{
+
+	if (lod < 0 || lod >= MAX_MESH_LODS)
+	{
+
+		return;
+
+	}
+
+	cold_data_->lod_meshes[lod] = mesh;
+
+	if (lod >= cold_data_->num_lods)
+	{
+
+		cold_data_->num_lods = lod + 1;
+
+	}
+
+	// The full resolution mesh is used until a LOD is selected
+	if (lod == 0)
+	{
+
+		lod_ = 0;
+		set_mesh(mesh);
+
+	}
+
+}
+
+void GameObject::clear_lod_meshes()
+{
+
+	for (int lod = 0; lod < MAX_MESH_LODS; lod++)
+	{
+
+		cold_data_->lod_meshes[lod] = NULL;
+
+	}
+	cold_data_->num_lods = 0;
+	lod_ = 0;
+
+}
+
+void GameObject::select_lod(float screen_size)
+{
+
+	if (cold_data_->num_lods == 0)
+	{
+
+		return;
+
+	}
+
+	// Only move to a finer LOD once we're clearly above its threshold
+	while (lod_ > 0 && screen_size > lod_screen_sizes[lod_ - 1] * (1.0f + lod_hysteresis))
+	{
+
+		lod_--;
+
+	}
+
+	// And only move to a coarser LOD once we're clearly below it
+	while (lod_ < cold_data_->num_lods - 1 && screen_size < lod_screen_sizes[lod_] * (1.0f - lod_hysteresis))
+	{
+
+		lod_++;
+
+	}
+
+	set_mesh(cold_data_->lod_meshes[lod_]);
+
 }
\ No newline at end of file
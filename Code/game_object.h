@@ -6,7 +6,28 @@
 #include <maths/matrix44.h>
 #include <graphics/mesh.h>
 #include <graphics/mesh_instance.h>
+#include "mesh_simplifier.h"
 
+// Fixed timestep that object motion is simulated at, in seconds
+const float SIMULATION_TIMESTEP = 1.0f / 60.0f;
+
+// Data about a game object that's only needed when it's set up or its LOD is picked
+// This is kept apart from the objects themselves, so the per-frame updates don't have to step over it
+struct GameObjectColdData
+{
+
+	float rotation_x;
+	float rotation_y;
+	float rotation_z;
+	float scale;
+
+	// Meshes for each level of detail, from finest to coarsest
+	const gef::Mesh* lod_meshes[MAX_MESH_LODS];
+	int num_lods;
+
+};
+
+// Game objects are created in place by a GameObjectPool, which gives each one its cold data
 class GameObject : public gef::MeshInstance
 {
 public:
@@ -14,8 +35,14 @@ public:
 	GameObject();
 	~GameObject();
 
-	// Update the object's position according to transform data
-	void update();
+	// Put the object back into its starting state, using cold data stored elsewhere
+	void reset(GameObjectColdData* cold_data);
+
+	// Advance the object's motion by one fixed simulation timestep
+	void step();
+
+	// Update the object's transform, interpolating between the last two simulated positions by alpha
+	void update(float alpha = 1.0f);
 
 	// Check if the object is moving
 	bool is_moving();
@@ -31,35 +58,54 @@ public:
 	void set_marker_transform(gef::Matrix44 marker_transform);
 	void set_local_transform(gef::Matrix44 local_transform);
 	inline void set_local() { is_local_ = true; };
+	// Anchored objects are kept in the space of the anchor marker, whose transform is applied by the view instead
+	void set_anchored(bool value);
+	// Set the mesh used for a level of detail, LOD 0 being the full resolution mesh
+	void set_lod_mesh(int lod, const gef::Mesh* mesh);
+	// Remove all of the LOD meshes
+	void clear_lod_meshes();
+	// Pick the level of detail from the object's projected size as a fraction of the screen height
+	void select_lod(float screen_size);
 	
 	// Getters
 	gef::Matrix44 get_local_transform();
+	// Get the object's transform in camera space, whether or not it's anchored
+	gef::Matrix44 get_camera_transform();
 	gef::Vector4 get_position();
 	gef::Vector4 get_velocity();
-	inline float get_rotation_x() { return rotation_x_; };
-	inline float get_rotation_y() { return rotation_y_; };
-	inline float get_rotation_z() { return rotation_z_; };
-	inline float get_scale() { return scale_; };
+	inline float get_rotation_x() { return cold_data_->rotation_x; };
+	inline float get_rotation_y() { return cold_data_->rotation_y; };
+	inline float get_rotation_z() { return cold_data_->rotation_z; };
+	inline float get_scale() { return cold_data_->scale; };
 	inline bool is_active() { return is_active_; };
 	inline bool is_marker_object() { return is_marker_object_; };
+	inline bool is_anchored() { return is_anchored_; };
 	inline int get_marker() { return marker_; };
+	inline int get_lod() { return lod_; };
 
 private:
 
+	// Rebuild the scale and rotation part of the transform after either changes
+	void update_scale_rotation();
+
 	gef::Matrix44 local_transform_;
+	gef::Matrix44 marker_transform_;
+	// Scale and rotation applied before the translation, only rebuilt when they change
+	gef::Matrix44 scale_rotation_;
 	gef::Vector4 position_;
+	gef::Vector4 previous_position_;
 	gef::Vector4 velocity_;
-	float rotation_x_;
-	float rotation_y_;
-	float rotation_z_;
-	float scale_;
-	gef::Matrix44 marker_transform_;
+	int lod_;
+	// Read every frame when the markers are sampled, so it's kept here rather than with the cold data
 	int marker_;
 
+	GameObjectColdData* cold_data_;
+
 	bool requires_transform_update_;
 	bool is_active_;
 	bool is_marker_object_;
 	bool is_local_;
+	bool is_anchored_;
 
 };
 
@@ -0,0 +1,106 @@
+#include "game_object_pool.h"
+
+GameObjectPool::GameObjectPool()
+{
+
+	for (int slot = 0; slot < MAX_GAME_OBJECTS; slot++)
+	{
+
+		generations_[slot] = 0;
+		in_use_[slot] = false;
+
+	}
+
+	Clear();
+
+}
+
+GameObjectPool::~GameObjectPool()
+{
+
+
+
+}
+
+GameObjectHandle GameObjectPool::Create()
+{
+
+	if (num_free_slots_ == 0)
+	{
+
+		return INVALID_GAME_OBJECT_HANDLE;
+
+	}
+
+	gef::UInt16 slot = free_slots_[--num_free_slots_];
+	in_use_[slot] = true;
+	num_objects_++;
+
+	objects_[slot].reset(&cold_data_[slot]);
+
+	GameObjectHandle handle;
+	handle.index = slot;
+	handle.generation = generations_[slot];
+
+	return handle;
+
+}
+
+void GameObjectPool::Destroy(GameObjectHandle handle)
+{
+
+	GameObject* game_object = Get(handle);
+	if (!game_object)
+	{
+
+		return;
+
+	}
+
+	// Stop the object being drawn with meshes that may be about to be deleted
+	game_object->set_mesh(NULL);
+
+	in_use_[handle.index] = false;
+	generations_[handle.index]++;
+	free_slots_[num_free_slots_++] = handle.index;
+	num_objects_--;
+
+}
+
+void GameObjectPool::Clear()
+{
+
+	num_free_slots_ = 0;
+	num_objects_ = 0;
+
+	for (int slot = MAX_GAME_OBJECTS - 1; slot >= 0; slot--)
+	{
+
+		if (in_use_[slot])
+		{
+
+			objects_[slot].set_mesh(NULL);
+			in_use_[slot] = false;
+			generations_[slot]++;
+
+		}
+
+		free_slots_[num_free_slots_++] = (gef::UInt16)slot;
+
+	}
+
+}
+
+GameObject* GameObjectPool::Get(GameObjectHandle handle)
+{
+
+	if (handle.index >= MAX_GAME_OBJECTS || !in_use_[handle.index] || generations_[handle.index] != handle.generation)
+	{
+
+		return NULL;
+
+	}
+
+	return &objects_[handle.index];
+
+}
\ No newline at end of file
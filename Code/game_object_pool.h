@@ -0,0 +1,68 @@
+#ifndef GAME_OBJECT_POOL_H
+#define GAME_OBJECT_POOL_H
+
+#include <gef.h>
+#include "game_object.h"
+
+// Most game objects that can exist at once
+// Stress benchmark builds raise this so the benchmark can step up to 10,000 objects
+#ifdef STRESS_BENCHMARK
+#define MAX_GAME_OBJECTS 10240
+#else
+#define MAX_GAME_OBJECTS 16
+#endif
+
+// Refers to a game object in a pool
+// The generation is bumped whenever the object's slot is freed, so handles to destroyed objects stop resolving
+struct GameObjectHandle
+{
+
+	gef::UInt16 index;
+	gef::UInt16 generation;
+
+};
+
+// Handle that never refers to an object
+const GameObjectHandle INVALID_GAME_OBJECT_HANDLE = { 0xffff, 0 };
+
+// Game object pool class
+// Fixed storage for game objects, which are created in place rather than copied in
+// The objects themselves sit together in one array, so per-frame updates run through them without gaps,
+// while their cold data is kept in a separate array
+class GameObjectPool
+{
+
+public:
+
+	GameObjectPool();
+	~GameObjectPool();
+
+	// Create an object in a free slot, returning INVALID_GAME_OBJECT_HANDLE if the pool is full
+	GameObjectHandle Create();
+	// Free an object's slot, after which its handles no longer resolve
+	void Destroy(GameObjectHandle handle);
+	// Destroy every object
+	void Clear();
+
+	// Get the object a handle refers to, or NULL if it's been destroyed
+	GameObject* Get(GameObjectHandle handle);
+	inline bool IsValid(GameObjectHandle handle) { return Get(handle) != NULL; };
+
+	inline int GetNumObjects() { return num_objects_; };
+
+private:
+
+	GameObject objects_[MAX_GAME_OBJECTS];
+	GameObjectColdData cold_data_[MAX_GAME_OBJECTS];
+
+	gef::UInt16 generations_[MAX_GAME_OBJECTS];
+	bool in_use_[MAX_GAME_OBJECTS];
+
+	// Stack of free slots, which starts with the lowest slots on top so objects are packed at the start of the array
+	gef::UInt16 free_slots_[MAX_GAME_OBJECTS];
+	int num_free_slots_;
+	int num_objects_;
+
+};
+
+#endif // !GAME_OBJECT_POOL_H
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "hud_text.h"
+#include <graphics/sprite_renderer.h>
+#include <maths/vector4.h>
+
+// Powers of ten for converting floats to fixed point
+static const float fixed_point_scales[HUD_TEXT_MAX_DECIMALS + 1] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f };
+static const gef::Int32 fixed_point_divisors[HUD_TEXT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000 };
+
+// Largest magnitude a fixed point value is clamped to, so huge or invalid floats can't overflow
+static const float fixed_point_limit = 2000000000.0f;
+
+HudText::HudText() :
+	num_pending_parts_(0),
+	current_slot_(-1),
+	num_rebuilds_(0)
+{
+
+	for (int slot = 0; slot < NUM_HUD_TEXT_SLOTS; slot++)
+	{
+
+		slots_[slot].num_parts = 0;
+		slots_[slot].text[0] = '\0';
+
+	}
+
+}
+
+HudText::~HudText()
+{
+
+
+
+}
+
+void HudText::Begin(HudTextSlot slot)
+{
+
+	current_slot_ = slot;
+	num_pending_parts_ = 0;
+
+}
+
+void HudText::Append(const char* text)
+{
+
+	AddPart(text, 0, 0);
+
+}
+
+void HudText::AppendInt(gef::Int32 value)
+{
+
+	AddPart(NULL, value, 0);
+
+}
+
+void HudText::AppendFixed(float value, int decimals)
+{
+
+	if (decimals < 0)
+	{
+
+		decimals = 0;
+
+	}
+	else if (decimals > HUD_TEXT_MAX_DECIMALS)
+	{
+
+		decimals = HUD_TEXT_MAX_DECIMALS;
+
+	}
+
+	// Round to the nearest fixed point value, treating NaN as zero
+	float scaled = value * fixed_point_scales[decimals];
+	if (!(scaled == scaled))
+	{
+
+		scaled = 0.0f;
+
+	}
+	else if (scaled > fixed_point_limit)
+	{
+
+		scaled = fixed_point_limit;
+
+	}
+	else if (scaled < -fixed_point_limit)
+	{
+
+		scaled = -fixed_point_limit;
+
+	}
+
+	gef::Int32 fixed = (gef::Int32)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+	AddPart(NULL, fixed, decimals);
+
+}
+
+bool HudText::End()
+{
+
+	if (current_slot_ < 0)
+	{
+
+		return false;
+
+	}
+
+	Slot& slot = slots_[current_slot_];
+	current_slot_ = -1;
+
+	// Literals are compared by pointer, since they're expected to be the same string each frame
+	bool changed = slot.num_parts != num_pending_parts_;
+	for (int part = 0; part < num_pending_parts_ && !changed; part++)
+	{
+
+		const Part& old_part = slot.parts[part];
+		const Part& new_part = pending_parts_[part];
+		changed = old_part.text != new_part.text || old_part.value != new_part.value || old_part.decimals != new_part.decimals;
+
+	}
+
+	if (!changed)
+	{
+
+		return false;
+
+	}
+
+	for (int part = 0; part < num_pending_parts_; part++)
+	{
+
+		slot.parts[part] = pending_parts_[part];
+
+	}
+
+	slot.num_parts = num_pending_parts_;
+
+	Format(slot);
+	num_rebuilds_++;
+
+	return true;
+
+}
+
+void HudText::Render(gef::Font* font_, gef::SpriteRenderer* sprite_renderer_, HudTextSlot slot, const gef::Vector4& position, gef::TextJustification justification)
+{
+
+	// The cached string is passed as an argument so any '%' in it isn't taken as formatting
+	font_->RenderText(sprite_renderer_, position, 1.0f, 0xffffffff, justification, "%s", slots_[slot].text);
+
+}
+
+void HudText::AddPart(const char* text, gef::Int32 value, int decimals)
+{
+
+	// Parts past the limit are dropped rather than overrunning the buffer
+	if (current_slot_ < 0 || num_pending_parts_ >= HUD_TEXT_MAX_PARTS)
+	{
+
+		return;
+
+	}
+
+	Part& part = pending_parts_[num_pending_parts_++];
+	part.text = text;
+	part.value = value;
+	part.decimals = decimals;
+
+}
+
+void HudText::Format(Slot& slot)
+{
+
+	// Leave room for the terminator
+	const int max_length = HUD_TEXT_MAX_LENGTH - 1;
+	int length = 0;
+
+	for (int part = 0; part < slot.num_parts && length < max_length; part++)
+	{
+
+		const Part& current_part = slot.parts[part];
+
+		if (current_part.text)
+		{
+
+			for (const char* character = current_part.text; *character && length < max_length; character++)
+			{
+
+				slot.text[length++] = *character;
+
+			}
+
+			continue;
+
+		}
+
+		// Work with the magnitude as unsigned so the most negative value doesn't overflow
+		bool negative = current_part.value < 0;
+		gef::UInt32 magnitude = negative ? 0u - (gef::UInt32)current_part.value : (gef::UInt32)current_part.value;
+		gef::UInt32 integer_part = magnitude / fixed_point_divisors[current_part.decimals];
+		gef::UInt32 fraction_part = magnitude % fixed_point_divisors[current_part.decimals];
+
+		// Digits are written backwards into a scratch buffer, then copied across
+		char digits[16];
+		int num_digits = 0;
+
+		for (int decimal = 0; decimal < current_part.decimals; decimal++)
+		{
+
+			digits[num_digits++] = (char)('0' + fraction_part % 10);
+			fraction_part /= 10;
+
+		}
+
+		if (current_part.decimals > 0)
+		{
+
+			digits[num_digits++] = '.';
+
+		}
+
+		do
+		{
+
+			digits[num_digits++] = (char)('0' + integer_part % 10);
+			integer_part /= 10;
+
+		} while (integer_part > 0);
+
+		if (negative)
+		{
+
+			digits[num_digits++] = '-';
+
+		}
+
+		while (num_digits > 0 && length < max_length)
+		{
+
+			slot.text[length++] = digits[--num_digits];
+
+		}
+
+	}
+
+	slot.text[length] = '\0';
+
+}
\ No newline at end of file
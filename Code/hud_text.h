@@ -0,0 +1,114 @@
+#ifndef HUD_TEXT_H
+#define HUD_TEXT_H
+
+#include <gef.h>
+#include <graphics/font.h>
+
+// Longest string a slot can hold, including the terminator
+#define HUD_TEXT_MAX_LENGTH 96
+// Most parts a slot's string can be built from
+#define HUD_TEXT_MAX_PARTS 16
+// Most decimal places a fixed point number can be printed with
+#define HUD_TEXT_MAX_DECIMALS 4
+
+// GEF forward declarations
+namespace gef
+{
+
+	class SpriteRenderer;
+	class Vector4;
+
+}
+
+// Enumerated type for the strings on the HUD that change from frame to frame
+enum HudTextSlot
+{
+
+	HUD_TEXT_FPS,					// Frame rate
+	HUD_TEXT_LEVEL,					// Current level ID
+	HUD_TEXT_CAPTURE,				// Progress of a reference capture
+	HUD_TEXT_M02_POSITION,			// Position of the mesh on marker 02
+	HUD_TEXT_M01_POSITION,			// Position of the mesh on marker 01
+	HUD_TEXT_CULLING,				// Culling statistics
+	HUD_TEXT_LATENCY,				// Input latency
+	HUD_TEXT_STARTUP,				// Time to first frame and the main startup phases
+	HUD_TEXT_STARTUP_TASKS,			// Times of the startup tasks run on the task pool
+	HUD_TEXT_REWIND,				// Pose history frame being looked at and its match result
+	HUD_TEXT_REWIND_FILTERS,		// Pose filter state in the frame being looked at
+	HUD_TEXT_REWIND_M02_ROWS,		// Per-row differences of marker 02's object from its reference
+	HUD_TEXT_REWIND_M01_ROWS,		// Per-row differences of marker 01's object from its reference
+	NUM_HUD_TEXT_SLOTS
+
+};
+
+// HUD text class
+// Caches the formatted string for each HUD slot so it only has to be rebuilt when the values in it change
+// A slot's string is described between Begin and End as a list of literal and numeric parts, and numbers are
+// stored as integers, or fixed point for floats, so checking whether it's changed is just comparing the part lists
+// Formatting is done with integer maths rather than through printf's varargs
+class HudText
+{
+
+public:
+
+	HudText();
+	~HudText();
+
+	// Start describing the string for a slot
+	void Begin(HudTextSlot slot);
+	// Append a string literal, which must outlive the HUD text as only the pointer is kept
+	void Append(const char* text);
+	// Append an integer
+	void AppendInt(gef::Int32 value);
+	// Append a float, rounded to a number of decimal places
+	void AppendFixed(float value, int decimals);
+	// Finish describing the slot's string, and rebuild it if any of its parts changed
+	// Returns whether the string was rebuilt
+	bool End();
+
+	// Render a slot's cached string
+	void Render(gef::Font* font_, gef::SpriteRenderer* sprite_renderer_, HudTextSlot slot, const gef::Vector4& position, gef::TextJustification justification);
+
+	inline const char* GetText(HudTextSlot slot) { return slots_[slot].text; };
+	// Get how many times slot strings have been rebuilt, for seeing how well the cache is doing
+	inline int GetNumRebuilds() { return num_rebuilds_; };
+
+private:
+
+	// A literal string, or a number to be printed with a number of decimal places if the string is NULL
+	struct Part
+	{
+
+		const char* text;
+		gef::Int32 value;
+		int decimals;
+
+	};
+
+	struct Slot
+	{
+
+		Part parts[HUD_TEXT_MAX_PARTS];
+		int num_parts;
+		char text[HUD_TEXT_MAX_LENGTH];
+
+	};
+
+	// Add a part to the slot being described
+	void AddPart(const char* text, gef::Int32 value, int decimals);
+	// Rebuild a slot's string from its parts
+	void Format(Slot& slot);
+
+	Slot slots_[NUM_HUD_TEXT_SLOTS];
+
+	// Parts of the slot currently being described, which are only copied into the slot if they differ
+	Part pending_parts_[HUD_TEXT_MAX_PARTS];
+	int num_pending_parts_;
+	// Slot being described, or -1 if there isn't one
+	int current_slot_;
+
+	int num_rebuilds_;
+
+};
+
+#endif // !HUD_TEXT_H
\ No newline at end of file
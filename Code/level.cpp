@@ -1,374 +1,1346 @@
 #include "Level.h"
+#include <string.h>
 #include <system/platform.h>
 #include <maths/math_utils.h>
 #include <graphics/renderer_3d.h>
 #include <graphics/scene.h>
+#include <graphics/mesh.h>
+#include <graphics/mesh_data.h>
+#include <kernel.h>
 #include "game_object.h"
+#include "profiler.h"
+#include "mesh_simplifier.h"
+#include "asset_bundle.h"
+#include "pose_maths.h"
+#include "camera_calibration.h"
+#include "level_streamer.h"
 
 #include <sony_sample_framework.h>
 #include <sony_tracking.h>
 
-Level::Level()
+#ifdef HOT_RELOAD_LEVELS
+// Get the modification time and size of a file, which change whenever it's saved
+static bool GetFileStamp(const char* file_name, gef::UInt64& modified_time, gef::Int64& size)
 {
 
+	SceIoStat stat;
+	if (sceIoGetstat(file_name, &stat) < 0)
+	{
+
+		return false;
+
+	}
+
+	const SceDateTime& time = stat.st_mtime;
+	modified_time = (((((gef::UInt64)time.year * 13 + time.month) * 32 + time.day) * 24 + time.hour) * 60 + time.minute) * 60 + time.second;
+	modified_time = modified_time * 1000000 + time.microsecond;
+	size = stat.st_size;
+	return true;
+
+}
+#endif
+
+Level::Level() :
+	definition_hash_(0),
+#ifdef HOT_RELOAD_LEVELS
+	definition_time_(0),
+	definition_size_(-1),
+#endif
+	matched_solution_(-1),
+	rewind_offset_(-1),
+	world_anchor_(true),
+	asset_bundle_(NULL),
+	camera_calibration_(NULL),
+	level_streamer_(NULL),
+	lod_scale_(1.0f)
+{
+
+	relative_transform_.SetIdentity();
+	view_transform_.SetIdentity();
+	memset(&history_frame_, 0, sizeof(PoseHistoryFrame));
+
+}
+
+// Clean up the meshes and scenes
+Level::~Level()
+{
+
+	ResetLevel();
+
+}
+
+bool Level::ReadDefinition(int level_identifier, float tolerance_value, LevelDefinition& definition, gef::UInt32& hash)
+{
+
+	// Start from the built-in definition of the level, if it has one
+	bool is_built_in = definition.SetDefault(level_identifier, tolerance_value);
+
+	// Then let the level file override it, remembering its contents so we can tell when it changes
+	// Levels in a level pack beyond the built-in ones come from their level file alone
+	hash = 0;
+	bool is_parsed = false;
+
+	std::string text;
+	if (LevelDefinition::ReadFile(LevelDefinition::GetFileName(level_identifier).c_str(), text))
+	{
+
+		hash = LevelDefinition::Hash(text);
+		is_parsed = definition.Parse(text);
+
+	}
+
+	return is_built_in || is_parsed;
+
+}
+
+bool Level::PreloadScenes(int level_identifier, float tolerance_value, gef::Platform* platform_)
+{
+
+	LevelDefinition definition;
+	gef::UInt32 hash;
+	if (!ReadDefinition(level_identifier, tolerance_value, definition, hash))
+	{
+
+		return false;
+
+	}
+
+	for (std::vector<ObjectDefinition>::const_iterator it = definition.objects.begin(); it != definition.objects.end(); ++it)
+	{
+
+		// Bundled scenes don't need reading
+		if (asset_bundle_ && asset_bundle_->FindScene(it->lod_scene_file.c_str()))
+		{
+
+			continue;
+
+		}
+
+		bool is_preloaded = false;
+		for (std::vector<LevelScene>::iterator scene = preloaded_scenes_.begin(); scene != preloaded_scenes_.end(); ++scene)
+		{
+
+			is_preloaded = is_preloaded || scene->file_name == it->scene_file;
+
+		}
+
+		if (!is_preloaded)
+		{
+
+			LevelScene scene;
+			scene.file_name = it->scene_file;
+			scene.scene = LoadScene(platform_, it->scene_file.c_str(), it->lod_scene_file.c_str());
+			scene.source_mesh = NULL;
+			scene.first_mesh = 0;
+			scene.last_mesh = 0;
+			preloaded_scenes_.push_back(scene);
+
+		}
+
+	}
+
+	return true;
+
+}
+
+bool Level::InitLevel(int level_identifier, float tolerance_value, gef::Platform* platform_)
+{
+
+	LevelDefinition definition;
+	gef::UInt32 hash;
+	if (!ReadDefinition(level_identifier, tolerance_value, definition, hash))
+	{
+
+		level_id_ = level_identifier;
+		definition_hash_ = hash;
+		return false;
+
+	}
+
+	InitLevel(definition, platform_);
+
+	definition_file_ = LevelDefinition::GetFileName(level_identifier);
+	definition_hash_ = hash;
+#ifdef HOT_RELOAD_LEVELS
+	GetFileStamp(definition_file_.c_str(), definition_time_, definition_size_);
+#endif
+
+	return true;
+
+}
+
+void Level::InitLevel(const LevelDefinition& definition, gef::Platform* platform_)
+{
+
+	level_id_ = definition.level_id;
+
+	// Without a file there's nothing to hot reload
+	definition_file_.clear();
+	definition_hash_ = 0;
+#ifdef HOT_RELOAD_LEVELS
+	definition_time_ = 0;
+	definition_size_ = -1;
+#endif
+
+	BuildLevel(definition, platform_);
+
+	// Any preloaded scenes the level didn't use aren't needed
+	for (std::vector<LevelScene>::iterator it = preloaded_scenes_.begin(); it != preloaded_scenes_.end(); ++it)
+	{
+
+		delete it->scene;
+
+	}
+	preloaded_scenes_.clear();
+
+}
+
+void Level::AddScene(const std::string& file_name, gef::Scene* scene)
+{
+
+	LevelScene level_scene;
+	level_scene.file_name = file_name;
+	level_scene.scene = scene;
+	level_scene.source_mesh = NULL;
+	level_scene.first_mesh = 0;
+	level_scene.last_mesh = 0;
+	preloaded_scenes_.push_back(level_scene);
+
+}
+
+#ifdef HOT_RELOAD_LEVELS
+bool Level::HotReload(gef::Platform* platform_)
+{
+
+	// Nothing to do if the level file is missing or hasn't changed
+	// Its modification time and size are much cheaper to check than its contents, so it's only read once they change
+	gef::UInt64 modified_time;
+	gef::Int64 size;
+	if (!GetFileStamp(definition_file_.c_str(), modified_time, size) || (modified_time == definition_time_ && size == definition_size_))
+	{
+
+		return false;
+
+	}
+	definition_time_ = modified_time;
+	definition_size_ = size;
+
+	std::string text;
+	if (!LevelDefinition::ReadFile(definition_file_.c_str(), text))
+	{
+
+		return false;
+
+	}
+
+	gef::UInt32 hash = LevelDefinition::Hash(text);
+	if (hash == definition_hash_)
+	{
+
+		return false;
+
+	}
+	definition_hash_ = hash;
+
+	// Keep playing the current level if the edited file doesn't parse
+	LevelDefinition definition = definition_;
+	if (!definition.Parse(text))
+	{
+
+		return false;
+
+	}
+
+	// Adding or removing objects or moving them between markers changes how they're tracked, so rebuild the level
+	bool rebuild = definition.objects.size() != definition_.objects.size();
+	for (size_t object = 0; !rebuild && object < definition.objects.size(); object++)
+	{
+
+		rebuild = definition.objects[object].marker != definition_.objects[object].marker
+			|| definition.objects[object].is_local != definition_.objects[object].is_local;
+
+	}
+
+	if (rebuild)
+	{
+
+		ResetLevel();
+		BuildLevel(definition, platform_);
+		return true;
+
+	}
+
+	// Otherwise patch the live level, which keeps the objects' marker transforms
+	tolerance_value_ = definition.tolerance;
+	transforms_ = definition.reference_transforms;
+	match_bounds_ = definition.match_bounds;
+	BuildSolutionIndex(definition);
+
+	for (size_t object = 0; object < definition.objects.size(); object++)
+	{
+
+		const ObjectDefinition& new_object = definition.objects[object];
+		const ObjectDefinition& old_object = definition_.objects[object];
+
+		// Only load meshes that have actually changed
+		if (new_object.scene_file != old_object.scene_file || new_object.lod_scene_file != old_object.lod_scene_file)
+		{
+
+			const LevelScene& scene = scenes_[GetScene(platform_, new_object)];
+			SetMeshLods(Object(object), scene.first_mesh, scene.last_mesh);
+			definition_.objects[object] = new_object;
+			SetSymmetry((int)object, scene);
+
+		}
+		else if (new_object.symmetry_order >= 0 && (new_object.symmetry_axis != old_object.symmetry_axis || new_object.symmetry_order != old_object.symmetry_order))
+		{
+
+			definition_.objects[object] = new_object;
+			SetSymmetry((int)object, scenes_[GetScene(platform_, new_object)]);
+
+		}
+
+		// Keep the symmetry we worked out if the file doesn't give one
+		if (definition.objects[object].symmetry_order < 0)
+		{
+
+			definition.objects[object].symmetry_axis = definition_.objects[object].symmetry_axis;
+			definition.objects[object].symmetry_order = definition_.objects[object].symmetry_order;
+
+		}
+
+		Object(object).set_position(new_object.position[0], new_object.position[1], new_object.position[2]);
+		Object(object).set_rotation(new_object.rotation[0], new_object.rotation[1], new_object.rotation[2]);
+		Object(object).set_scale(new_object.scale);
+
+	}
+
+	definition_ = definition;
+
+	return true;
+
+}
+#endif
+
+void Level::BuildLevel(const LevelDefinition& definition, gef::Platform* platform_)
+{
+
+	definition_ = definition;
+
+	tolerance_value_ = definition.tolerance;
+	transforms_ = definition.reference_transforms;
+	match_bounds_ = definition.match_bounds;
+	num_transforms_ = (int)transforms_.size();
+	BuildSolutionIndex(definition);
+
+	for (std::vector<ObjectDefinition>::const_iterator it = definition.objects.begin(); it != definition.objects.end(); ++it)
+	{
+
+		// Objects that use the same scene file share its meshes
+		const LevelScene& scene = scenes_[GetScene(platform_, *it)];
+
+		// Create the object in place in the pool, it's only ever referred to by its handle
+		GameObjectHandle handle = game_objects_.Create();
+		if (!game_objects_.IsValid(handle))
+		{
+
+			break;
+
+		}
+
+		GameObject& game_object = *game_objects_.Get(handle);
+		SetMeshLods(game_object, scene.first_mesh, scene.last_mesh);
+		game_object.set_marker(it->marker);
+		game_object.set_anchored(world_anchor_);
+
+		if (it->is_local)
+		{
+
+			game_object.set_local();
+
+		}
+
+		game_object.set_position(it->position[0], it->position[1], it->position[2]);
+		game_object.set_rotation(it->rotation[0], it->rotation[1], it->rotation[2]);
+		game_object.set_scale(it->scale);
+
+		object_handles_.push_back(handle);
+
+		symmetries_.push_back(ShapeSymmetry());
+		SetSymmetry((int)object_handles_.size() - 1, scene);
+
+	}
+
+}
+
+int Level::GetScene(gef::Platform* platform_, const ObjectDefinition& object)
+{
+
+	for (size_t scene = 0; scene < scenes_.size(); scene++)
+	{
+
+		if (scenes_[scene].file_name == object.scene_file)
+		{
+
+			return (int)scene;
+
+		}
+
+	}
+
+	LevelScene scene;
+	scene.file_name = object.scene_file;
+	scene.scene = NULL;
+	scene.source_mesh = NULL;
+	scene.first_mesh = (int)meshes_.size();
+
+	// Take the mesh and its LODs from the asset bundle if they've been baked into it
+	const BundledScene* bundled_scene = asset_bundle_ ? asset_bundle_->FindScene(object.lod_scene_file.c_str()) : NULL;
+	if (bundled_scene && !bundled_scene->mesh_data.empty())
+	{
+
+		for (int lod = 0; lod < (int)bundled_scene->mesh_data.size() && lod < MAX_MESH_LODS; lod++)
+		{
+
+			meshes_.push_back(asset_bundle_->CreateMesh(*platform_, bundled_scene, lod));
+
+		}
+
+		scene.source_mesh = &bundled_scene->mesh_data.front();
+
+	}
+	else
+	{
+
+		// Otherwise load them from the scene file, unless it's already been read
+		for (std::vector<LevelScene>::iterator it = preloaded_scenes_.begin(); it != preloaded_scenes_.end(); ++it)
+		{
+
+			if (it->file_name == object.scene_file)
+			{
+
+				scene.scene = it->scene;
+				preloaded_scenes_.erase(it);
+				break;
+
+			}
+
+		}
+
+		// Then try the streamer's cache, which may already have created the scene's materials
+		bool materials_created = false;
+		if (!scene.scene && level_streamer_)
+		{
+
+			scene.scene = level_streamer_->AcquireScene(platform_, object, materials_created);
+
+		}
+		else if (!scene.scene)
+		{
+
+			scene.scene = LoadScene(platform_, object.scene_file.c_str(), object.lod_scene_file.c_str());
+
+		}
+
+		if (!materials_created)
+		{
+
+			scene.scene->CreateMaterials(*platform_);
+
+		}
+
+		scene.first_mesh = CreateMeshes(platform_, scene.scene);
+
+		if (!scene.scene->mesh_data.empty())
+		{
+
+			scene.source_mesh = &scene.scene->mesh_data.front();
+
+		}
+
+	}
+
+	scene.last_mesh = (int)meshes_.size();
+
+	scenes_.push_back(scene);
+
+	return (int)scenes_.size() - 1;
+
+}
+
+void Level::SetSymmetry(int object, const LevelScene& scene)
+{
+
+	ObjectDefinition& object_definition = definition_.objects[object];
+	ShapeSymmetry& symmetry = symmetries_[object];
+
+	if (!scene.source_mesh)
+	{
+
+		symmetry = ShapeSymmetry();
+		return;
+
+	}
+
+	const gef::MeshData& mesh_data = *scene.source_mesh;
+
+	if (object_definition.symmetry_order < 0)
+	{
+
+		// Remember what we found so it's written out with the level file and doesn't need working out again
+		symmetry.Compute(mesh_data);
+		object_definition.symmetry_axis = symmetry.GetAxis();
+		object_definition.symmetry_order = symmetry.GetOrder();
+
+	}
+	else
+	{
+
+		symmetry.Set(object_definition.symmetry_axis, object_definition.symmetry_order, ShapeSymmetry::GetCentre(mesh_data));
+
+	}
+
+}
+
+void Level::StepSimulation(int num_steps)
+{
+
+	// Step every object whether or not its marker is visible so the simulation stays deterministic
+	for (int step = 0; step < num_steps; step++)
+	{
+
+		for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
+		{
+
+			game_objects_.Get(*it)->step();
+
+		}
+
+	}
+
+}
+
+bool Level::GetUpdate(float alpha)
+{
+
+	// Check that the meshes are active before their positions are updated
+	for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
+	{
+
+		GameObject* game_object = game_objects_.Get(*it);
+		if (game_object->is_active())
+		{
+
+			game_object->update(alpha);
+
+		}
+
+	}
+
+	UpdateCameraTransforms();
+
+	// This will only evaluate as true if the 0th game object is also active
+	if (Object(1).is_active())
+	{
+
+		// Record the configuration if we're capturing new reference transforms
+		if (capture_.IsCapturing())
+		{
+
+			std::vector<gef::Matrix44> frame_transforms;
+			frame_transforms.push_back(GetCanonicalTransform(0));
+			frame_transforms.push_back(GetCanonicalTransform(1));
+			capture_.AddFrame(frame_transforms);
+
+			if (capture_.IsComplete())
+			{
+
+				FinishCapture();
+
+			}
+
+		}
+
+		// Hence we can check transforms here
+		return CheckTransforms();
+
+	}
+
+	return false;
+
+}
+
+bool Level::CheckTransforms()
+{
+
+	// Nothing non-finite can match, and it's cheaper to say so up front than to let NaNs through the comparisons
+	if (!PoseMaths::IsFinite(relative_transform_) || !PoseMaths::IsFinite(camera_transforms_[0]) || !PoseMaths::IsFinite(camera_transforms_[1]))
+	{
+
+		matched_solution_ = -1;
+		return false;
+
+	}
+
+	// Levels with several valid solutions look the relative transform up in the index
+	if (!solution_index_.IsEmpty())
+	{
+
+		matched_solution_ = solution_index_.FindMatch(relative_transform_, definition_.solution_translation_tolerance, definition_.solution_rotation_tolerance);
+		return matched_solution_ >= 0;
+
+	}
+
+	// Levels with fitted bounds use those instead of the fixed tolerances
+	if (!match_bounds_.empty())
+	{
+
+		// Objects whose markers are out of view can't be checked, and don't stop the rest matching
+		for (size_t object = 0; object < match_bounds_.size() && object < object_handles_.size(); object++)
+		{
+
+			if (Object((int)object).is_active()
+				&& !IsWithinBounds(GetCanonicalTransform((int)object), transforms_[object], match_bounds_[object]))
+			{
+
+				return false;
+
+			}
+
+		}
+
+		return true;
+
+	}
+
+	// Symmetric shapes are compared in whichever of their equivalent poses is closest to the reference
+	gef::Matrix44 transform_0 = GetCanonicalTransform(0);
+	gef::Matrix44 transform_1 = GetCanonicalTransform(1);
+
+	// Every row of both objects has to be close enough to the reference values, ignoring the last column
+	// The translation row is looser for marker 02's object and tighter for marker 01's
+	return PoseMaths::IsWithinTolerance(transform_0, transforms_[0], tolerance_value_, tolerance_value_ * 4)
+		&& PoseMaths::IsWithinTolerance(transform_1, transforms_[1], tolerance_value_, tolerance_value_ / 4);
+
+}
+
+void Level::UpdateCameraTransforms()
+{
+
+	// Both marker objects are always checked, along with every object that has fitted bounds
+	size_t num_checked = match_bounds_.size() > 2 ? match_bounds_.size() : 2;
+	num_checked = num_checked < object_handles_.size() ? num_checked : object_handles_.size();
+	camera_transforms_.resize(num_checked);
+
+	// Inactive objects aren't checked, so theirs are left as they were
+	for (size_t object = 0; object < num_checked; object++)
+	{
+
+		GameObject& game_object = Object((int)object);
+		if (game_object.is_active())
+		{
+
+			camera_transforms_[object] = GetMatchingTransform(game_object);
+
+		}
+
+	}
+
+}
+
+gef::Matrix44 Level::GetCanonicalTransform(int object)
+{
+
+	return symmetries_[object].Canonicalise(camera_transforms_[object], transforms_[object]);
+
+}
+
+bool Level::IsWithinBounds(const gef::Matrix44& transform, const gef::Matrix44& reference, const MatchBounds& bounds)
+{
+
+	// Sum the squared distances along each axis of the ellipsoid, i.e. the squared Mahalanobis distance
+	float distance_squared = 0.0f;
+
+	for (int row = 0; row < 4; row++)
+	{
+
+		gef::Vector4 values = transform.GetRow(row);
+		gef::Vector4 reference_values = reference.GetRow(row);
+
+		float dx = (values.x() - reference_values.x()) / bounds.sigma[row * 3];
+		float dy = (values.y() - reference_values.y()) / bounds.sigma[row * 3 + 1];
+		float dz = (values.z() - reference_values.z()) / bounds.sigma[row * 3 + 2];
+
+		distance_squared += dx * dx + dy * dy + dz * dz;
+
+	}
+
+	return distance_squared < MATCH_CHI_SQUARED;
+
+}
+
+void Level::BuildSolutionIndex(const LevelDefinition& definition)
+{
+
+	solution_index_.Clear();
+	matched_solution_ = -1;
+
+	for (size_t solution = 0; solution < definition.solutions.size(); solution++)
+	{
+
+		solution_index_.Add(definition.solutions[solution], (int)solution);
+
+	}
+
+	solution_index_.Build();
+
+}
+
+void Level::BeginCapture()
+{
+
+	capture_.Begin((int)object_handles_.size() < 2 ? 0 : 2, CAPTURE_NUM_FRAMES);
+
+}
+
+void Level::FinishCapture()
+{
+
+	std::vector<gef::Matrix44> mean_transforms;
+	std::vector<MatchBounds> bounds;
+
+	if (capture_.Fit(mean_transforms, bounds))
+	{
+
+		// Use the new reference transforms straight away
+		definition_.reference_transforms = mean_transforms;
+		definition_.match_bounds = bounds;
+		transforms_ = mean_transforms;
+		match_bounds_ = bounds;
+
+		// Save them to the level file, and remember its contents so hot reloading doesn't apply them again
+		if (definition_.Save(definition_file_.c_str()))
+		{
+
+#ifdef HOT_RELOAD_LEVELS
+			std::string text;
+			if (LevelDefinition::ReadFile(definition_file_.c_str(), text))
+			{
+
+				definition_hash_ = LevelDefinition::Hash(text);
+				GetFileStamp(definition_file_.c_str(), definition_time_, definition_size_);
+
+			}
+#endif
+
+		}
+
+	}
+
+	capture_.Cancel();
+
+}
+
+void Level::SampleMarkers(bool& marker_02_found, bool& marker_01_found, bool is_new_sample)
+{
+
+	// If marker 02 is found, we will be drawing the corresponding mesh
+	// Marker 02 is being used as the origin in a shared coordinate system
+	// so there's no point evaluating marker 01 if marker 02 has not been found
+	gef::Matrix44 marker02_transform_;
+	bool marker02_usable = false;
+
+	if (sampleIsMarkerFound(Object(0).get_marker()))
+	{
+
+		// Get marker 02's position
+		sampleGetTransform(Object(0).get_marker(), &marker02_transform_);
+
+		// Tracking that's just been lost can report a garbage or collapsed transform, which would poison
+		// everything localised against it, so treat that the same as the marker not being found
+		marker02_usable = PoseMaths::IsFinite(marker02_transform_) && PoseMaths::IsInvertible(marker02_transform_);
+
+	}
+
+	// Time the poses are for, so they can be extrapolated on frames the tracking library skipped
+	gef::UInt64 sample_time = Profiler::GetTime();
+
+	if (marker02_usable)
+	{
+
+		// Fuse the last few observations, rather than using this frame's on its own
+		// Frames the tracking library skipped report the same pose again, which would be counted twice,
+		// so move the fused pose on by its velocity instead
+		if (is_new_sample || marker02_filter_.GetNumObservations() == 0)
+		{
+
+			marker02_filter_.Add(marker02_transform_, sample_time);
+			marker02_filter_.GetFused(marker02_transform_);
+
+		}
+		else
+		{
+
+			marker02_filter_.GetExtrapolated(sample_time, marker02_transform_);
+
+		}
+
+		// Set transform for the corresponding mesh
+		Object(0).set_marker_transform(marker02_transform_);
+
+		// When anchored, marker 02 is applied once by the view rather than by every object
+		if (world_anchor_)
+		{
+
+			view_transform_ = marker02_transform_;
+
+		}
+
+		Object(0).set_active();
+
+		// Marker 02 has been found, so set to true
+		marker_02_found = true;
+
+		gef::Matrix44 marker01_local_transform;
+		marker01_local_transform.SetIdentity();
+		bool marker01_usable = false;
+
+		// Now we check for marker 01
+		if (sampleIsMarkerFound(Object(1).get_marker()))
+		{
+
+			gef::Matrix44 marker01_transform_;
+
+			// Get marker 01 position
+			sampleGetTransform(Object(1).get_marker(), &marker01_transform_);
+
+			// Garbage is caught by the localisation, but it mustn't get into the filter first
+			if (PoseMaths::IsFinite(marker01_transform_))
+			{
+
+				if (is_new_sample || marker01_filter_.GetNumObservations() == 0)
+				{
+
+					marker01_filter_.Add(marker01_transform_, sample_time);
+					marker01_filter_.GetFused(marker01_transform_);
+
+				}
+				else
+				{
+
+					marker01_filter_.GetExtrapolated(sample_time, marker01_transform_);
+
+				}
+
+			}
+
+			// Perform localisation calculations
+			// Invert marker 02's transform then multiply by marker 01's transform to get the local transform we need,
+			// which fails if marker 01's transform is garbage in the same way
+			marker01_usable = PoseMaths::GetLocalTransform(marker01_transform_, marker02_transform_, marker01_local_transform);
+
+		}
+
+		if (marker01_usable)
+		{
+
+			// cube 3 is now active
+			Object(1).set_active();
+
+			// Marker has been found
+			marker_01_found = true;
+
+			// Set marker 01's corresponding mesh's transforms
+			Object(1).set_marker_transform(marker02_transform_);
+
+			Object(1).set_local_transform(marker01_local_transform);
+
+			// Keep the relative transform for matching against the level's solutions
+			// The drawn poses stay in the tracking library's pinhole camera so they line up with the distorted camera image,
+			// but matching takes the bias from the lens distortion out of both markers first
+			relative_transform_ = marker01_local_transform;
+			if (camera_calibration_)
+			{
+
+				gef::Matrix44 matching02_transform = marker02_transform_;
+				gef::Matrix44 matching01_transform = marker01_local_transform * marker02_transform_;
+				camera_calibration_->CorrectTransform(matching02_transform);
+				camera_calibration_->CorrectTransform(matching01_transform);
+
+				if (!PoseMaths::GetLocalTransform(matching01_transform, matching02_transform, relative_transform_))
+				{
+
+					relative_transform_ = marker01_local_transform;
+
+				}
+
+			}
+
+		}
+		else
+		{
+
+			Object(1).set_inactive();
+			marker01_filter_.Clear();
+
+		}
+
+	}
+	else
+	{
+
+		Object(1).set_inactive();
+		Object(0).set_inactive();
+		marker02_filter_.Clear();
+		marker01_filter_.Clear();
+
+	}
+
+	// Keep what the filters were doing for the pose history
+	history_frame_.time = sample_time;
+	history_frame_.is_tracked = is_new_sample;
+	history_frame_.filter_observations[0] = marker02_filter_.GetNumObservations();
+	history_frame_.filter_observations[1] = marker01_filter_.GetNumObservations();
+	history_frame_.linear_speeds[0] = marker02_filter_.GetLinearSpeed();
+	history_frame_.linear_speeds[1] = marker01_filter_.GetLinearSpeed();
+	history_frame_.angular_speeds[0] = marker02_filter_.GetAngularSpeed();
+	history_frame_.angular_speeds[1] = marker01_filter_.GetAngularSpeed();
+
 }
 
-// Clean up the scenes
-Level::~Level()
+bool Level::NeedsTracking()
 {
 
-	delete first_scene_;
-	first_scene_ = NULL;
+	// Until both markers have been seen for a while we don't know how they're moving, and can't extrapolate
+	if (!marker02_filter_.HasVelocity() || !marker01_filter_.HasVelocity())
+	{
+
+		return true;
+
+	}
 
-	delete second_scene_;
-	second_scene_ = NULL;
+	return marker02_filter_.GetLinearSpeed() > TRACKING_MOTION_SPEED || marker01_filter_.GetLinearSpeed() > TRACKING_MOTION_SPEED
+		|| marker02_filter_.GetAngularSpeed() > TRACKING_MOTION_ANGULAR_SPEED || marker01_filter_.GetAngularSpeed() > TRACKING_MOTION_ANGULAR_SPEED;
 
 }
 
-bool Level::InitLevel(int level_identifier, float tolerance_value, gef::Platform* platform_)
+void Level::ReplayMarkers(const gef::Matrix44* marker_transforms, int num_markers)
 {
 
-	level_id_ = level_identifier;
-	tolerance_value_ = tolerance_value;
+	// The first object's marker is the origin, as when tracking
+	int origin_marker = Object(0).get_marker();
+	if (origin_marker >= num_markers || !PoseMaths::IsFinite(marker_transforms[origin_marker]) || !PoseMaths::IsInvertible(marker_transforms[origin_marker]))
+	{
+
+		return;
+
+	}
+
+	const gef::Matrix44& origin_transform = marker_transforms[origin_marker];
+
+	if (world_anchor_)
+	{
+
+		view_transform_ = origin_transform;
+
+	}
+
+	// Localise each marker once, however many objects are on it
+	marker_local_transforms_.resize(num_markers);
+	markers_usable_.resize(num_markers);
 
-	// Set up for the first level (circle within a ring)
-	if (level_id_ == 1)
+	for (int marker = 0; marker < num_markers; marker++)
 	{
 
-		num_transforms_ = 2;
+		markers_usable_[marker] = marker == origin_marker
+			|| PoseMaths::GetLocalTransform(marker_transforms[marker], origin_transform, marker_local_transforms_[marker]);
 
-		gef::Matrix44 transform;
+	}
+
+	for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
+	{
+
+		GameObject* game_object = game_objects_.Get(*it);
+		int marker = game_object->get_marker();
 
-		// Set the data of the origin transform (marker 02)
-		transform.SetRow(0, gef::Vector4(0.067f, -0.003f, -0.002f, 0.0f));
-		transform.SetRow(1, gef::Vector4(-0.003f, -0.004f, -0.067f, 0.0f));
-		transform.SetRow(2, gef::Vector4(0.004f, 0.067f, -0.005f, 0.0f));
-		transform.SetRow(3, gef::Vector4(0.012f, 0.045f, -0.504f, 1.0f));
+		if (marker >= num_markers || !markers_usable_[marker])
+		{
 
-		transforms_.push_back(transform);
+			continue;
 
-		// Then set the data of the other transform (marker 01)
-		transform.SetRow(0, gef::Vector4(0.05f, -0.003f, -0.001f, 0.0f));
-		transform.SetRow(1, gef::Vector4(-0.002f, -0.005f, -0.05f, 0.0f));
-		transform.SetRow(2, gef::Vector4(0.003f, 0.05f, -0.005f, 0.0f));
-		transform.SetRow(3, gef::Vector4(0.013f, 0.04f, -0.5f, 1.0f));
+		}
 
-		transforms_.push_back(transform);
+		game_object->set_marker_transform(origin_transform);
 
-		// Load the meshes from the scene files
-		first_scene_ = new gef::Scene();
-		first_scene_->ReadSceneFromFile(*platform_, "pipe1.scn");
-		first_scene_->CreateMaterials(*platform_); 
+		if (marker != origin_marker)
+		{
 
-		second_scene_ = new gef::Scene();
-		second_scene_->ReadSceneFromFile(*platform_, "cylinder1.scn");
-		second_scene_->CreateMaterials(*platform_);
+			game_object->set_local_transform(marker_local_transforms_[marker]);
 
-		// Create game objects to hold the meshes
-		GameObject mesh_marker_02_;
-		GameObject mesh_marker_01_;
+		}
 
-		// Set the first mesh to use the default cube mesh and marker ID 1 (aka 02)
-		mesh_marker_02_.set_mesh(first_scene_->CreateMesh(*platform_, first_scene_->mesh_data.front()));
-		mesh_marker_02_.set_marker(1);
-		mesh_marker_02_.set_position(0.0f, 0.0f, 0.3f);
-		mesh_marker_02_.set_rotation(-0.785f, 0.0f, 0.0f);
+		game_object->set_active();
 
-		// Set the second mesh to also use the default cube mesh and marker ID 0 (aka 01)
-		mesh_marker_01_.set_mesh(second_scene_->CreateMesh(*platform_, second_scene_->mesh_data.front()));
-		mesh_marker_01_.set_marker(0);
-		mesh_marker_01_.set_local();
-		mesh_marker_01_.set_position(0.2f, 0.0f, 0.32f);
-		mesh_marker_01_.set_rotation(-0.785f, 0.0f, 0.0f);
+	}
 
-		// Scale the meshes down to a reasonable size
-		// 0.059f allows the cubes to be correctly fitted to the axis aligned bounding boxes
-		float marker_scale_factor = 0.05f;
-		gef::Matrix44 scale_matrix_geometry;
-		gef::Matrix44 translation_matrix;
-		gef::Matrix44 final_transform;
-		mesh_marker_02_.set_scale(marker_scale_factor);
-		mesh_marker_01_.set_scale(marker_scale_factor * 1.35f);
+	// Keep the relative transform for matching against the level's solutions
+	if (object_handles_.size() > 1 && Object(1).get_marker() < num_markers && Object(1).get_marker() != origin_marker)
+	{
 
-		game_objects_.push_back(mesh_marker_02_);
-		game_objects_.push_back(mesh_marker_01_);
+		relative_transform_ = marker_local_transforms_[Object(1).get_marker()];
 
 	}
-	// Set up for the second level (two hemispheres)
-	else if (level_id_ == 2)
+
+	// Replayed poses are given every frame rather than extrapolated
+	history_frame_.is_tracked = true;
+
+}
+
+void Level::ReadyForUpdate()
+{
+
+	for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
 	{
 
-		num_transforms_ = 2;
+		game_objects_.Get(*it)->set_inactive();
 
-		gef::Matrix44 transform;
+	}
 
-		// Set the data of the origin transform (marker 02)
-		transform.SetRow(0, gef::Vector4(0.0f, 0.007f, -0.013f, 0.0f));
-		transform.SetRow(1, gef::Vector4(-0.015f, 0.0f, 0.0f, 0.0f));
-		transform.SetRow(2, gef::Vector4(0.0f, 0.013f, 0.007f, 0.0f));
-		transform.SetRow(3, gef::Vector4(-0.005f, 0.06f, -0.763f, 1.0f));
+}
 
-		transforms_.push_back(transform);
+void Level::Render(gef::Renderer3D* renderer_3d_, const gef::Matrix44& view, const gef::Matrix44& projection, Profiler* profiler_)
+{
 
-		// Then set the data of the other transform (marker 01)
-		transform.SetRow(0, gef::Vector4(0.0f, -0.005f, 0.009f, 0.0f));
-		transform.SetRow(1, gef::Vector4(0.01f, 0.0f, 0.0f, 0.0f));
-		transform.SetRow(2, gef::Vector4(0.0f, 0.009f, 0.005f, 0.0f));
-		transform.SetRow(3, gef::Vector4(-0.046f, 0.041f, -0.501f, 1.0f));
+	render_queue_.Clear();
+	render_queue_.Reserve((int)object_handles_.size());
 
-		transforms_.push_back(transform);
+	// Culling only affects drawing, objects are still evaluated by CheckTransforms
+	frustum_.SetFromMatrix(view * projection);
 
-		// Load the meshes from the scene files
-		first_scene_ = new gef::Scene();
-		first_scene_->ReadSceneFromFile(*platform_, "hemi.scn");
-		first_scene_->CreateMaterials(*platform_);
+	// Scale from view space height to the fraction of the screen height covered, for LOD selection
+	float projection_scale = projection.GetRow(1).y() * lod_scale_;
 
-		second_scene_ = new gef::Scene();
-		second_scene_->ReadSceneFromFile(*platform_, "hemi.scn");
-		second_scene_->CreateMaterials(*platform_);
+	// Emit draws for the meshes according to their active status, nothing is drawn without the origin marker
+	if (Object(0).is_active())
+	{
 
-		// Create game objects to hold the meshes
-		GameObject mesh_marker_02_;
-		GameObject mesh_marker_01_;
+		for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
+		{
 
-		// Set the first mesh to use the default cube mesh and marker ID 1 (aka 02)
-		mesh_marker_02_.set_mesh(first_scene_->CreateMesh(*platform_, first_scene_->mesh_data.front()));
-		mesh_marker_02_.set_marker(1);
-		mesh_marker_02_.set_position(0.0f, 0.0f, 0.1f);
-		mesh_marker_02_.set_rotation(0.0f, 0.0f, 1.57f);
+			GameObject* game_object = game_objects_.Get(*it);
+			if (game_object->is_active())
+			{
 
-		// Set the second mesh to also use the default cube mesh and marker ID 0 (aka 01)
-		mesh_marker_01_.set_mesh(second_scene_->CreateMesh(*platform_, second_scene_->mesh_data.front()));
-		mesh_marker_01_.set_marker(0);
-		mesh_marker_01_.set_local();
-		mesh_marker_01_.set_position(0.05f, 0.0f, 0.2f);
-		mesh_marker_01_.set_rotation(0.0f, 0.0f, 0.0f);
+				SubmitObject(*game_object, view, projection_scale, profiler_);
 
-		// Scale the meshes down to a reasonable size
-		// 0.059f allows the cubes to be correctly fitted to the axis aligned bounding boxes
-		float marker_scale_factor = 0.01f;
-		gef::Matrix44 scale_matrix_geometry;
-		gef::Matrix44 translation_matrix;
-		gef::Matrix44 final_transform;
-		mesh_marker_02_.set_scale(marker_scale_factor * 1.5f);
-		mesh_marker_01_.set_scale(marker_scale_factor);
+			}
 
-		game_objects_.push_back(mesh_marker_02_);
-		game_objects_.push_back(mesh_marker_01_);
+		}
 
 	}
 
-	return false;
+	// Sort so that draws sharing a material and mesh are submitted together
+	render_queue_.Sort();
+	render_queue_.Submit(renderer_3d_);
 
 }
 
-bool Level::GetUpdate()
+void Level::SubmitObject(GameObject& game_object, const gef::Matrix44& view, float projection_scale, Profiler* profiler_)
 {
 
-	// Check that the meshes are active before their positions are updated
-	if (game_objects_[0].is_active())
+	const gef::Mesh* mesh = game_object.mesh();
+	if (!mesh)
 	{
 
-		game_objects_[0].update();
+		return;
 
 	}
 
-	// This will only evaluate as true if the 0th game object is also active
-	if (game_objects_[1].is_active())
+	// Move the mesh's bounding sphere into world space
+	const gef::Matrix44& transform = game_object.transform();
+	gef::Vector4 centre = mesh->bounding_sphere().position().Transform(transform);
+
+	// Our objects are scaled uniformly, but take the largest axis in case they aren't
+	float scale = transform.GetRow(0).Length();
+	if (transform.GetRow(1).Length() > scale)
 	{
 
-		game_objects_[1].update();
+		scale = transform.GetRow(1).Length();
 
-		// Hence we can check transforms here
-		return CheckTransforms();
+	}
+	if (transform.GetRow(2).Length() > scale)
+	{
+
+		scale = transform.GetRow(2).Length();
 
 	}
 
-	return false;
+	float radius = mesh->bounding_sphere().radius() * scale;
+
+	if (frustum_.IsSphereVisible(centre, radius))
+	{
+
+		// Pick the LOD from how much of the screen the bounding sphere covers
+		gef::Vector4 view_centre = centre.Transform(view);
+		if (view_centre.z() < 0.0f)
+		{
+
+			game_object.select_lod(2.0f * radius * projection_scale / -view_centre.z());
+
+		}
+
+		render_queue_.AddCommand(game_object.mesh(), &transform);
+		profiler_->AddCount(PROFILER_COUNTER_OBJECTS_VISIBLE, 1);
+
+	}
+	else
+	{
+
+		profiler_->AddCount(PROFILER_COUNTER_OBJECTS_CULLED, 1);
+
+	}
 
 }
 
-bool Level::CheckTransforms()
+gef::Scene* Level::LoadScene(gef::Platform* platform_, const char* file_name, const char* lod_file_name)
 {
 
-	// Counter keeps track of the number of values that are close enough to the reference value
-	int counter = 0;
+	gef::Scene* scene = new gef::Scene();
 
-	float local_tolerance_value = tolerance_value_;
+	// The baked LOD scene already holds every LOD, so only simplify if it's missing
+	if (!scene->ReadSceneFromFile(*platform_, lod_file_name))
+	{
 
-	gef::Vector4 comparisonVector = gef::Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+		scene->ReadSceneFromFile(*platform_, file_name);
+		MeshSimplifier::AddLods(scene);
 
-	// Loop through each row of the first matrix
-	for (int row = 0; row < 4; row++)
+	}
+
+	return scene;
+
+}
+
+bool Level::BakeSymmetries(gef::Platform* platform_, int level_identifier, float tolerance_value)
+{
+
+	LevelDefinition definition;
+	gef::UInt32 hash;
+	if (!ReadDefinition(level_identifier, tolerance_value, definition, hash))
 	{
 
-		// Construct a vector using the reference transform and game object transform
-		comparisonVector = gef::Vector4(
-			abs(game_objects_[0].transform().GetRow(row).x() - transforms_[0].GetRow(row).x()),
-			abs(game_objects_[0].transform().GetRow(row).y() - transforms_[0].GetRow(row).y()),
-			abs(game_objects_[0].transform().GetRow(row).z() - transforms_[0].GetRow(row).z()),
-			0.0f
-		);
+		return false;
+
+	}
+
+	for (std::vector<ObjectDefinition>::iterator it = definition.objects.begin(); it != definition.objects.end(); ++it)
+	{
 
-		if (row == 3)
+		gef::Scene* scene = LoadScene(platform_, it->scene_file.c_str(), it->lod_scene_file.c_str());
+		if (scene->mesh_data.empty())
 		{
 
-			local_tolerance_value *= 4;
+			delete scene;
+			return false;
 
 		}
 
-		// Check each value to the tolerance value (except for values in the last column)
-		if (comparisonVector.x() < local_tolerance_value
-			&& comparisonVector.y() < local_tolerance_value
-			&& comparisonVector.z() < local_tolerance_value)
-		{
+		// The first mesh is the full resolution one, which is what the game works symmetries out from too
+		ShapeSymmetry symmetry;
+		symmetry.Compute(scene->mesh_data.front());
+		it->symmetry_axis = symmetry.GetAxis();
+		it->symmetry_order = symmetry.GetOrder();
 
-			// Increment the counter whenever a row is within scope of the correct values
-			counter++;
+		delete scene;
 
-		}
+	}
+
+	return definition.Save(LevelDefinition::GetFileName(level_identifier).c_str());
+
+}
+
+int Level::CreateMeshes(gef::Platform* platform_, gef::Scene* scene)
+{
+
+	int first_mesh = (int)meshes_.size();
+
+	// The scene's mesh data runs from the full resolution mesh to the coarsest LOD, as AddLods leaves it whether it ran at load time or when the LOD file was baked
+	int lod = 0;
+	for (std::list<gef::MeshData>::iterator it = scene->mesh_data.begin(); it != scene->mesh_data.end() && lod < MAX_MESH_LODS; ++it, ++lod)
+	{
+
+		meshes_.push_back(scene->CreateMesh(*platform_, *it));
 
 	}
 
-	local_tolerance_value = tolerance_value_;
+	return first_mesh;
 
-	for (int row = 0; row < 4; row++)
+}
+
+void Level::SetMeshLods(GameObject& game_object, int first_mesh, int last_mesh)
+{
+
+	game_object.clear_lod_meshes();
+
+	for (int mesh = first_mesh; mesh < last_mesh; mesh++)
 	{
 
-		// Construct a vector using the reference transform and game object transform
-		comparisonVector = gef::Vector4(
-			abs(game_objects_[1].transform().GetRow(row).x() - transforms_[1].GetRow(row).x()),
-			abs(game_objects_[1].transform().GetRow(row).y() - transforms_[1].GetRow(row).y()),
-			abs(game_objects_[1].transform().GetRow(row).z() - transforms_[1].GetRow(row).z()),
-			0.0f
-		);
+		game_object.set_lod_mesh(mesh - first_mesh, meshes_[mesh]);
 
-		if (row == 3)
-		{
+	}
 
-			local_tolerance_value /= 4;
+}
 
-		}
+void Level::RecordHistory(gef::UInt32 frame, bool is_matched)
+{
 
-		// Check each value to the tolerance value (except for values in the last column)
-		if (comparisonVector.x() < local_tolerance_value
-			&& comparisonVector.y() < local_tolerance_value
-			&& comparisonVector.z() < local_tolerance_value)
-		{
+	if (IsRewinding())
+	{
 
-			// Increment the counter whenever a row is within scope of the correct values
-			counter++;
+		return;
 
-		}
+	}
+
+	// Everything recorded has already been worked out this frame, so this only gathers it together for the copy
+	history_frame_.frame = frame;
+	for (int object = 0; object < POSE_HISTORY_OBJECTS && object < (int)object_handles_.size(); object++)
+	{
+
+		GameObject& game_object = Object(object);
+		history_frame_.is_active[object] = game_object.is_active();
+		history_frame_.object_transforms[object] = game_object.transform();
+		history_frame_.camera_transforms[object] = GetCameraTransform(object);
 
 	}
+	history_frame_.view_transform = view_transform_;
+	history_frame_.relative_transform = relative_transform_;
+	history_frame_.is_matched = is_matched;
+	history_frame_.matched_solution = matched_solution_;
+
+	pose_history_.Record(history_frame_);
+
+}
+
+bool Level::BeginRewind()
+{
 
-	// If all rows are close enough to the correct value, return true
-	if (counter == 8)
+	if (pose_history_.GetNumFrames() == 0)
 	{
 
-		return true;
+		return false;
 
 	}
 
-	// Else return false
-	return false;
+	// The game's paused while rewinding, so there's time to write the history out
+	sceIoMkdir(LEVEL_DEFINITION_PATH, 0777);
+	pose_history_.WriteTrace(POSE_HISTORY_TRACE_FILE);
+
+	rewind_offset_ = 0;
+	return true;
 
 }
 
-void Level::SampleMarkers(bool& marker_02_found, bool& marker_01_found)
+void Level::Rewind(int num_frames)
 {
 
-	// If marker 02 is found, we will be drawing the corresponding mesh
-	// Marker 02 is being used as the origin in a shared coordinate system
-	// so there's no point evaluating marker 01 if marker 02 has not been found
-	if (sampleIsMarkerFound(game_objects_[0].get_marker()))
+	if (!IsRewinding())
 	{
 
-		gef::Matrix44 marker02_transform_;
+		return;
 
-		// Get marker 02's position
-		sampleGetTransform(game_objects_[0].get_marker(), &marker02_transform_);
+	}
 
-		// Set transform for the corresponding mesh
-		game_objects_[0].set_marker_transform(marker02_transform_);
-		game_objects_[0].set_active();
+	rewind_offset_ += num_frames;
+	if (rewind_offset_ >= pose_history_.GetNumFrames())
+	{
 
-		// Marker 02 has been found, so set to true
-		marker_02_found = true;
+		rewind_offset_ = pose_history_.GetNumFrames() - 1;
 
-		// Now we check for marker 01
-		if (sampleIsMarkerFound(game_objects_[1].get_marker()))
-		{
+	}
+	else if (rewind_offset_ < 0)
+	{
 
-			gef::Matrix44 marker01_transform_;
+		rewind_offset_ = 0;
 
-			// Get marker 01 position
-			sampleGetTransform(game_objects_[1].get_marker(), &marker01_transform_);
+	}
 
-			// cube 3 is now active
-			game_objects_[1].set_active();
+}
 
-			// Marker has been found
-			marker_01_found = true;
+void Level::ShowRewindFrame()
+{
 
-			// Perform localisation calculations
-			gef::Matrix44 inv_marker02_transform;
-			inv_marker02_transform.SetIdentity();
-			gef::Matrix44 marker01_local_transform;
-			marker01_local_transform.SetIdentity();
+	if (!IsRewinding())
+	{
 
-			// Invert marker 02's transform then multiply by marker 01's transform to get the local transform we need
-			inv_marker02_transform.Inverse(marker02_transform_);
-			marker01_local_transform = marker01_transform_ * inv_marker02_transform;
+		return;
 
-			// Set marker 01's corresponding mesh's transforms
-			game_objects_[1].set_marker_transform(marker02_transform_);
+	}
+
+	const PoseHistoryFrame& frame = GetRewindFrame();
+
+	// The objects' transforms are rebuilt by the next update once rewinding ends, so they can be overwritten here
+	for (int object = 0; object < POSE_HISTORY_OBJECTS && object < (int)object_handles_.size(); object++)
+	{
 
-			game_objects_[1].set_local_transform(marker01_local_transform);
+		GameObject& game_object = Object(object);
+		if (frame.is_active[object])
+		{
+
+			game_object.set_active();
+			game_object.set_transform(frame.object_transforms[object]);
+			camera_transforms_[object] = frame.camera_transforms[object];
 
 		}
 		else
 		{
 
-			game_objects_[1].set_inactive();
+			game_object.set_inactive();
 
 		}
 
 	}
-	else
+
+	// Any other objects weren't recorded, so they aren't drawn
+	for (int object = POSE_HISTORY_OBJECTS; object < (int)object_handles_.size(); object++)
 	{
 
-		game_objects_[1].set_inactive();
-		game_objects_[0].set_inactive();
+		Object(object).set_inactive();
 
 	}
 
+	view_transform_ = frame.view_transform;
+
 }
 
-void Level::ReadyForUpdate()
+void Level::GetRewindRowDeltas(int object, float row_deltas[4])
 {
 
-	game_objects_[0].set_inactive();
-	game_objects_[1].set_inactive();
+	for (int row = 0; row < 4; row++)
+	{
 
-}
+		row_deltas[row] = 0.0f;
 
-void Level::Render(gef::Renderer3D* renderer_3d_)
-{
+	}
 
-	// Render the meshes according to their active status
-	if (game_objects_[0].is_active())
+	if (!IsRewinding() || object >= POSE_HISTORY_OBJECTS || object >= (int)transforms_.size() || object >= (int)symmetries_.size())
 	{
 
-		renderer_3d_->DrawMesh(game_objects_[0]);
+		return;
 
-		if (game_objects_[1].is_active())
-		{
+	}
 
-			renderer_3d_->DrawMesh(game_objects_[1]);
+	// Only worked out for the frame being looked at, so recording costs nothing extra
+	const PoseHistoryFrame& frame = GetRewindFrame();
+	gef::Matrix44 canonical = symmetries_[object].Canonicalise(frame.camera_transforms[object], transforms_[object]);
 
-		}
+	for (int row = 0; row < 4; row++)
+	{
+
+		float delta_x = abs(canonical.GetRow(row).x() - transforms_[object].GetRow(row).x());
+		float delta_y = abs(canonical.GetRow(row).y() - transforms_[object].GetRow(row).y());
+		float delta_z = abs(canonical.GetRow(row).z() - transforms_[object].GetRow(row).z());
+
+		row_deltas[row] = delta_x > delta_y ? delta_x : delta_y;
+		row_deltas[row] = delta_z > row_deltas[row] ? delta_z : row_deltas[row];
 
 	}
 
@@ -377,21 +1349,64 @@ void Level::Render(gef::Renderer3D* renderer_3d_)
 bool Level::MarkersAreActive()
 {
 
-	return game_objects_[0].is_active() && game_objects_[1].is_active();
+	return Object(0).is_active() && Object(1).is_active();
 
 }
 
 void Level::ResetLevel()
 {
 
+	capture_.Cancel();
+
 	transforms_.clear();
-	game_objects_.clear();
+	match_bounds_.clear();
+	solution_index_.Clear();
+	matched_solution_ = -1;
+	game_objects_.Clear();
+	object_handles_.clear();
+	camera_transforms_.clear();
+	symmetries_.clear();
+
+	// Frames from another level would be checked against the wrong reference transforms,
+	// but hot reloading a level's reference transforms in place keeps its history
+	pose_history_.Clear();
+	rewind_offset_ = -1;
+
+	for (std::vector<gef::Mesh*>::iterator it = meshes_.begin(); it != meshes_.end(); ++it)
+	{
+
+		delete *it;
+
+	}
+	meshes_.clear();
+
+	// Scenes go back to the streamer's cache, if there is one, so the level can be played again without reading them
+	for (std::vector<LevelScene>::iterator it = scenes_.begin(); it != scenes_.end(); ++it)
+	{
+
+		if (it->scene && level_streamer_)
+		{
+
+			level_streamer_->ReleaseScene(it->file_name, it->scene);
+
+		}
+		else
+		{
 
-	delete first_scene_;
-	first_scene_ = NULL;
+			delete it->scene;
 
-	delete second_scene_;
-	second_scene_ = NULL;
+		}
+
+	}
+	scenes_.clear();
+
+	for (std::vector<LevelScene>::iterator it = preloaded_scenes_.begin(); it != preloaded_scenes_.end(); ++it)
+	{
+
+		delete it->scene;
+
+	}
+	preloaded_scenes_.clear();
 
 }
 
@@ -405,7 +1420,67 @@ gef::Matrix44* Level::GetTransform(int id)
 GameObject* Level::GetGameObject(int id)
 {
 
-	return &game_objects_[id];
+	return game_objects_.Get(object_handles_[id]);
+
+}
+
+gef::Matrix44 Level::GetCameraTransform(int id)
+{
+
+	if (id < (int)camera_transforms_.size())
+	{
+
+		return camera_transforms_[id];
+
+	}
+
+	return GetMatchingTransform(Object(id));
+
+}
+
+gef::Matrix44 Level::GetMatchingTransform(GameObject& game_object)
+{
+
+	// Objects are drawn with the tracking library's pinhole poses, to line up with the distorted camera image,
+	// so only the transforms they're matched with are corrected for the lens
+	gef::Matrix44 transform = game_object.get_camera_transform();
+	if (camera_calibration_)
+	{
+
+		camera_calibration_->CorrectTransform(transform);
+
+	}
+
+	return transform;
+
+}
+
+void Level::SetWorldAnchor(bool value)
+{
+
+	world_anchor_ = value;
+	view_transform_.SetIdentity();
+
+	for (std::vector<GameObjectHandle>::iterator it = object_handles_.begin(); it != object_handles_.end(); ++it)
+	{
+
+		game_objects_.Get(*it)->set_anchored(value);
+
+	}
+
+}
+
+GameObject* Level::GetGameObject(GameObjectHandle handle)
+{
+
+	return game_objects_.Get(handle);
+
+}
+
+GameObjectHandle Level::GetGameObjectHandle(int id)
+{
+
+	return object_handles_[id];
 
 }
 
@@ -2,6 +2,25 @@
 #define LEVEL_H
 
 #include <vector>
+#include <string>
+#include <assert.h>
+#include <gef.h>
+#include "render_queue.h"
+#include "frustum.h"
+#include "level_definition.h"
+#include "pose_capture.h"
+#include "pose_index.h"
+#include "shape_symmetry.h"
+#include "game_object_pool.h"
+#include "pose_filter.h"
+#include "pose_history.h"
+
+// Speeds above which the markers are tracked every frame rather than extrapolated, in units and radians per second
+#define TRACKING_MOTION_SPEED 0.05f
+#define TRACKING_MOTION_ANGULAR_SPEED 0.5f
+
+// File the pose history is written to when rewinding starts, so what led up to a failed match can be looked at off the console
+#define POSE_HISTORY_TRACE_FILE LEVEL_DEFINITION_PATH "pose_history.pose"
 
 // GEF Forward declarations
 namespace gef
@@ -11,12 +30,18 @@ namespace gef
 	class Renderer3D;
 	class Scene;
 	class Platform;
+	class Mesh;
+	class MeshData;
 
 }
 
 // App specific forward declarations
 class GameObject;
+class Profiler;
 class PrimitiveBuilder;
+class AssetBundle;
+class CameraCalibration;
+class LevelStreamer;
 
 // Level class
 // Holds all data relevant to each level, i.e. transforms to check, game objects to draw on markers, where to draw game objects
@@ -27,40 +52,227 @@ public:
 	Level();
 	~Level();
 
+	// Read the scenes a level uses ahead of initialising it, without touching the GPU
+	// This can be run on another thread, as long as it's finished before InitLevel is called
+	bool PreloadScenes(int level_identifier, float tolerance_value, gef::Platform* platform_);
+	// Build a level's definition from its built-in one and its level file, returning false if there's no such level
+	// The hash is of the level file's contents, or 0 if there isn't one
+	static bool ReadDefinition(int level_identifier, float tolerance_value, LevelDefinition& definition, gef::UInt32& hash);
+	// Read a scene, preferring its baked LOD scene file and otherwise building the LODs at load time
+	// Its materials aren't created, as that needs the GPU, so this can be run on another thread
+	static gef::Scene* LoadScene(gef::Platform* platform_, const char* file_name, const char* lod_file_name);
+	// Work out the symmetry of each of a level's shapes from its full resolution mesh and write them into its level file
+	// This is run by AssetBaker in BAKE_ASSETS builds, so levels load with their symmetries already known
+	static bool BakeSymmetries(gef::Platform* platform_, int level_identifier, float tolerance_value);
 	// Initialise the level based on the level's identifier
 	bool InitLevel(int level_identifier, float tolerance_value, gef::Platform* platform_);
+	// Initialise the level from a definition built in memory, such as a generated stress level, which isn't hot reloaded
+	void InitLevel(const LevelDefinition& definition, gef::Platform* platform_);
+	// Hand the level a scene built in memory, which objects naming it use instead of reading a file
+	// The level takes ownership of it, and it's deleted if the next level initialised doesn't use it
+	void AddScene(const std::string& file_name, gef::Scene* scene);
 	// Reset the level when the level is changed
 	void ResetLevel();
+#ifdef HOT_RELOAD_LEVELS
+	// Check the level file for changes and patch them into the live level, returning true if anything changed
+	// Tuning changes keep the objects' current marker transforms, only structural changes rebuild the level
+	bool HotReload(gef::Platform* platform_);
+#endif
 
+	// Advance the objects in the level by a number of fixed simulation timesteps
+	void StepSimulation(int num_steps = 1);
 	// Update the objects in the level and check their transforms with the reference transforms
-	bool GetUpdate();
+	// Alpha is how far between the last two simulation steps the current frame lies
+	bool GetUpdate(float alpha);
 	// Sample the markers' positions using the Sony sample framework
-	void SampleMarkers(bool& marker_02_found, bool& marker_01_found);
+	// is_new_sample is false when the tracking library skipped this frame, so the poses are the same as last time
+	void SampleMarkers(bool& marker_02_found, bool& marker_01_found, bool is_new_sample = true);
+	// Place the objects from marker transforms given directly rather than by the tracking library, e.g. from a pose trace
+	// Objects are activated if their marker is one of the num_markers given, which are indexed by marker ID
+	void ReplayMarkers(const gef::Matrix44* marker_transforms, int num_markers);
+	// Check whether the markers are moving too quickly, or aren't known well enough, to skip tracking them this frame
+	bool NeedsTracking();
 	// Default objects to inactive before updating
 	void ReadyForUpdate();
-	// Render the objects in the level
-	void Render(gef::Renderer3D* renderer_3d_);
+	// Render the objects in the level that are inside the view frustum
+	void Render(gef::Renderer3D* renderer_3d_, const gef::Matrix44& view, const gef::Matrix44& projection, Profiler* profiler_);
+
+	// Set the bundle scenes are taken from where it has them, which has to outlive the level
+	inline void SetAssetBundle(const AssetBundle* asset_bundle) { asset_bundle_ = asset_bundle; };
+
+	// Set the calibration marker transforms are corrected with, which has to outlive the level
+	inline void SetCameraCalibration(const CameraCalibration* camera_calibration) { camera_calibration_ = camera_calibration; };
+
+	// Set the streamer scenes are taken from and handed back to, which has to outlive the level
+	inline void SetLevelStreamer(LevelStreamer* level_streamer) { level_streamer_ = level_streamer; };
+
+	// Keep the marker objects in the space of the origin marker, with its transform as the view, or in camera space
+	void SetWorldAnchor(bool value);
+	inline bool IsWorldAnchored() { return world_anchor_; };
+	// Get the view transform objects should be rendered with, which is the origin marker's transform when anchored
+	inline const gef::Matrix44& GetViewTransform() { return view_transform_; };
+	// Get a game object's transform in camera space, which is what's matched against the reference transforms
+	// The objects the checks look at have theirs worked out once per update, and the rest are worked out when asked for
+	gef::Matrix44 GetCameraTransform(int id);
+
+	// Scale the screen size used to pick mesh LODs, so values below 1 pick coarser LODs
+	inline void SetLodScale(float lod_scale) { lod_scale_ = lod_scale; };
 
 	// Check if the markers are all in the current camera view
 	bool MarkersAreActive();
 
+	// Start recording the solved configuration, to fit new reference transforms and bounds to
+	void BeginCapture();
+	inline bool IsCapturing() { return capture_.IsCapturing(); };
+	inline int GetCaptureProgress() { return capture_.GetNumRecorded(); };
+
+	// Get the solution matched by the last check, or -1 if none
+	inline int GetMatchedSolution() { return matched_solution_; };
+
+	// Copy this frame's poses, filter state and match result into the pose history, once the objects have been updated
+	// Nothing is recorded while rewinding, so the frames being looked at aren't overwritten
+	void RecordHistory(gef::UInt32 frame, bool is_matched);
+	// Start looking back through the pose history from its newest frame, returning false if it's empty
+	// The history is also written out to POSE_HISTORY_TRACE_FILE
+	bool BeginRewind();
+	inline void EndRewind() { rewind_offset_ = -1; };
+	inline bool IsRewinding() { return rewind_offset_ >= 0; };
+	// Move through the history by a number of frames, positive being further back, stopping at either end
+	void Rewind(int num_frames);
+	// Put the objects back where they were in the frame being looked at, so it's drawn again
+	void ShowRewindFrame();
+	// Get the frame being looked at and how many frames before the newest it is
+	inline const PoseHistoryFrame& GetRewindFrame() { return pose_history_.GetFrame(rewind_offset_); };
+	inline int GetRewindOffset() { return rewind_offset_; };
+	// Get how far each row of an object's transform was from its reference in the frame being looked at,
+	// as the largest difference of the row's x, y and z, which is what the fixed tolerance check compares
+	void GetRewindRowDeltas(int object, float row_deltas[4]);
+
 	// Getters
 	gef::Matrix44* GetTransform(int id);
 	GameObject* GetGameObject(int id);
+	GameObject* GetGameObject(GameObjectHandle handle);
+	GameObjectHandle GetGameObjectHandle(int id);
+	inline int GetNumObjects() { return (int)object_handles_.size(); };
 	int GetID();
 
 private:
 
+	// Get a game object by its position in the definition, which must be live
+	inline GameObject& Object(int id)
+	{
+
+		GameObject* game_object = game_objects_.Get(object_handles_[id]);
+		assert(game_object != NULL);
+		return *game_object;
+
+	};
+
+	// A scene loaded by the level along with the range of meshes created from it
+	struct LevelScene
+	{
+
+		std::string file_name;
+		// Scene loaded from file, or NULL if the meshes came from the asset bundle
+		gef::Scene* scene;
+		// Full resolution mesh data, which symmetries are worked out from
+		const gef::MeshData* source_mesh;
+		int first_mesh;
+		int last_mesh;
+
+	};
+
+	// Create the level's objects from a definition
+	void BuildLevel(const LevelDefinition& definition, gef::Platform* platform_);
+	// Find the scene an object uses, loading it if it isn't already, and return its index in scenes_
+	int GetScene(gef::Platform* platform_, const ObjectDefinition& object);
+	// Set up an object's symmetry, working it out from its mesh if the definition doesn't give it
+	void SetSymmetry(int object, const LevelScene& scene);
+
 	// Compare the game object transforms to the reference transforms
 	bool CheckTransforms();
+	// Work out the camera space transforms of the active objects the checks look at, once the objects have been updated
+	void UpdateCameraTransforms();
+	// Get a game object's camera space transform corrected for the lens distortion, as the checks want it
+	gef::Matrix44 GetMatchingTransform(GameObject& game_object);
+	// Get a game object's transform rotated by its symmetry to be as close as possible to its reference transform
+	gef::Matrix44 GetCanonicalTransform(int object);
+	// Check if a transform is inside the fitted bounds around its reference transform
+	bool IsWithinBounds(const gef::Matrix44& transform, const gef::Matrix44& reference, const MatchBounds& bounds);
+	// Fit the captured frames and write the new reference transforms and bounds to the level file
+	void FinishCapture();
+	// Fill the spatial index with the definition's solutions
+	void BuildSolutionIndex(const LevelDefinition& definition);
+	// Cull an object against the frustum, pick its LOD and add it to the render queue if it's visible
+	void SubmitObject(GameObject& game_object, const gef::Matrix44& view, float projection_scale, Profiler* profiler_);
+
+	// Create a mesh for each of a scene's LODs, returning the index of the first one in meshes_
+	int CreateMeshes(gef::Platform* platform_, gef::Scene* scene);
+	// Give a game object the LOD meshes from first_mesh up to (but not including) last_mesh
+	void SetMeshLods(GameObject& game_object, int first_mesh, int last_mesh);
 
 	// Vector holding the reference transforms
 	std::vector<gef::Matrix44> transforms_;
-	// Vector holding the game objects
-	std::vector<GameObject> game_objects_;
+	// Vector holding the fitted bounds around the reference transforms, empty if the level uses the fixed tolerance
+	std::vector<MatchBounds> match_bounds_;
+	// Camera space transform of each object the checks look at, so the anchor is only put back once per object per frame
+	std::vector<gef::Matrix44> camera_transforms_;
+	// Symmetry of each game object's mesh, so symmetric poses match without loosening the tolerances
+	std::vector<ShapeSymmetry> symmetries_;
+	// Records frames when capturing new reference transforms
+	PoseCapture capture_;
+	// Index over the level's valid solutions, empty if the level matches the reference transforms instead
+	PoseIndex solution_index_;
+	// Transform of marker 01 relative to marker 02 from the last sample, which is what solutions are matched against
+	gef::Matrix44 relative_transform_;
+	// Solution matched by the last check, or -1 if none
+	int matched_solution_;
+	// Fuse the last few tracked poses of each marker
+	PoseFilter marker02_filter_;
+	PoseFilter marker01_filter_;
+	// The last few seconds of frames, and the frame being filled in as it's worked out
+	PoseHistory pose_history_;
+	PoseHistoryFrame history_frame_;
+	// How many frames before the newest the frame being looked at is, or -1 when not rewinding
+	int rewind_offset_;
+	// Whether the marker objects are kept in the origin marker's space, and the view that puts them in camera space
+	bool world_anchor_;
+	gef::Matrix44 view_transform_;
+	// Pool holding the game objects
+	GameObjectPool game_objects_;
+	// Handles to the level's game objects, in the order the definition lists them
+	std::vector<GameObjectHandle> object_handles_;
+	// Each replayed marker's transform relative to the origin marker, and whether it could be worked out
+	std::vector<gef::Matrix44> marker_local_transforms_;
+	std::vector<bool> markers_usable_;
 	// Scenes holding the model data loaded from file
-	gef::Scene* first_scene_;
-	gef::Scene* second_scene_;
+	std::vector<LevelScene> scenes_;
+	// Scenes read by PreloadScenes that haven't been used yet, which have no meshes
+	std::vector<LevelScene> preloaded_scenes_;
+	// Meshes created from the scenes, which may be shared between game objects
+	std::vector<gef::Mesh*> meshes_;
+	// Bundle of pre-baked scenes, or NULL if there isn't one
+	const AssetBundle* asset_bundle_;
+	// Calibration for correcting the tracked marker transforms, or NULL to use them as they are
+	const CameraCalibration* camera_calibration_;
+	// Streamer caching scenes between levels, or NULL to read and delete them with the level
+	LevelStreamer* level_streamer_;
+
+	// Draws emitted by the level each frame
+	RenderQueue render_queue_;
+	// View frustum objects are culled against before drawing
+	Frustum frustum_;
+	float lod_scale_;
+
+	// The definition the level was built from, and the file and contents it was read from
+	LevelDefinition definition_;
+	std::string definition_file_;
+	gef::UInt32 definition_hash_;
+#ifdef HOT_RELOAD_LEVELS
+	// Modification time and size of the level file when it was last read, so it's only read again once they change
+	gef::UInt64 definition_time_;
+	gef::Int64 definition_size_;
+#endif
 
 	bool check_rotation_;
 	int num_transforms_;
@@ -0,0 +1,537 @@
+#include "level_definition.h"
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <maths/vector4.h>
+#include <kernel.h>
+#include "pose_maths.h"
+#include "pose_capture.h"
+#include "shape_symmetry.h"
+#include "game_object_pool.h"
+
+// Fill in an object definition
+static ObjectDefinition MakeObject(const char* scene_file, const char* lod_scene_file, int marker, bool is_local,
+	float x, float y, float z, float rotation_x, float rotation_y, float rotation_z, float scale)
+{
+
+	ObjectDefinition object;
+	object.scene_file = scene_file;
+	object.lod_scene_file = lod_scene_file;
+	object.marker = marker;
+	object.is_local = is_local;
+	object.position[0] = x;
+	object.position[1] = y;
+	object.position[2] = z;
+	object.rotation[0] = rotation_x;
+	object.rotation[1] = rotation_y;
+	object.rotation[2] = rotation_z;
+	object.scale = scale;
+	object.symmetry_axis = -1;
+	object.symmetry_order = -1;
+
+	return object;
+
+}
+
+// Write a list of transforms, one per line, row by row
+static void WriteTransforms(FILE* file, const char* keyword, const std::vector<gef::Matrix44>& transforms)
+{
+
+	for (std::vector<gef::Matrix44>::const_iterator it = transforms.begin(); it != transforms.end(); ++it)
+	{
+
+		fprintf(file, "%s", keyword);
+		for (int row = 0; row < 4; row++)
+		{
+
+			for (int column = 0; column < 4; column++)
+			{
+
+				fprintf(file, " %f", PoseMaths::GetElement(*it, row, column));
+
+			}
+
+		}
+		fprintf(file, "\n");
+
+	}
+
+}
+
+LevelDefinition::LevelDefinition() :
+	level_id(0),
+	tolerance(0.0f),
+	solution_translation_tolerance(0.01f),
+	solution_rotation_tolerance(0.1f)
+{
+}
+
+LevelDefinition::~LevelDefinition()
+{
+
+
+
+}
+
+bool LevelDefinition::SetDefault(int level_identifier, float tolerance_value)
+{
+
+	level_id = level_identifier;
+	tolerance = tolerance_value;
+	objects.clear();
+	reference_transforms.clear();
+	match_bounds.clear();
+	solutions.clear();
+
+	gef::Matrix44 transform;
+
+	// Set up for the first level (circle within a ring)
+	if (level_id == 1)
+	{
+
+		// Set the data of the origin transform (marker 02)
+		transform.SetRow(0, gef::Vector4(0.067f, -0.003f, -0.002f, 0.0f));
+		transform.SetRow(1, gef::Vector4(-0.003f, -0.004f, -0.067f, 0.0f));
+		transform.SetRow(2, gef::Vector4(0.004f, 0.067f, -0.005f, 0.0f));
+		transform.SetRow(3, gef::Vector4(0.012f, 0.045f, -0.504f, 1.0f));
+
+		reference_transforms.push_back(transform);
+
+		// Then set the data of the other transform (marker 01)
+		transform.SetRow(0, gef::Vector4(0.05f, -0.003f, -0.001f, 0.0f));
+		transform.SetRow(1, gef::Vector4(-0.002f, -0.005f, -0.05f, 0.0f));
+		transform.SetRow(2, gef::Vector4(0.003f, 0.05f, -0.005f, 0.0f));
+		transform.SetRow(3, gef::Vector4(0.013f, 0.04f, -0.5f, 1.0f));
+
+		reference_transforms.push_back(transform);
+
+		// The pipe sits on marker ID 1 (aka 02) and the cylinder on marker ID 0 (aka 01)
+		// 0.05f scales the meshes down to a reasonable size
+		objects.push_back(MakeObject("pipe1.scn", "pipe1_lod.scn", 1, false, 0.0f, 0.0f, 0.3f, -0.785f, 0.0f, 0.0f, 0.05f));
+		objects.push_back(MakeObject("cylinder1.scn", "cylinder1_lod.scn", 0, true, 0.2f, 0.0f, 0.32f, -0.785f, 0.0f, 0.0f, 0.05f * 1.35f));
+
+		return true;
+
+	}
+	// Set up for the second level (two hemispheres)
+	else if (level_id == 2)
+	{
+
+		// Set the data of the origin transform (marker 02)
+		transform.SetRow(0, gef::Vector4(0.0f, 0.007f, -0.013f, 0.0f));
+		transform.SetRow(1, gef::Vector4(-0.015f, 0.0f, 0.0f, 0.0f));
+		transform.SetRow(2, gef::Vector4(0.0f, 0.013f, 0.007f, 0.0f));
+		transform.SetRow(3, gef::Vector4(-0.005f, 0.06f, -0.763f, 1.0f));
+
+		reference_transforms.push_back(transform);
+
+		// Then set the data of the other transform (marker 01)
+		transform.SetRow(0, gef::Vector4(0.0f, -0.005f, 0.009f, 0.0f));
+		transform.SetRow(1, gef::Vector4(0.01f, 0.0f, 0.0f, 0.0f));
+		transform.SetRow(2, gef::Vector4(0.0f, 0.009f, 0.005f, 0.0f));
+		transform.SetRow(3, gef::Vector4(-0.046f, 0.041f, -0.501f, 1.0f));
+
+		reference_transforms.push_back(transform);
+
+		// Both objects are hemispheres, so they share one scene and mesh and can be drawn as a batch
+		objects.push_back(MakeObject("hemi.scn", "hemi_lod.scn", 1, false, 0.0f, 0.0f, 0.1f, 0.0f, 0.0f, 1.57f, 0.01f * 1.5f));
+		objects.push_back(MakeObject("hemi.scn", "hemi_lod.scn", 0, true, 0.05f, 0.0f, 0.2f, 0.0f, 0.0f, 0.0f, 0.01f));
+
+		return true;
+
+	}
+
+	return false;
+
+}
+
+bool LevelDefinition::Load(const char* file_name)
+{
+
+	std::string text;
+
+	if (!ReadFile(file_name, text))
+	{
+
+		return false;
+
+	}
+
+	return Parse(text);
+
+}
+
+bool LevelDefinition::Parse(const std::string& text)
+{
+
+	// Parse into a copy so a bad file leaves the current definition untouched
+	float new_tolerance = tolerance;
+	std::vector<ObjectDefinition> new_objects;
+	std::vector<gef::Matrix44> new_transforms;
+	std::vector<MatchBounds> new_bounds;
+	std::vector<gef::Matrix44> new_solutions;
+	float new_translation_tolerance = solution_translation_tolerance;
+	float new_rotation_tolerance = solution_rotation_tolerance;
+	std::vector<int> new_symmetry_axes;
+	std::vector<int> new_symmetry_orders;
+
+	size_t line_start = 0;
+	while (line_start < text.size())
+	{
+
+		size_t line_end = text.find('\n', line_start);
+		if (line_end == std::string::npos)
+		{
+
+			line_end = text.size();
+
+		}
+
+		std::string line = text.substr(line_start, line_end - line_start);
+		line_start = line_end + 1;
+
+		char keyword[32];
+		if (sscanf(line.c_str(), "%31s", keyword) != 1 || keyword[0] == '#')
+		{
+
+			continue;
+
+		}
+
+		if (strcmp(keyword, "tolerance") == 0)
+		{
+
+			if (sscanf(line.c_str(), "%*s %f", &new_tolerance) != 1)
+			{
+
+				return false;
+
+			}
+
+		}
+		else if (strcmp(keyword, "object") == 0)
+		{
+
+			char scene_file[128];
+			char lod_scene_file[128];
+			int is_local = 0;
+			ObjectDefinition object;
+
+			if (sscanf(line.c_str(), "%*s %127s %127s %i %i %f %f %f %f %f %f %f", scene_file, lod_scene_file, &object.marker, &is_local,
+				&object.position[0], &object.position[1], &object.position[2],
+				&object.rotation[0], &object.rotation[1], &object.rotation[2], &object.scale) != 11)
+			{
+
+				return false;
+
+			}
+
+			object.scene_file = scene_file;
+			object.lod_scene_file = lod_scene_file;
+			object.is_local = is_local != 0;
+			object.symmetry_axis = -1;
+			object.symmetry_order = -1;
+			new_objects.push_back(object);
+
+		}
+		else if (strcmp(keyword, "reference") == 0 || strcmp(keyword, "solution") == 0)
+		{
+
+			float values[16];
+			if (sscanf(line.c_str(), "%*s %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",
+				&values[0], &values[1], &values[2], &values[3], &values[4], &values[5], &values[6], &values[7],
+				&values[8], &values[9], &values[10], &values[11], &values[12], &values[13], &values[14], &values[15]) != 16)
+			{
+
+				return false;
+
+			}
+
+			gef::Matrix44 transform;
+			for (int row = 0; row < 4; row++)
+			{
+
+				transform.SetRow(row, gef::Vector4(values[row * 4], values[row * 4 + 1], values[row * 4 + 2], values[row * 4 + 3]));
+
+			}
+			if (strcmp(keyword, "reference") == 0)
+			{
+
+				new_transforms.push_back(transform);
+
+			}
+			else
+			{
+
+				new_solutions.push_back(transform);
+
+			}
+
+		}
+		else if (strcmp(keyword, "solution_tolerance") == 0)
+		{
+
+			if (sscanf(line.c_str(), "%*s %f %f", &new_translation_tolerance, &new_rotation_tolerance) != 2)
+			{
+
+				return false;
+
+			}
+
+		}
+		else if (strcmp(keyword, "bounds") == 0)
+		{
+
+			MatchBounds bounds;
+			if (sscanf(line.c_str(), "%*s %f %f %f %f %f %f %f %f %f %f %f %f",
+				&bounds.sigma[0], &bounds.sigma[1], &bounds.sigma[2], &bounds.sigma[3], &bounds.sigma[4], &bounds.sigma[5],
+				&bounds.sigma[6], &bounds.sigma[7], &bounds.sigma[8], &bounds.sigma[9], &bounds.sigma[10], &bounds.sigma[11]) != MATCH_ELEMENTS)
+			{
+
+				return false;
+
+			}
+
+			// A sigma that isn't finite and positive would make every transform fail, or pass, the bounds check,
+			// and one tighter than a capture ever fits is held to the same floor
+			for (int element = 0; element < MATCH_ELEMENTS; element++)
+			{
+
+				// NaNs fail every comparison, and infinities are caught by the range check
+				if (!(bounds.sigma[element] > 0.0f && bounds.sigma[element] <= FLT_MAX))
+				{
+
+					return false;
+
+				}
+
+				if (bounds.sigma[element] < CAPTURE_MIN_SIGMA)
+				{
+
+					bounds.sigma[element] = CAPTURE_MIN_SIGMA;
+
+				}
+
+			}
+
+			new_bounds.push_back(bounds);
+
+		}
+		else if (strcmp(keyword, "symmetry") == 0)
+		{
+
+			int axis;
+			int order;
+			if (sscanf(line.c_str(), "%*s %i %i", &axis, &order) != 2
+				|| axis < -1 || axis > 2 || order < 0 || order > MAX_SYMMETRY_ORDER)
+			{
+
+				return false;
+
+			}
+
+			new_symmetry_axes.push_back(axis);
+			new_symmetry_orders.push_back(order);
+
+		}
+
+	}
+
+	// Only override the parts of the level that the file describes
+	if (new_objects.empty())
+	{
+
+		new_objects = objects;
+
+	}
+	if (new_transforms.empty())
+	{
+
+		new_transforms = reference_transforms;
+
+	}
+	if (new_bounds.empty())
+	{
+
+		new_bounds = match_bounds;
+
+	}
+	if (new_solutions.empty())
+	{
+
+		new_solutions = solutions;
+
+	}
+
+	// Levels are built around an origin object and an object placed relative to it,
+	// and every object needs a reference transform to be matched against, and a slot in the object pool
+	if (new_objects.size() < 2 || new_objects.size() > MAX_GAME_OBJECTS || new_objects.size() != new_transforms.size())
+	{
+
+		return false;
+
+	}
+
+	// Bounds are all or nothing, otherwise we'd mix the two ways of matching
+	if (!new_bounds.empty() && new_bounds.size() != new_objects.size())
+	{
+
+		return false;
+
+	}
+
+	// As are symmetries, which are applied to the objects in order
+	if (!new_symmetry_axes.empty())
+	{
+
+		if (new_symmetry_axes.size() != new_objects.size())
+		{
+
+			return false;
+
+		}
+
+		for (size_t object = 0; object < new_objects.size(); object++)
+		{
+
+			new_objects[object].symmetry_axis = new_symmetry_axes[object];
+			new_objects[object].symmetry_order = new_symmetry_orders[object];
+
+		}
+
+	}
+
+	tolerance = new_tolerance;
+	objects = new_objects;
+	reference_transforms = new_transforms;
+	match_bounds = new_bounds;
+	solutions = new_solutions;
+	solution_translation_tolerance = new_translation_tolerance;
+	solution_rotation_tolerance = new_rotation_tolerance;
+
+	return true;
+
+}
+
+bool LevelDefinition::Save(const char* file_name) const
+{
+
+	// Make sure the folder exists, it's fine if it already does
+	sceIoMkdir(LEVEL_DEFINITION_PATH, 0777);
+
+	FILE* file = fopen(file_name, "w");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	fprintf(file, "# Shape Matcher level %i\n", level_id);
+	fprintf(file, "tolerance %f\n", tolerance);
+
+	for (std::vector<ObjectDefinition>::const_iterator it = objects.begin(); it != objects.end(); ++it)
+	{
+
+		fprintf(file, "object %s %s %i %i %f %f %f %f %f %f %f\n", it->scene_file.c_str(), it->lod_scene_file.c_str(), it->marker, it->is_local ? 1 : 0,
+			it->position[0], it->position[1], it->position[2], it->rotation[0], it->rotation[1], it->rotation[2], it->scale);
+
+	}
+
+	WriteTransforms(file, "reference", reference_transforms);
+
+	for (std::vector<MatchBounds>::const_iterator it = match_bounds.begin(); it != match_bounds.end(); ++it)
+	{
+
+		fprintf(file, "bounds");
+		for (int element = 0; element < MATCH_ELEMENTS; element++)
+		{
+
+			fprintf(file, " %f", it->sigma[element]);
+
+		}
+		fprintf(file, "\n");
+
+	}
+
+	WriteTransforms(file, "solution", solutions);
+	fprintf(file, "solution_tolerance %f %f\n", solution_translation_tolerance, solution_rotation_tolerance);
+
+	// Only write symmetries once every object's is known, since they're all or nothing
+	bool symmetries_known = true;
+	for (std::vector<ObjectDefinition>::const_iterator it = objects.begin(); it != objects.end(); ++it)
+	{
+
+		symmetries_known = symmetries_known && it->symmetry_order >= 0;
+
+	}
+
+	for (std::vector<ObjectDefinition>::const_iterator it = objects.begin(); symmetries_known && it != objects.end(); ++it)
+	{
+
+		fprintf(file, "symmetry %i %i\n", it->symmetry_axis, it->symmetry_order);
+
+	}
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+
+	return success;
+
+}
+
+std::string LevelDefinition::GetFileName(int level_identifier)
+{
+
+	char file_name[128];
+	sprintf(file_name, LEVEL_DEFINITION_PATH "level%i.txt", level_identifier);
+
+	return file_name;
+
+}
+
+bool LevelDefinition::ReadFile(const char* file_name, std::string& text)
+{
+
+	FILE* file = fopen(file_name, "rb");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	text.clear();
+
+	char buffer[512];
+	size_t bytes_read;
+	while ((bytes_read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+
+		text.append(buffer, bytes_read);
+
+	}
+
+	fclose(file);
+
+	return true;
+
+}
+
+gef::UInt32 LevelDefinition::Hash(const std::string& text)
+{
+
+	// FNV-1a
+	gef::UInt32 hash = 2166136261u;
+
+	for (size_t index = 0; index < text.size(); index++)
+	{
+
+		hash ^= (gef::UInt8)text[index];
+		hash *= 16777619u;
+
+	}
+
+	return hash;
+
+}
\ No newline at end of file
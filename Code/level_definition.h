@@ -0,0 +1,100 @@
+#ifndef LEVEL_DEFINITION_H
+#define LEVEL_DEFINITION_H
+
+#include <vector>
+#include <string>
+#include <gef.h>
+#include <maths/matrix44.h>
+
+// Folder that level definition files are read from, writable so levels can be tuned while the game runs
+#define LEVEL_DEFINITION_PATH "ux0:data/shape_matcher/"
+
+// Describes one of the objects drawn on a marker
+struct ObjectDefinition
+{
+
+	// Scene file holding the mesh, and the baked LOD version of it
+	std::string scene_file;
+	std::string lod_scene_file;
+	int marker;
+	// Local objects are positioned relative to the origin marker
+	bool is_local;
+	float position[3];
+	float rotation[3];
+	float scale;
+	// Rotational symmetry of the mesh, found from the mesh at load time if the order is -1
+	int symmetry_axis;
+	int symmetry_order;
+
+};
+
+// Number of transform elements that are matched, the x, y and z of each of the four rows
+#define MATCH_ELEMENTS 12
+
+// Largest squared Mahalanobis distance from the reference transform that still counts as a match
+// This is the 99% point of the chi-squared distribution with MATCH_ELEMENTS degrees of freedom
+#define MATCH_CHI_SQUARED 26.2f
+
+// Fitted tolerance for one object, the standard deviation of each matched element of its transform
+// Together these describe an axis aligned ellipsoid around the reference transform
+struct MatchBounds
+{
+
+	float sigma[MATCH_ELEMENTS];
+
+};
+
+// Level definition class
+// Everything needed to build a level: the objects, the reference transforms they're matched against and the tolerance
+// Levels have built-in definitions, which can be overridden by a text file in LEVEL_DEFINITION_PATH
+//
+// The file format is one entry per line, with # starting a comment:
+//   tolerance <value>
+//   object <scene file> <LOD scene file> <marker> <local 0/1> <x> <y> <z> <rotation x> <rotation y> <rotation z> <scale>
+//   reference <16 values, row by row>
+//   bounds <12 standard deviations, x y z of each row>
+//   solution <16 values, row by row>
+//   solution_tolerance <translation> <rotation in radians>
+//   symmetry <axis 0/1/2, or -1 for none> <order, or 0 for continuous>
+// Objects, reference transforms and bounds are matched up by the order they appear in
+// Bounds are optional, and are written by the reference capture mode
+// Solutions are optional too, each is a valid transform of marker 01 relative to marker 02
+// Levels with solutions accept any of them, instead of matching the reference transforms
+// Symmetries are optional, and are worked out from the meshes and written out with the level file if missing
+class LevelDefinition
+{
+
+public:
+
+	LevelDefinition();
+	~LevelDefinition();
+
+	// Fill in the built-in definition of a level, returning false if there isn't one
+	bool SetDefault(int level_identifier, float tolerance_value);
+
+	// Override the definition from a level file, returning false if the file is missing or invalid
+	bool Load(const char* file_name);
+	// Parse a definition from the text of a level file
+	bool Parse(const std::string& text);
+	// Write the definition out as a level file
+	bool Save(const char* file_name) const;
+
+	// Get the name of the file that overrides a level's built-in definition
+	static std::string GetFileName(int level_identifier);
+	// Read a whole file into a string, returning false if it can't be opened
+	static bool ReadFile(const char* file_name, std::string& text);
+	// Hash the contents of a level file, so we can tell when it's changed
+	static gef::UInt32 Hash(const std::string& text);
+
+	int level_id;
+	float tolerance;
+	std::vector<ObjectDefinition> objects;
+	std::vector<gef::Matrix44> reference_transforms;
+	std::vector<MatchBounds> match_bounds;
+	std::vector<gef::Matrix44> solutions;
+	float solution_translation_tolerance;
+	float solution_rotation_tolerance;
+
+};
+
+#endif // !LEVEL_DEFINITION_H
\ No newline at end of file
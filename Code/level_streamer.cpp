@@ -0,0 +1,575 @@
+#include "level_streamer.h"
+#include <stdio.h>
+#include <string.h>
+#include <kernel.h>
+#include <graphics/scene.h>
+#include "level.h"
+#include "asset_bundle.h"
+
+// Stack for the streamer thread, which reads scenes and builds LODs
+#define LEVEL_STREAMER_STACK_SIZE (256 * 1024)
+
+// Microseconds the streamer thread sleeps between checking for new requests
+static const unsigned int streamer_sleep_time = 10000;
+
+LevelStreamer::LevelStreamer() :
+	resident_bytes_(0),
+	use_counter_(0),
+	request_generation_(0),
+	running_(false),
+	platform_(NULL),
+	asset_bundle_(NULL),
+	tolerance_value_(0.0f)
+{
+
+	pack_.push_back(1);
+	pack_.push_back(2);
+
+}
+
+LevelStreamer::~LevelStreamer()
+{
+
+	Stop();
+
+	for (std::vector<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+	{
+
+		delete it->scene;
+
+	}
+	entries_.clear();
+
+}
+
+bool LevelStreamer::LoadPack(const char* file_name)
+{
+
+	std::string text;
+	if (!LevelDefinition::ReadFile(file_name, text))
+	{
+
+		return false;
+
+	}
+
+	std::vector<int> new_pack;
+
+	size_t line_start = 0;
+	while (line_start < text.size())
+	{
+
+		size_t line_end = text.find('\n', line_start);
+		if (line_end == std::string::npos)
+		{
+
+			line_end = text.size();
+
+		}
+
+		std::string line = text.substr(line_start, line_end - line_start);
+		line_start = line_end + 1;
+
+		// Levels that have neither a built-in definition nor a level file that parses can't be played, so leave them out
+		int level_identifier;
+		LevelDefinition definition;
+		gef::UInt32 hash;
+		if (sscanf(line.c_str(), "level %i", &level_identifier) == 1 && Level::ReadDefinition(level_identifier, 0.0f, definition, hash))
+		{
+
+			new_pack.push_back(level_identifier);
+
+		}
+
+	}
+
+	// Keep the built-in levels if the pack is empty
+	if (new_pack.empty())
+	{
+
+		return false;
+
+	}
+
+	pack_ = new_pack;
+
+	return true;
+
+}
+
+int LevelStreamer::GetFirstLevel() const
+{
+
+	return pack_.front();
+
+}
+
+int LevelStreamer::GetNextLevel(int level_identifier) const
+{
+
+	for (size_t level = 0; level < pack_.size(); level++)
+	{
+
+		if (pack_[level] == level_identifier)
+		{
+
+			return pack_[(level + 1) % pack_.size()];
+
+		}
+
+	}
+
+	return pack_.front();
+
+}
+
+bool LevelStreamer::Start(gef::Platform* platform_, const AssetBundle* asset_bundle_, float tolerance_value)
+{
+
+	this->platform_ = platform_;
+	this->asset_bundle_ = asset_bundle_;
+	tolerance_value_ = tolerance_value;
+
+	// Without a mutex the cache can't be shared, so everything is read on the main thread instead
+	if (!mutex_.IsValid())
+	{
+
+		return false;
+
+	}
+
+	// Nothing else is running yet, so there's no need to lock
+	running_ = true;
+	if (!thread_.Start("LevelStreamer", StreamerThread, this, LEVEL_STREAMER_STACK_SIZE))
+	{
+
+		running_ = false;
+		return false;
+
+	}
+
+	return true;
+
+}
+
+void LevelStreamer::Stop()
+{
+
+	mutex_.Lock();
+	running_ = false;
+	mutex_.Unlock();
+
+	thread_.Join();
+
+}
+
+void LevelStreamer::SetCurrentLevel(int level_identifier)
+{
+
+	mutex_.Lock();
+
+	requested_levels_.clear();
+	int next_level = level_identifier;
+	for (int level = 0; level < LEVEL_STREAMER_PREFETCH && level < (int)pack_.size() - 1; level++)
+	{
+
+		next_level = GetNextLevel(next_level);
+		requested_levels_.push_back(next_level);
+
+	}
+
+	request_generation_++;
+
+	mutex_.Unlock();
+
+}
+
+gef::Scene* LevelStreamer::AcquireScene(gef::Platform* platform_, const ObjectDefinition& object, bool& materials_created)
+{
+
+	mutex_.Lock();
+
+	int index = FindEntry(object.scene_file);
+	if (index >= 0 && !entries_[index].in_use)
+	{
+
+		Entry& entry = entries_[index];
+		entry.in_use = true;
+		entry.last_used = ++use_counter_;
+		materials_created = entry.materials_created;
+
+		gef::Scene* scene = entry.scene;
+		mutex_.Unlock();
+
+		return scene;
+
+	}
+
+	mutex_.Unlock();
+
+	// It wasn't prefetched, so read it now, and the level hands it over when it's released
+	materials_created = false;
+	return Level::LoadScene(platform_, object.scene_file.c_str(), object.lod_scene_file.c_str());
+
+}
+
+void LevelStreamer::ReleaseScene(const std::string& file_name, gef::Scene* scene)
+{
+
+	std::vector<gef::Scene*> evicted_scenes;
+
+	mutex_.Lock();
+
+	int index = FindEntry(file_name);
+	if (index >= 0 && entries_[index].scene == scene)
+	{
+
+		entries_[index].in_use = false;
+		entries_[index].materials_created = true;
+		entries_[index].last_used = ++use_counter_;
+
+	}
+	else if (index >= 0)
+	{
+
+		// The streamer read its own copy while the level had this one, so keep the one with materials
+		evicted_scenes.push_back(entries_[index].scene);
+		resident_bytes_ -= entries_[index].bytes;
+		entries_[index].scene = scene;
+		entries_[index].bytes = GetSceneBytes(scene);
+		entries_[index].in_use = false;
+		entries_[index].materials_created = true;
+		entries_[index].last_used = ++use_counter_;
+		resident_bytes_ += entries_[index].bytes;
+
+	}
+	else
+	{
+
+		Entry entry;
+		entry.file_name = file_name;
+		entry.scene = scene;
+		entry.bytes = GetSceneBytes(scene);
+		entry.last_used = ++use_counter_;
+		entry.in_use = false;
+		entry.materials_created = true;
+		entry.is_wanted = false;
+		entries_.push_back(entry);
+		resident_bytes_ += entry.bytes;
+
+	}
+
+	mutex_.Unlock();
+
+	for (std::vector<gef::Scene*>::iterator it = evicted_scenes.begin(); it != evicted_scenes.end(); ++it)
+	{
+
+		delete *it;
+
+	}
+
+}
+
+void LevelStreamer::Trim()
+{
+
+	std::vector<gef::Scene*> evicted_scenes;
+
+	mutex_.Lock();
+	Evict(LEVEL_STREAMER_BUDGET, true, evicted_scenes);
+	mutex_.Unlock();
+
+	for (std::vector<gef::Scene*>::iterator it = evicted_scenes.begin(); it != evicted_scenes.end(); ++it)
+	{
+
+		delete *it;
+
+	}
+
+}
+
+void LevelStreamer::StreamerThread(void* argument)
+{
+
+	((LevelStreamer*)argument)->RunStreamer();
+
+}
+
+void LevelStreamer::RunStreamer()
+{
+
+	gef::UInt32 handled_generation = GetRequestGeneration();
+
+	while (IsStreaming())
+	{
+
+		gef::UInt32 generation = GetRequestGeneration();
+		if (generation == handled_generation)
+		{
+
+			sceKernelDelayThread(streamer_sleep_time);
+			continue;
+
+		}
+
+		mutex_.Lock();
+		std::vector<int> level_identifiers = requested_levels_;
+		mutex_.Unlock();
+
+		Prefetch(level_identifiers, generation);
+		handled_generation = generation;
+
+	}
+
+}
+
+void LevelStreamer::Prefetch(const std::vector<int>& level_identifiers, gef::UInt32 generation)
+{
+
+	// Work out which scenes the levels use, nearest level first
+	std::vector<ObjectDefinition> wanted_objects;
+	for (std::vector<int>::const_iterator level = level_identifiers.begin(); level != level_identifiers.end(); ++level)
+	{
+
+		LevelDefinition definition;
+		gef::UInt32 hash;
+		if (!Level::ReadDefinition(*level, tolerance_value_, definition, hash))
+		{
+
+			continue;
+
+		}
+
+		for (std::vector<ObjectDefinition>::const_iterator it = definition.objects.begin(); it != definition.objects.end(); ++it)
+		{
+
+			// Bundled scenes are always resident
+			if (!asset_bundle_ || !asset_bundle_->FindScene(it->lod_scene_file.c_str()))
+			{
+
+				wanted_objects.push_back(*it);
+
+			}
+
+		}
+
+	}
+
+	// Mark the scenes that are wanted, so they aren't evicted, and find the ones that need reading
+	std::vector<ObjectDefinition> missing_objects;
+
+	mutex_.Lock();
+
+	for (std::vector<Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+	{
+
+		it->is_wanted = false;
+
+	}
+
+	for (std::vector<ObjectDefinition>::const_iterator it = wanted_objects.begin(); it != wanted_objects.end(); ++it)
+	{
+
+		int index = FindEntry(it->scene_file);
+		if (index >= 0)
+		{
+
+			entries_[index].is_wanted = true;
+			entries_[index].last_used = ++use_counter_;
+
+		}
+		else
+		{
+
+			bool is_missing = false;
+			for (std::vector<ObjectDefinition>::const_iterator missing = missing_objects.begin(); missing != missing_objects.end(); ++missing)
+			{
+
+				is_missing = is_missing || missing->scene_file == it->scene_file;
+
+			}
+
+			if (!is_missing)
+			{
+
+				missing_objects.push_back(*it);
+
+			}
+
+		}
+
+	}
+
+	mutex_.Unlock();
+
+	for (std::vector<ObjectDefinition>::const_iterator it = missing_objects.begin(); it != missing_objects.end() && IsStreaming(); ++it)
+	{
+
+		// Give up on stale requests, the player has moved on
+		if (GetRequestGeneration() != generation)
+		{
+
+			return;
+
+		}
+
+		// Read outside the lock, as it's the slow part
+		gef::Scene* scene = Level::LoadScene(platform_, it->scene_file.c_str(), it->lod_scene_file.c_str());
+		size_t bytes = GetSceneBytes(scene);
+
+		std::vector<gef::Scene*> evicted_scenes;
+		bool is_added = false;
+
+		mutex_.Lock();
+
+		// Only keep it if room can be made without evicting anything that holds GPU resources or is wanted
+		if (FindEntry(it->scene_file) < 0)
+		{
+
+			Evict(bytes <= LEVEL_STREAMER_BUDGET ? LEVEL_STREAMER_BUDGET - bytes : 0, false, evicted_scenes);
+
+			if (resident_bytes_ + bytes <= LEVEL_STREAMER_BUDGET)
+			{
+
+				Entry entry;
+				entry.file_name = it->scene_file;
+				entry.scene = scene;
+				entry.bytes = bytes;
+				entry.last_used = ++use_counter_;
+				entry.in_use = false;
+				entry.materials_created = false;
+				entry.is_wanted = true;
+				entries_.push_back(entry);
+				resident_bytes_ += bytes;
+				is_added = true;
+
+			}
+
+		}
+
+		mutex_.Unlock();
+
+		for (std::vector<gef::Scene*>::iterator evicted = evicted_scenes.begin(); evicted != evicted_scenes.end(); ++evicted)
+		{
+
+			delete *evicted;
+
+		}
+
+		if (!is_added)
+		{
+
+			delete scene;
+
+		}
+
+	}
+
+}
+
+bool LevelStreamer::IsStreaming()
+{
+
+	mutex_.Lock();
+	bool running = running_;
+	mutex_.Unlock();
+
+	return running;
+
+}
+
+gef::UInt32 LevelStreamer::GetRequestGeneration()
+{
+
+	mutex_.Lock();
+	gef::UInt32 generation = request_generation_;
+	mutex_.Unlock();
+
+	return generation;
+
+}
+
+int LevelStreamer::FindEntry(const std::string& file_name)
+{
+
+	for (size_t entry = 0; entry < entries_.size(); entry++)
+	{
+
+		if (entries_[entry].file_name == file_name)
+		{
+
+			return (int)entry;
+
+		}
+
+	}
+
+	return -1;
+
+}
+
+void LevelStreamer::Evict(size_t budget, bool allow_materials, std::vector<gef::Scene*>& evicted_scenes)
+{
+
+	while (resident_bytes_ > budget)
+	{
+
+		// Find the least recently used entry that can go
+		int oldest = -1;
+		for (size_t entry = 0; entry < entries_.size(); entry++)
+		{
+
+			const Entry& candidate = entries_[entry];
+			if (candidate.in_use || candidate.is_wanted || (candidate.materials_created && !allow_materials))
+			{
+
+				continue;
+
+			}
+
+			if (oldest < 0 || candidate.last_used < entries_[oldest].last_used)
+			{
+
+				oldest = (int)entry;
+
+			}
+
+		}
+
+		if (oldest < 0)
+		{
+
+			return;
+
+		}
+
+		evicted_scenes.push_back(entries_[oldest].scene);
+		resident_bytes_ -= entries_[oldest].bytes;
+		entries_.erase(entries_.begin() + oldest);
+
+	}
+
+}
+
+size_t LevelStreamer::GetSceneBytes(const gef::Scene* scene)
+{
+
+	size_t bytes = 0;
+
+	for (std::list<gef::MeshData>::const_iterator it = scene->mesh_data.begin(); it != scene->mesh_data.end(); ++it)
+	{
+
+		bytes += it->vertex_data.num_vertices * it->vertex_data.vertex_byte_size;
+
+		for (std::vector<gef::PrimitiveData*>::const_iterator primitive = it->primitives.begin(); primitive != it->primitives.end(); ++primitive)
+		{
+
+			bytes += (*primitive)->num_indices * (*primitive)->index_byte_size;
+
+		}
+
+	}
+
+	return bytes;
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef LEVEL_STREAMER_H
+#define LEVEL_STREAMER_H
+
+#include <vector>
+#include <string>
+#include <gef.h>
+#include "thread.h"
+#include "level_definition.h"
+
+// File listing the levels in the campaign, in the order they're played
+#define LEVEL_PACK_FILE LEVEL_DEFINITION_PATH "level_pack.txt"
+
+// Most bytes of scene data kept resident, including the scenes the current level is using
+#define LEVEL_STREAMER_BUDGET (16 * 1024 * 1024)
+// Number of levels after the current one that are prefetched
+#define LEVEL_STREAMER_PREFETCH 2
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Platform;
+	class Scene;
+
+}
+
+// Other forward declarations
+class AssetBundle;
+
+// Level streamer class
+// Holds the campaign's list of levels, and a cache of the scenes they use so levels don't have to be read from scratch
+// A background thread reads the scenes of the next few levels into the cache ahead of time, so switching level doesn't
+// wait on the disk however large the campaign is
+// The cache is bounded by a byte budget, and the least recently used scenes that aren't in use or about to be are
+// evicted to stay inside it. Scenes that have only been read are evicted by the background thread, but once a level
+// has created materials from a scene it holds GPU resources, so it's only freed on the main thread by Trim
+class LevelStreamer
+{
+
+public:
+
+	LevelStreamer();
+	~LevelStreamer();
+
+	// Read the list of levels, one "level <id>" per line, falling back to the two built-in levels
+	bool LoadPack(const char* file_name);
+	inline int GetNumLevels() const { return (int)pack_.size(); };
+	int GetFirstLevel() const;
+	// Get the level after a level in the pack, wrapping round at the end
+	int GetNextLevel(int level_identifier) const;
+
+	// Start the prefetching thread
+	bool Start(gef::Platform* platform_, const AssetBundle* asset_bundle_, float tolerance_value);
+	// Stop the prefetching thread, waiting for any scene it's reading
+	void Stop();
+
+	// Set the level being played, so the ones after it are prefetched
+	void SetCurrentLevel(int level_identifier);
+
+	// Take a scene for a level to use, reading it now if it hasn't been prefetched
+	// materials_created is set if the scene's materials were created by a level that used it before
+	gef::Scene* AcquireScene(gef::Platform* platform_, const ObjectDefinition& object, bool& materials_created);
+	// Give a scene back to the cache when the level is done with it, which may be one the level read itself
+	// Its materials are expected to have been created
+	void ReleaseScene(const std::string& file_name, gef::Scene* scene);
+
+	// Free least recently used scenes until the cache is back inside its budget, which has to be called on the main thread
+	void Trim();
+
+	inline size_t GetResidentBytes() const { return resident_bytes_; };
+
+private:
+
+	struct Entry
+	{
+
+		std::string file_name;
+		gef::Scene* scene;
+		size_t bytes;
+		// Use counter value when the entry was last acquired, released or prefetched
+		gef::UInt32 last_used;
+		bool in_use;
+		bool materials_created;
+		// Whether one of the prefetched levels uses the scene
+		bool is_wanted;
+
+	};
+
+	// Prefetching thread
+	static void StreamerThread(void* argument);
+	void RunStreamer();
+	// Read the scenes for the requested levels that aren't resident yet
+	void Prefetch(const std::vector<int>& level_identifiers, gef::UInt32 generation);
+	// Read the state shared with the main thread, locking the mutex
+	bool IsStreaming();
+	gef::UInt32 GetRequestGeneration();
+
+	// Find an entry, with the mutex locked
+	int FindEntry(const std::string& file_name);
+	// Remove least recently used entries until the resident bytes fit the budget, with the mutex locked
+	// Entries holding materials are only removed if allowed, and the scenes are added to a list to be deleted after unlocking
+	void Evict(size_t budget, bool allow_materials, std::vector<gef::Scene*>& evicted_scenes);
+
+	// Get the number of bytes of mesh data in a scene
+	static size_t GetSceneBytes(const gef::Scene* scene);
+
+	// Level IDs in the order they're played
+	std::vector<int> pack_;
+
+	// Cache of scenes, shared with the streamer thread
+	Mutex mutex_;
+	std::vector<Entry> entries_;
+	size_t resident_bytes_;
+	gef::UInt32 use_counter_;
+
+	// Levels the streamer thread should prefetch, which are changed along with the generation
+	std::vector<int> requested_levels_;
+	gef::UInt32 request_generation_;
+
+	// Whether the streamer thread should keep going, which is also guarded by the mutex
+	Thread thread_;
+	bool running_;
+
+	gef::Platform* platform_;
+	const AssetBundle* asset_bundle_;
+	float tolerance_value_;
+
+};
+
+#endif // !LEVEL_STREAMER_H
\ No newline at end of file
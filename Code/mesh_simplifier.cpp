@@ -0,0 +1,296 @@
+#include "mesh_simplifier.h"
+#include <vector>
+#include <math.h>
+#include <system/platform.h>
+#include <graphics/scene.h>
+#include <graphics/mesh.h>
+#include <graphics/mesh_data.h>
+#include <graphics/primitive.h>
+
+// Grid resolution used for each LOD after the full resolution mesh
+static const int lod_grid_resolutions[MAX_MESH_LODS - 1] = { 24, 12 };
+
+// Running totals for the vertices merged into one cluster
+struct VertexCluster
+{
+
+	float px, py, pz;
+	float nx, ny, nz;
+	float u, v;
+	int count;
+
+};
+
+// Read an index from an index buffer of either 16 or 32 bit indices
+static gef::UInt32 ReadIndex(const void* indices, int index_byte_size, int index)
+{
+
+	if (index_byte_size == 2)
+	{
+
+		return ((const gef::UInt16*)indices)[index];
+
+	}
+
+	return ((const gef::UInt32*)indices)[index];
+
+}
+
+// Work out which grid cell a position falls in along one axis
+static int GetCell(float position, float min, float extent, int grid_resolution)
+{
+
+	if (extent <= 0.0f)
+	{
+
+		return 0;
+
+	}
+
+	int cell = (int)(((position - min) / extent) * grid_resolution);
+
+	if (cell < 0)
+	{
+
+		cell = 0;
+
+	}
+	else if (cell >= grid_resolution)
+	{
+
+		cell = grid_resolution - 1;
+
+	}
+
+	return cell;
+
+}
+
+bool MeshSimplifier::Simplify(const gef::MeshData& source, int grid_resolution, gef::MeshData& result)
+{
+
+	// Only the default vertex layout is supported
+	if (source.vertex_data.vertex_byte_size != sizeof(gef::Mesh::Vertex) || grid_resolution <= 0)
+	{
+
+		return false;
+
+	}
+
+	const gef::Mesh::Vertex* vertices = (const gef::Mesh::Vertex*)source.vertex_data.vertices;
+	int num_vertices = source.vertex_data.num_vertices;
+
+	gef::Vector4 min = source.aabb.min_vtx();
+	gef::Vector4 max = source.aabb.max_vtx();
+
+	// Map each occupied cell to a cluster, and each vertex to the cluster it's merged into
+	std::vector<int> cell_clusters(grid_resolution * grid_resolution * grid_resolution, -1);
+	std::vector<int> vertex_clusters(num_vertices);
+	std::vector<VertexCluster> clusters;
+
+	for (int vertex = 0; vertex < num_vertices; vertex++)
+	{
+
+		const gef::Mesh::Vertex& v = vertices[vertex];
+
+		int cell_x = GetCell(v.px, min.x(), max.x() - min.x(), grid_resolution);
+		int cell_y = GetCell(v.py, min.y(), max.y() - min.y(), grid_resolution);
+		int cell_z = GetCell(v.pz, min.z(), max.z() - min.z(), grid_resolution);
+		int cell = (cell_z * grid_resolution + cell_y) * grid_resolution + cell_x;
+
+		if (cell_clusters[cell] < 0)
+		{
+
+			VertexCluster cluster = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0 };
+			cell_clusters[cell] = (int)clusters.size();
+			clusters.push_back(cluster);
+
+		}
+
+		VertexCluster& cluster = clusters[cell_clusters[cell]];
+		cluster.px += v.px;
+		cluster.py += v.py;
+		cluster.pz += v.pz;
+		cluster.nx += v.nx;
+		cluster.ny += v.ny;
+		cluster.nz += v.nz;
+		cluster.u += v.u;
+		cluster.v += v.v;
+		cluster.count++;
+
+		vertex_clusters[vertex] = cell_clusters[cell];
+
+	}
+
+	// Each cluster becomes one vertex at the average of the vertices merged into it
+	int num_clusters = (int)clusters.size();
+	gef::Mesh::Vertex* new_vertices = (gef::Mesh::Vertex*)new gef::UInt8[num_clusters * sizeof(gef::Mesh::Vertex)];
+
+	for (int index = 0; index < num_clusters; index++)
+	{
+
+		const VertexCluster& cluster = clusters[index];
+		float inv_count = 1.0f / (float)cluster.count;
+
+		new_vertices[index].px = cluster.px * inv_count;
+		new_vertices[index].py = cluster.py * inv_count;
+		new_vertices[index].pz = cluster.pz * inv_count;
+		new_vertices[index].u = cluster.u * inv_count;
+		new_vertices[index].v = cluster.v * inv_count;
+
+		// Renormalise the averaged normal
+		float normal_length = sqrtf(cluster.nx * cluster.nx + cluster.ny * cluster.ny + cluster.nz * cluster.nz);
+		if (normal_length > 0.0f)
+		{
+
+			new_vertices[index].nx = cluster.nx / normal_length;
+			new_vertices[index].ny = cluster.ny / normal_length;
+			new_vertices[index].nz = cluster.nz / normal_length;
+
+		}
+		else
+		{
+
+			new_vertices[index].nx = 0.0f;
+			new_vertices[index].ny = 1.0f;
+			new_vertices[index].nz = 0.0f;
+
+		}
+
+	}
+
+	result.vertex_data.num_vertices = num_clusters;
+	result.vertex_data.vertex_byte_size = sizeof(gef::Mesh::Vertex);
+	result.vertex_data.vertices = new_vertices;
+
+	// Remap the triangles onto the clusters, dropping any that have collapsed
+	int index_byte_size = num_clusters > 0xffff ? 4 : 2;
+
+	for (std::vector<gef::PrimitiveData*>::const_iterator it = source.primitives.begin(); it != source.primitives.end(); ++it)
+	{
+
+		const gef::PrimitiveData* source_primitive = *it;
+
+		if (source_primitive->type != gef::TRIANGLE_LIST)
+		{
+
+			continue;
+
+		}
+
+		std::vector<gef::UInt32> new_indices;
+		new_indices.reserve(source_primitive->num_indices);
+
+		for (int triangle = 0; triangle + 2 < source_primitive->num_indices; triangle += 3)
+		{
+
+			gef::UInt32 a = vertex_clusters[ReadIndex(source_primitive->indices, source_primitive->index_byte_size, triangle)];
+			gef::UInt32 b = vertex_clusters[ReadIndex(source_primitive->indices, source_primitive->index_byte_size, triangle + 1)];
+			gef::UInt32 c = vertex_clusters[ReadIndex(source_primitive->indices, source_primitive->index_byte_size, triangle + 2)];
+
+			if (a != b && b != c && a != c)
+			{
+
+				new_indices.push_back(a);
+				new_indices.push_back(b);
+				new_indices.push_back(c);
+
+			}
+
+		}
+
+		gef::PrimitiveData* primitive = new gef::PrimitiveData();
+		primitive->type = gef::TRIANGLE_LIST;
+		primitive->material_name_id = source_primitive->material_name_id;
+		primitive->num_indices = (int)new_indices.size();
+		primitive->index_byte_size = index_byte_size;
+		primitive->indices = new gef::UInt8[new_indices.size() * index_byte_size];
+
+		for (unsigned int index = 0; index < new_indices.size(); index++)
+		{
+
+			if (index_byte_size == 2)
+			{
+
+				((gef::UInt16*)primitive->indices)[index] = (gef::UInt16)new_indices[index];
+
+			}
+			else
+			{
+
+				((gef::UInt32*)primitive->indices)[index] = new_indices[index];
+
+			}
+
+		}
+
+		result.primitives.push_back(primitive);
+
+	}
+
+	// The bounds don't grow when clustering, so keep the source mesh's
+	result.aabb = source.aabb;
+	result.bounding_sphere = source.bounding_sphere;
+	result.name_id = source.name_id;
+
+	return true;
+
+}
+
+void MeshSimplifier::AddLods(gef::Scene* scene)
+{
+
+	if (scene->mesh_data.empty())
+	{
+
+		return;
+
+	}
+
+	// Objects draw a scene's first mesh, and the rest of its mesh data is taken as that mesh's LODs,
+	// so any other meshes have to go or they'd be drawn in place of the LODs
+	if (scene->mesh_data.size() > 1)
+	{
+
+		scene->mesh_data.resize(1);
+
+	}
+
+	// List elements don't move when appending, so the source reference stays valid
+	const gef::MeshData& source = scene->mesh_data.front();
+
+	for (int lod = 0; lod < MAX_MESH_LODS - 1; lod++)
+	{
+
+		// Build each LOD in place in the scene so the scene owns its data
+		scene->mesh_data.push_back(gef::MeshData());
+
+		if (!Simplify(source, lod_grid_resolutions[lod], scene->mesh_data.back()))
+		{
+
+			scene->mesh_data.pop_back();
+			return;
+
+		}
+
+	}
+
+}
+
+bool MeshSimplifier::BakeLodScene(gef::Platform* platform_, const char* source_file, const char* lod_file)
+{
+
+	gef::Scene scene;
+
+	if (!scene.ReadSceneFromFile(*platform_, source_file))
+	{
+
+		return false;
+
+	}
+
+	AddLods(&scene);
+
+	return scene.WriteSceneToFile(*platform_, lod_file);
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+// GEF forward declarations
+namespace gef
+{
+
+	class MeshData;
+	class Scene;
+	class Platform;
+
+}
+
+// Number of levels of detail kept for each mesh, including the full resolution mesh
+#define MAX_MESH_LODS 3
+
+// Mesh simplifier class
+// Builds lower levels of detail for scene meshes by clustering vertices on a grid
+// LOD scene files are baked by AssetBaker in BAKE_ASSETS builds, and the LODs are built at load time if there's no baked file
+class MeshSimplifier
+{
+
+public:
+
+	// Simplify a mesh by merging all vertices that share a cell of a grid with the given number of cells per axis
+	static bool Simplify(const gef::MeshData& source, int grid_resolution, gef::MeshData& result);
+
+	// Append simplified copies of the scene's first mesh, so the scene's mesh data runs from finest to coarsest
+	// Any other meshes in the scene are dropped first, leaving its mesh data as exactly the first mesh's LODs
+	static void AddLods(gef::Scene* scene);
+
+	// Load a scene file, add its LODs and write it back out as a LOD scene file
+	static bool BakeLodScene(gef::Platform* platform_, const char* source_file, const char* lod_file);
+
+};
+
+#endif // !MESH_SIMPLIFIER_H
\ No newline at end of file
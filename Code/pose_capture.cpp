@@ -0,0 +1,175 @@
+#include "pose_capture.h"
+#include <algorithm>
+#include <math.h>
+
+// Samples further than this many standard deviations from the median are treated as tracking glitches
+static const float outlier_threshold = 3.0f;
+
+// Scales the median absolute deviation to a standard deviation for normally distributed samples
+static const float mad_to_sigma = 1.4826f;
+
+PoseCapture::PoseCapture() :
+	num_objects_(0),
+	num_frames_(0),
+	num_recorded_(0)
+{
+}
+
+PoseCapture::~PoseCapture()
+{
+
+
+
+}
+
+void PoseCapture::Begin(int num_objects, int num_frames)
+{
+
+	num_objects_ = num_objects;
+	num_frames_ = num_frames;
+	num_recorded_ = 0;
+
+	// Allocate everything up front so recording doesn't allocate
+	samples_.assign(num_objects * MATCH_ELEMENTS * num_frames, 0.0f);
+
+}
+
+void PoseCapture::Cancel()
+{
+
+	num_objects_ = 0;
+	num_frames_ = 0;
+	num_recorded_ = 0;
+	samples_.clear();
+
+}
+
+void PoseCapture::AddFrame(const std::vector<gef::Matrix44>& transforms)
+{
+
+	if (IsComplete() || (int)transforms.size() != num_objects_)
+	{
+
+		return;
+
+	}
+
+	for (int object = 0; object < num_objects_; object++)
+	{
+
+		for (int row = 0; row < 4; row++)
+		{
+
+			gef::Vector4 values = transforms[object].GetRow(row);
+
+			int element = (object * MATCH_ELEMENTS + row * 3) * num_frames_ + num_recorded_;
+			samples_[element] = values.x();
+			samples_[element + num_frames_] = values.y();
+			samples_[element + num_frames_ * 2] = values.z();
+
+		}
+
+	}
+
+	num_recorded_++;
+
+}
+
+bool PoseCapture::Fit(std::vector<gef::Matrix44>& mean_transforms, std::vector<MatchBounds>& bounds)
+{
+
+	if (num_recorded_ == 0)
+	{
+
+		return false;
+
+	}
+
+	mean_transforms.resize(num_objects_);
+	bounds.resize(num_objects_);
+
+	std::vector<float> element_samples;
+
+	for (int object = 0; object < num_objects_; object++)
+	{
+
+		float means[MATCH_ELEMENTS];
+
+		for (int element = 0; element < MATCH_ELEMENTS; element++)
+		{
+
+			std::vector<float>::iterator first = samples_.begin() + (object * MATCH_ELEMENTS + element) * num_frames_;
+			element_samples.assign(first, first + num_recorded_);
+
+			FitElement(element_samples, means[element], bounds[object].sigma[element]);
+
+		}
+
+		// The last column isn't matched, so keep it as an affine transform
+		for (int row = 0; row < 4; row++)
+		{
+
+			mean_transforms[object].SetRow(row, gef::Vector4(means[row * 3], means[row * 3 + 1], means[row * 3 + 2], row == 3 ? 1.0f : 0.0f));
+
+		}
+
+	}
+
+	return true;
+
+}
+
+void PoseCapture::FitElement(std::vector<float>& samples, float& mean, float& sigma)
+{
+
+	size_t num_samples = samples.size();
+
+	// The median and median absolute deviation aren't thrown off by the odd bad frame of tracking
+	std::vector<float>::iterator middle = samples.begin() + num_samples / 2;
+	std::nth_element(samples.begin(), middle, samples.end());
+	float median = *middle;
+
+	std::vector<float> deviations(num_samples);
+	for (size_t sample = 0; sample < num_samples; sample++)
+	{
+
+		deviations[sample] = fabsf(samples[sample] - median);
+
+	}
+
+	std::vector<float>::iterator middle_deviation = deviations.begin() + num_samples / 2;
+	std::nth_element(deviations.begin(), middle_deviation, deviations.end());
+	float robust_sigma = *middle_deviation * mad_to_sigma;
+
+	// Take the mean and standard deviation of the samples that aren't outliers
+	float sum = 0.0f;
+	float sum_squares = 0.0f;
+	int num_inliers = 0;
+
+	for (size_t sample = 0; sample < num_samples; sample++)
+	{
+
+		if (fabsf(samples[sample] - median) <= outlier_threshold * robust_sigma)
+		{
+
+			sum += samples[sample];
+			sum_squares += samples[sample] * samples[sample];
+			num_inliers++;
+
+		}
+
+	}
+
+	mean = sum / num_inliers;
+
+	float variance = sum_squares / num_inliers - mean * mean;
+	sigma = variance > 0.0f ? sqrtf(variance) : 0.0f;
+
+	if (sigma < CAPTURE_MIN_SIGMA)
+	{
+
+		sigma = CAPTURE_MIN_SIGMA;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef POSE_CAPTURE_H
+#define POSE_CAPTURE_H
+
+#include <vector>
+#include <maths/matrix44.h>
+#include "level_definition.h"
+
+// Number of frames recorded when capturing reference transforms
+#define CAPTURE_NUM_FRAMES 180
+
+// Fitted standard deviations are never allowed below this, so a perfectly still capture doesn't give impossible bounds
+#define CAPTURE_MIN_SIGMA 0.004f
+
+// Pose capture class
+// Records the objects' transforms over a number of frames and fits reference transforms and tolerance bounds to them
+// The player holds the markers in the solved configuration, moving them about as much as should still count as solved
+class PoseCapture
+{
+
+public:
+
+	PoseCapture();
+	~PoseCapture();
+
+	// Start recording the given number of objects
+	void Begin(int num_objects, int num_frames);
+	// Stop recording without fitting anything
+	void Cancel();
+
+	// Record one frame of transforms, one per object
+	void AddFrame(const std::vector<gef::Matrix44>& transforms);
+
+	// Fit the robust mean transform and tolerance bounds of each object, returning false if nothing was recorded
+	bool Fit(std::vector<gef::Matrix44>& mean_transforms, std::vector<MatchBounds>& bounds);
+
+	inline bool IsCapturing() { return num_frames_ > 0; };
+	inline bool IsComplete() { return num_frames_ > 0 && num_recorded_ >= num_frames_; };
+	inline int GetNumRecorded() { return num_recorded_; };
+	inline int GetNumFrames() { return num_frames_; };
+
+private:
+
+	// Fit the robust mean and standard deviation of a set of samples of one element
+	static void FitElement(std::vector<float>& samples, float& mean, float& sigma);
+
+	int num_objects_;
+	int num_frames_;
+	int num_recorded_;
+
+	// Samples stored per object, per matched element, per frame
+	std::vector<float> samples_;
+
+};
+
+#endif // !POSE_CAPTURE_H
\ No newline at end of file
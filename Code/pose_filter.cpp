@@ -0,0 +1,289 @@
+#include "pose_filter.h"
+#include <math.h>
+#include "pose_maths.h"
+
+// Multiply two quaternions, so the result rotates by b and then by a
+static gef::Quaternion Multiply(const gef::Quaternion& a, const gef::Quaternion& b)
+{
+
+	return gef::Quaternion(
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+
+}
+
+PoseFilter::PoseFilter()
+{
+
+	Clear();
+
+}
+
+PoseFilter::~PoseFilter()
+{
+
+
+
+}
+
+void PoseFilter::Clear()
+{
+
+	next_observation_ = 0;
+	num_observations_ = 0;
+	observations_since_resum_ = 0;
+
+	weight_sum_ = 0.0f;
+	translation_sum_[0] = translation_sum_[1] = translation_sum_[2] = 0.0f;
+	rotation_sum_[0] = rotation_sum_[1] = rotation_sum_[2] = rotation_sum_[3] = 0.0f;
+	scale_sum_ = 0.0f;
+
+	last_time_ = 0;
+	linear_velocity_ = gef::Vector4(0.0f, 0.0f, 0.0f);
+	angular_velocity_ = gef::Vector4(0.0f, 0.0f, 0.0f);
+	has_velocity_ = false;
+
+}
+
+void PoseFilter::Add(const gef::Matrix44& transform, gef::UInt64 time, float weight)
+{
+
+	Observation observation;
+	PoseMaths::Decompose(transform, observation.translation, observation.rotation, observation.scale);
+	observation.weight = weight;
+
+	if (num_observations_ > 0)
+	{
+
+		// Put the rotation in the same hemisphere as the others, so they don't cancel out when summed
+		float dot = observation.rotation.x * rotation_sum_[0] + observation.rotation.y * rotation_sum_[1]
+			+ observation.rotation.z * rotation_sum_[2] + observation.rotation.w * rotation_sum_[3];
+
+		if (dot < 0.0f)
+		{
+
+			observation.rotation = gef::Quaternion(-observation.rotation.x, -observation.rotation.y, -observation.rotation.z, -observation.rotation.w);
+			dot = -dot;
+
+		}
+
+		// A big jump means the marker really moved, or was mistracked, so start again rather than lag behind it
+		float rotation_length = sqrtf(rotation_sum_[0] * rotation_sum_[0] + rotation_sum_[1] * rotation_sum_[1]
+			+ rotation_sum_[2] * rotation_sum_[2] + rotation_sum_[3] * rotation_sum_[3]);
+		gef::Vector4 fused_translation(translation_sum_[0] / weight_sum_, translation_sum_[1] / weight_sum_, translation_sum_[2] / weight_sum_);
+
+		if ((observation.translation - fused_translation).LengthSqr() > POSE_FILTER_RESET_DISTANCE * POSE_FILTER_RESET_DISTANCE
+			|| dot < POSE_FILTER_RESET_DOT * rotation_length)
+		{
+
+			Clear();
+
+		}
+
+	}
+
+	// Take the oldest observation out of the sums once the window is full
+	if (num_observations_ == POSE_FILTER_WINDOW)
+	{
+
+		const Observation& oldest = observations_[next_observation_];
+		weight_sum_ -= oldest.weight;
+		translation_sum_[0] -= oldest.translation.x() * oldest.weight;
+		translation_sum_[1] -= oldest.translation.y() * oldest.weight;
+		translation_sum_[2] -= oldest.translation.z() * oldest.weight;
+		rotation_sum_[0] -= oldest.rotation.x * oldest.weight;
+		rotation_sum_[1] -= oldest.rotation.y * oldest.weight;
+		rotation_sum_[2] -= oldest.rotation.z * oldest.weight;
+		rotation_sum_[3] -= oldest.rotation.w * oldest.weight;
+		scale_sum_ -= oldest.scale * oldest.weight;
+
+	}
+	else
+	{
+
+		num_observations_++;
+
+	}
+
+	observations_[next_observation_] = observation;
+	next_observation_ = (next_observation_ + 1) % POSE_FILTER_WINDOW;
+
+	weight_sum_ += observation.weight;
+	translation_sum_[0] += observation.translation.x() * observation.weight;
+	translation_sum_[1] += observation.translation.y() * observation.weight;
+	translation_sum_[2] += observation.translation.z() * observation.weight;
+	rotation_sum_[0] += observation.rotation.x * observation.weight;
+	rotation_sum_[1] += observation.rotation.y * observation.weight;
+	rotation_sum_[2] += observation.rotation.z * observation.weight;
+	rotation_sum_[3] += observation.rotation.w * observation.weight;
+	scale_sum_ += observation.scale * observation.weight;
+
+	if (++observations_since_resum_ >= POSE_FILTER_RESUM_INTERVAL)
+	{
+
+		Resum();
+
+	}
+
+	// Work out the velocity from how far the fused pose has moved since the last observation
+	gef::Vector4 translation;
+	gef::Quaternion rotation;
+	float scale;
+	GetFusedParts(translation, rotation, scale);
+
+	if (num_observations_ > 1 && time > last_time_)
+	{
+
+		float inv_time_step = 1000000.0f / (float)(time - last_time_);
+		linear_velocity_ = (translation - last_translation_) * inv_time_step;
+
+		// The rotation since the last observation, taking the short way round
+		gef::Quaternion inv_last_rotation(-last_rotation_.x, -last_rotation_.y, -last_rotation_.z, last_rotation_.w);
+		gef::Quaternion delta = Multiply(rotation, inv_last_rotation);
+		if (delta.w < 0.0f)
+		{
+
+			delta = gef::Quaternion(-delta.x, -delta.y, -delta.z, -delta.w);
+
+		}
+
+		gef::Vector4 axis(delta.x, delta.y, delta.z);
+		float sin_half_angle = axis.Length();
+		if (sin_half_angle > 0.0f)
+		{
+
+			float angle = 2.0f * atan2f(sin_half_angle, delta.w);
+			angular_velocity_ = axis * (angle * inv_time_step / sin_half_angle);
+
+		}
+		else
+		{
+
+			angular_velocity_ = gef::Vector4(0.0f, 0.0f, 0.0f);
+
+		}
+
+		has_velocity_ = true;
+
+	}
+
+	last_translation_ = translation;
+	last_rotation_ = rotation;
+	last_time_ = time;
+
+}
+
+void PoseFilter::GetFused(gef::Matrix44& transform) const
+{
+
+	if (num_observations_ == 0 || !(weight_sum_ > 0.0f))
+	{
+
+		transform.SetIdentity();
+		return;
+
+	}
+
+	gef::Vector4 translation;
+	gef::Quaternion rotation;
+	float scale;
+	GetFusedParts(translation, rotation, scale);
+
+	PoseMaths::Compose(translation, rotation, scale, transform);
+
+}
+
+void PoseFilter::GetExtrapolated(gef::UInt64 time, gef::Matrix44& transform) const
+{
+
+	if (num_observations_ == 0 || !(weight_sum_ > 0.0f))
+	{
+
+		transform.SetIdentity();
+		return;
+
+	}
+
+	gef::Vector4 translation;
+	gef::Quaternion rotation;
+	float scale;
+	GetFusedParts(translation, rotation, scale);
+
+	if (has_velocity_ && time > last_time_)
+	{
+
+		// Don't run off too far if observations stop coming
+		gef::UInt64 elapsed = time - last_time_;
+		if (elapsed > POSE_FILTER_MAX_EXTRAPOLATION)
+		{
+
+			elapsed = POSE_FILTER_MAX_EXTRAPOLATION;
+
+		}
+
+		float time_step = elapsed / 1000000.0f;
+		translation = translation + linear_velocity_ * time_step;
+
+		// Keep turning about the same axis at the same rate
+		float angular_speed = angular_velocity_.Length();
+		if (angular_speed > 0.0f)
+		{
+
+			float half_angle = 0.5f * angular_speed * time_step;
+			gef::Vector4 axis = angular_velocity_ * (sinf(half_angle) / angular_speed);
+			rotation = Multiply(gef::Quaternion(axis.x(), axis.y(), axis.z(), cosf(half_angle)), rotation);
+
+		}
+
+	}
+
+	PoseMaths::Compose(translation, rotation, scale, transform);
+
+}
+
+void PoseFilter::GetFusedParts(gef::Vector4& translation, gef::Quaternion& rotation, float& scale) const
+{
+
+	float inv_weight_sum = weight_sum_ > 0.0f ? 1.0f / weight_sum_ : 0.0f;
+	translation = gef::Vector4(translation_sum_[0] * inv_weight_sum, translation_sum_[1] * inv_weight_sum, translation_sum_[2] * inv_weight_sum);
+
+	// The weights cancel out when the mean quaternion is normalised
+	float rotation_length = sqrtf(rotation_sum_[0] * rotation_sum_[0] + rotation_sum_[1] * rotation_sum_[1]
+		+ rotation_sum_[2] * rotation_sum_[2] + rotation_sum_[3] * rotation_sum_[3]);
+	float inv_rotation_length = rotation_length > 0.0f ? 1.0f / rotation_length : 0.0f;
+	rotation = gef::Quaternion(rotation_sum_[0] * inv_rotation_length, rotation_sum_[1] * inv_rotation_length,
+		rotation_sum_[2] * inv_rotation_length, rotation_sum_[3] * inv_rotation_length);
+
+	scale = scale_sum_ * inv_weight_sum;
+
+}
+
+void PoseFilter::Resum()
+{
+
+	weight_sum_ = 0.0f;
+	translation_sum_[0] = translation_sum_[1] = translation_sum_[2] = 0.0f;
+	rotation_sum_[0] = rotation_sum_[1] = rotation_sum_[2] = rotation_sum_[3] = 0.0f;
+	scale_sum_ = 0.0f;
+
+	for (int index = 0; index < num_observations_; index++)
+	{
+
+		const Observation& observation = observations_[index];
+		weight_sum_ += observation.weight;
+		translation_sum_[0] += observation.translation.x() * observation.weight;
+		translation_sum_[1] += observation.translation.y() * observation.weight;
+		translation_sum_[2] += observation.translation.z() * observation.weight;
+		rotation_sum_[0] += observation.rotation.x * observation.weight;
+		rotation_sum_[1] += observation.rotation.y * observation.weight;
+		rotation_sum_[2] += observation.rotation.z * observation.weight;
+		rotation_sum_[3] += observation.rotation.w * observation.weight;
+		scale_sum_ += observation.scale * observation.weight;
+
+	}
+
+	observations_since_resum_ = 0;
+
+}
\ No newline at end of file
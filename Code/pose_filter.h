@@ -0,0 +1,95 @@
+#ifndef POSE_FILTER_H
+#define POSE_FILTER_H
+
+#include <maths/vector4.h>
+#include <maths/matrix44.h>
+#include <maths/quaternion.h>
+#include <gef.h>
+
+// Number of observations fused together
+#define POSE_FILTER_WINDOW 4
+// Number of observations between recalculating the running sums from scratch, to stop rounding errors building up
+#define POSE_FILTER_RESUM_INTERVAL 256
+// Distance an observation can jump from the fused pose before the window is restarted rather than smeared across it
+#define POSE_FILTER_RESET_DISTANCE 0.05f
+// Smallest dot product between an observation's rotation and the fused rotation before the window is restarted,
+// around 20 degrees
+#define POSE_FILTER_RESET_DOT 0.985f
+// Longest the pose is extrapolated for without a new observation, in microseconds
+#define POSE_FILTER_MAX_EXTRAPOLATION 100000
+
+// Pose filter class
+// Fuses the last few observations of a marker's pose into one, as the weighted least squares pose over the window
+// Translation and scale are weighted means, and the rotation is the normalised weighted mean of the quaternions,
+// which minimises the summed squared chordal distance to them
+// The sums are kept running, so adding an observation and dropping the oldest is constant time however large the window
+// The velocity between successive fused poses is kept too, so the pose can be extrapolated between observations
+class PoseFilter
+{
+
+public:
+
+	PoseFilter();
+	~PoseFilter();
+
+	// Add an observation of the pose made at a time in microseconds, dropping the oldest if the window is full
+	void Add(const gef::Matrix44& transform, gef::UInt64 time, float weight = 1.0f);
+
+	// Forget all the observations, e.g. when the marker is lost
+	void Clear();
+
+	// Get the fused pose, which is only valid if there's at least one observation
+	void GetFused(gef::Matrix44& transform) const;
+
+	// Get the fused pose moved on by its velocity to a time in microseconds, or just the fused pose if there's no velocity yet
+	void GetExtrapolated(gef::UInt64 time, gef::Matrix44& transform) const;
+
+	inline int GetNumObservations() const { return num_observations_; };
+	// Whether there have been enough observations since the last restart to know how the pose is moving
+	inline bool HasVelocity() const { return has_velocity_; };
+	// Get the speeds, in units and radians per second
+	inline float GetLinearSpeed() const { return linear_velocity_.Length(); };
+	inline float GetAngularSpeed() const { return angular_velocity_.Length(); };
+
+private:
+
+	struct Observation
+	{
+
+		gef::Vector4 translation;
+		// Flipped when needed to be in the same hemisphere as the others, since q and -q are the same rotation
+		gef::Quaternion rotation;
+		float scale;
+		float weight;
+
+	};
+
+	// Recalculate the running sums from the observations in the window
+	void Resum();
+	// Get the fused translation, rotation and scale from the running sums
+	void GetFusedParts(gef::Vector4& translation, gef::Quaternion& rotation, float& scale) const;
+
+	Observation observations_[POSE_FILTER_WINDOW];
+	// Index the next observation is written to, which is the oldest once the window is full
+	int next_observation_;
+	int num_observations_;
+	int observations_since_resum_;
+
+	// Running weighted sums of the observations in the window
+	float weight_sum_;
+	float translation_sum_[3];
+	float rotation_sum_[4];
+	float scale_sum_;
+
+	// Fused pose at the last observation, and how fast it's moving
+	gef::Vector4 last_translation_;
+	gef::Quaternion last_rotation_;
+	gef::UInt64 last_time_;
+	gef::Vector4 linear_velocity_;
+	// Axis of rotation scaled by the angular speed
+	gef::Vector4 angular_velocity_;
+	bool has_velocity_;
+
+};
+
+#endif // !POSE_FILTER_H
\ No newline at end of file
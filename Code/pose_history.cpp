@@ -0,0 +1,70 @@
+#include "pose_history.h"
+#include <string.h>
+#include <vector>
+#include "compact_pose.h"
+
+PoseHistory::PoseHistory() :
+	next_frame_(0),
+	num_frames_(0)
+{
+}
+
+PoseHistory::~PoseHistory()
+{
+
+
+
+}
+
+void PoseHistory::Record(const PoseHistoryFrame& frame)
+{
+
+	memcpy(&frames_[next_frame_], &frame, sizeof(PoseHistoryFrame));
+
+	next_frame_ = next_frame_ + 1 == POSE_HISTORY_FRAMES ? 0 : next_frame_ + 1;
+	if (num_frames_ < POSE_HISTORY_FRAMES)
+	{
+
+		num_frames_++;
+
+	}
+
+}
+
+const PoseHistoryFrame& PoseHistory::GetFrame(int frames_ago) const
+{
+
+	int index = next_frame_ - 1 - frames_ago;
+	if (index < 0)
+	{
+
+		index += POSE_HISTORY_FRAMES;
+
+	}
+
+	return frames_[index];
+
+}
+
+bool PoseHistory::WriteTrace(const char* file_name) const
+{
+
+	std::vector<gef::Matrix44> transforms;
+	transforms.reserve(num_frames_ * POSE_HISTORY_OBJECTS);
+
+	for (int frames_ago = num_frames_ - 1; frames_ago >= 0; frames_ago--)
+	{
+
+		const PoseHistoryFrame& frame = GetFrame(frames_ago);
+		for (int object = 0; object < POSE_HISTORY_OBJECTS; object++)
+		{
+
+			transforms.push_back(frame.camera_transforms[object]);
+
+		}
+
+	}
+
+	return PoseCodec::WritePoseFile(file_name, transforms.empty() ? NULL : &transforms[0], (int)transforms.size());
+
+}
\ No newline at end of file
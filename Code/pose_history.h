@@ -0,0 +1,76 @@
+#ifndef POSE_HISTORY_H
+#define POSE_HISTORY_H
+
+#include <gef.h>
+#include <maths/matrix44.h>
+
+// Number of frames kept, five seconds at 60 frames per second
+#define POSE_HISTORY_FRAMES 300
+
+// Number of objects recorded, the two marker objects that are matched
+#define POSE_HISTORY_OBJECTS 2
+
+// The tracking, filtering and matching state of one frame
+// This is plain data, so recording a frame is a single copy into the ring
+struct PoseHistoryFrame
+{
+
+	// Frame number and the time the poses were sampled at, in microseconds
+	gef::UInt32 frame;
+	gef::UInt64 time;
+	// Whether the tracking library ran, rather than the poses being extrapolated from the filters
+	bool is_tracked;
+
+	// Each object's drawn transform, and the view it was drawn with
+	bool is_active[POSE_HISTORY_OBJECTS];
+	gef::Matrix44 object_transforms[POSE_HISTORY_OBJECTS];
+	gef::Matrix44 view_transform;
+	// Each object's transform in camera space, which is what was checked against the reference transforms
+	gef::Matrix44 camera_transforms[POSE_HISTORY_OBJECTS];
+	// Marker 01 relative to marker 02, which the solutions are matched against
+	gef::Matrix44 relative_transform;
+
+	// State of each marker's pose filter
+	int filter_observations[POSE_HISTORY_OBJECTS];
+	float linear_speeds[POSE_HISTORY_OBJECTS];
+	float angular_speeds[POSE_HISTORY_OBJECTS];
+
+	// Result of the transform check, and the solution matched if the level has several
+	bool is_matched;
+	int matched_solution;
+
+};
+
+// Pose history class
+// Fixed size ring of the last POSE_HISTORY_FRAMES frames, so what led up to a failed match can be looked back over
+// The memory used never changes, and recording a frame overwrites the oldest once the ring is full
+class PoseHistory
+{
+
+public:
+
+	PoseHistory();
+	~PoseHistory();
+
+	// Copy a frame into the ring
+	void Record(const PoseHistoryFrame& frame);
+	// Forget every frame, e.g. when the level changes
+	inline void Clear() { next_frame_ = 0; num_frames_ = 0; };
+
+	inline int GetNumFrames() const { return num_frames_; };
+	// Get a frame by how many frames before the newest it was recorded, which must be less than GetNumFrames
+	const PoseHistoryFrame& GetFrame(int frames_ago) const;
+
+	// Write every frame's camera space transforms out as compact poses, oldest first with POSE_HISTORY_OBJECTS per frame
+	bool WriteTrace(const char* file_name) const;
+
+private:
+
+	PoseHistoryFrame frames_[POSE_HISTORY_FRAMES];
+	// Index the next frame is written to, which is the oldest once the ring is full
+	int next_frame_;
+	int num_frames_;
+
+};
+
+#endif // !POSE_HISTORY_H
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "pose_index.h"
+#include <algorithm>
+#include <math.h>
+#include "pose_maths.h"
+
+// Orders candidates along one axis, for building the tree
+struct CompareAxis
+{
+
+	int axis;
+
+	template <class T>
+	bool operator()(const T& a, const T& b) const
+	{
+
+		return a.translation[axis] < b.translation[axis];
+
+	}
+
+};
+
+PoseIndex::PoseIndex()
+{
+}
+
+PoseIndex::~PoseIndex()
+{
+
+
+
+}
+
+void PoseIndex::Clear()
+{
+
+	candidates_.clear();
+
+}
+
+void PoseIndex::Add(const gef::Matrix44& pose, int solution)
+{
+
+	gef::Vector4 translation;
+	float scale;
+
+	Candidate candidate;
+	PoseMaths::Decompose(pose, translation, candidate.rotation, scale);
+	candidate.translation[0] = translation.x();
+	candidate.translation[1] = translation.y();
+	candidate.translation[2] = translation.z();
+	candidate.solution = solution;
+
+	candidates_.push_back(candidate);
+
+}
+
+void PoseIndex::Build()
+{
+
+	BuildNode(0, (int)candidates_.size(), 0);
+
+}
+
+void PoseIndex::BuildNode(int begin, int end, int depth)
+{
+
+	if (end - begin <= 1)
+	{
+
+		return;
+
+	}
+
+	// Partition around the median so each half of the subtree is the same size
+	int middle = (begin + end) / 2;
+	CompareAxis compare;
+	compare.axis = depth % 3;
+	std::nth_element(candidates_.begin() + begin, candidates_.begin() + middle, candidates_.begin() + end, compare);
+
+	BuildNode(begin, middle, depth + 1);
+	BuildNode(middle + 1, end, depth + 1);
+
+}
+
+int PoseIndex::FindMatch(const gef::Matrix44& pose, float translation_tolerance, float rotation_tolerance)
+{
+
+	if (candidates_.empty())
+	{
+
+		return -1;
+
+	}
+
+	gef::Vector4 pose_translation;
+	gef::Quaternion rotation;
+	float scale;
+	PoseMaths::Decompose(pose, pose_translation, rotation, scale);
+
+	float translation[3] = { pose_translation.x(), pose_translation.y(), pose_translation.z() };
+
+	// Two rotations are within an angle of each other when the dot product of their quaternions is above cos(angle / 2)
+	float min_rotation_dot = cosf(rotation_tolerance * 0.5f);
+
+	float best_distance_squared = translation_tolerance * translation_tolerance;
+	int best_candidate = -1;
+
+	SearchNode(0, (int)candidates_.size(), 0, translation, rotation, min_rotation_dot, best_distance_squared, best_candidate);
+
+	return best_candidate < 0 ? -1 : candidates_[best_candidate].solution;
+
+}
+
+void PoseIndex::SearchNode(int begin, int end, int depth, const float* translation, const gef::Quaternion& rotation,
+	float min_rotation_dot, float& best_distance_squared, int& best_candidate)
+{
+
+	if (begin >= end)
+	{
+
+		return;
+
+	}
+
+	int middle = (begin + end) / 2;
+	const Candidate& candidate = candidates_[middle];
+
+	float dx = translation[0] - candidate.translation[0];
+	float dy = translation[1] - candidate.translation[1];
+	float dz = translation[2] - candidate.translation[2];
+	float distance_squared = dx * dx + dy * dy + dz * dz;
+
+	// Only take the candidate if it's closer than the best so far and its rotation matches as well
+	if (distance_squared <= best_distance_squared)
+	{
+
+		// q and -q are the same rotation, so compare the absolute dot product
+		float dot = fabsf(rotation.x * candidate.rotation.x + rotation.y * candidate.rotation.y
+			+ rotation.z * candidate.rotation.z + rotation.w * candidate.rotation.w);
+
+		if (dot >= min_rotation_dot)
+		{
+
+			best_distance_squared = distance_squared;
+			best_candidate = middle;
+
+		}
+
+	}
+
+	// Search the side of the split the pose is on first, then the other side if it could still hold something closer
+	int axis = depth % 3;
+	float split_distance = translation[axis] - candidate.translation[axis];
+
+	if (split_distance < 0.0f)
+	{
+
+		SearchNode(begin, middle, depth + 1, translation, rotation, min_rotation_dot, best_distance_squared, best_candidate);
+
+		if (split_distance * split_distance <= best_distance_squared)
+		{
+
+			SearchNode(middle + 1, end, depth + 1, translation, rotation, min_rotation_dot, best_distance_squared, best_candidate);
+
+		}
+
+	}
+	else
+	{
+
+		SearchNode(middle + 1, end, depth + 1, translation, rotation, min_rotation_dot, best_distance_squared, best_candidate);
+
+		if (split_distance * split_distance <= best_distance_squared)
+		{
+
+			SearchNode(begin, middle, depth + 1, translation, rotation, min_rotation_dot, best_distance_squared, best_candidate);
+
+		}
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef POSE_INDEX_H
+#define POSE_INDEX_H
+
+#include <vector>
+#include <maths/matrix44.h>
+#include <maths/quaternion.h>
+
+// Pose index class
+// Spatial index over many candidate poses, so a live pose can be matched against all of them in logarithmic time
+// Candidates are stored as an implicit k-d tree over translation, and the rotation is checked for the candidates nearby
+class PoseIndex
+{
+
+public:
+
+	PoseIndex();
+	~PoseIndex();
+
+	// Remove all of the candidates
+	void Clear();
+	// Add a candidate pose, with the identifier of the solution it belongs to
+	void Add(const gef::Matrix44& pose, int solution);
+	// Arrange the candidates into the tree, must be called after adding and before matching
+	void Build();
+
+	// Find the nearest candidate within the translation tolerance whose rotation is also within tolerance
+	// Returns the candidate's solution identifier, or -1 if nothing matches
+	int FindMatch(const gef::Matrix44& pose, float translation_tolerance, float rotation_tolerance);
+
+	inline bool IsEmpty() { return candidates_.empty(); };
+	inline int GetNumCandidates() { return (int)candidates_.size(); };
+
+private:
+
+	struct Candidate
+	{
+
+		float translation[3];
+		gef::Quaternion rotation;
+		int solution;
+
+	};
+
+	// Sort the candidates between begin and end into a balanced subtree
+	void BuildNode(int begin, int end, int depth);
+	// Search the subtree between begin and end for the nearest matching candidate
+	void SearchNode(int begin, int end, int depth, const float* translation, const gef::Quaternion& rotation,
+		float min_rotation_dot, float& best_distance_squared, int& best_candidate);
+
+	// Candidates in tree order, each subtree's median is its root and splits on axis depth % 3
+	std::vector<Candidate> candidates_;
+
+};
+
+#endif // !POSE_INDEX_H
\ No newline at end of file
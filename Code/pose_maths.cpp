@@ -0,0 +1,217 @@
+#include "pose_maths.h"
+#include <math.h>
+#include <float.h>
+
+float PoseMaths::GetElement(const gef::Matrix44& transform, int row, int column)
+{
+
+	gef::Vector4 values = transform.GetRow(row);
+
+	switch (column)
+	{
+
+	case 0:
+		return values.x();
+	case 1:
+		return values.y();
+	case 2:
+		return values.z();
+	default:
+		return values.w();
+
+	}
+
+}
+
+void PoseMaths::Decompose(const gef::Matrix44& transform, gef::Vector4& translation, gef::Quaternion& rotation, float& scale)
+{
+
+	translation = transform.GetTranslation();
+
+	// Our transforms are uniformly scaled, so average the lengths of the rotation rows
+	scale = (transform.GetRow(0).Length() + transform.GetRow(1).Length() + transform.GetRow(2).Length()) / 3.0f;
+
+	float inv_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+	// Transpose as we go so r[i][j] is the usual column vector rotation matrix
+	float r[3][3];
+	for (int row = 0; row < 3; row++)
+	{
+
+		for (int column = 0; column < 3; column++)
+		{
+
+			r[column][row] = GetElement(transform, row, column) * inv_scale;
+
+		}
+
+	}
+
+	// Pick the most numerically stable way round depending on the largest diagonal term
+	float trace = r[0][0] + r[1][1] + r[2][2];
+
+	if (trace > 0.0f)
+	{
+
+		float s = sqrtf(trace + 1.0f) * 2.0f;
+		rotation.w = 0.25f * s;
+		rotation.x = (r[2][1] - r[1][2]) / s;
+		rotation.y = (r[0][2] - r[2][0]) / s;
+		rotation.z = (r[1][0] - r[0][1]) / s;
+
+	}
+	else if (r[0][0] > r[1][1] && r[0][0] > r[2][2])
+	{
+
+		float s = sqrtf(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+		rotation.w = (r[2][1] - r[1][2]) / s;
+		rotation.x = 0.25f * s;
+		rotation.y = (r[0][1] + r[1][0]) / s;
+		rotation.z = (r[0][2] + r[2][0]) / s;
+
+	}
+	else if (r[1][1] > r[2][2])
+	{
+
+		float s = sqrtf(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+		rotation.w = (r[0][2] - r[2][0]) / s;
+		rotation.x = (r[0][1] + r[1][0]) / s;
+		rotation.y = 0.25f * s;
+		rotation.z = (r[1][2] + r[2][1]) / s;
+
+	}
+	else
+	{
+
+		float s = sqrtf(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+		rotation.w = (r[1][0] - r[0][1]) / s;
+		rotation.x = (r[0][2] + r[2][0]) / s;
+		rotation.y = (r[1][2] + r[2][1]) / s;
+		rotation.z = 0.25f * s;
+
+	}
+
+}
+
+void PoseMaths::Compose(const gef::Vector4& translation, const gef::Quaternion& rotation, float scale, gef::Matrix44& transform)
+{
+
+	float x = rotation.x;
+	float y = rotation.y;
+	float z = rotation.z;
+	float w = rotation.w;
+
+	// Rows are the columns of the usual column vector rotation matrix
+	transform.SetRow(0, gef::Vector4((1.0f - 2.0f * (y * y + z * z)) * scale, 2.0f * (x * y + z * w) * scale, 2.0f * (x * z - y * w) * scale, 0.0f));
+	transform.SetRow(1, gef::Vector4(2.0f * (x * y - z * w) * scale, (1.0f - 2.0f * (x * x + z * z)) * scale, 2.0f * (y * z + x * w) * scale, 0.0f));
+	transform.SetRow(2, gef::Vector4(2.0f * (x * z + y * w) * scale, 2.0f * (y * z - x * w) * scale, (1.0f - 2.0f * (x * x + y * y)) * scale, 0.0f));
+	transform.SetRow(3, gef::Vector4(translation.x(), translation.y(), translation.z(), 1.0f));
+
+}
+
+bool PoseMaths::IsFinite(const gef::Matrix44& transform)
+{
+
+	for (int row = 0; row < 4; row++)
+	{
+
+		for (int column = 0; column < 4; column++)
+		{
+
+			// NaNs fail every comparison, and infinities are caught by the range check
+			float element = GetElement(transform, row, column);
+			if (!(element >= -FLT_MAX && element <= FLT_MAX))
+			{
+
+				return false;
+
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+bool PoseMaths::IsInvertible(const gef::Matrix44& transform)
+{
+
+	gef::Vector4 x_axis = transform.GetRow(0);
+	gef::Vector4 y_axis = transform.GetRow(1);
+	gef::Vector4 z_axis = transform.GetRow(2);
+
+	// The determinant is the volume of the box spanned by the rotation rows, and the product of their lengths
+	// is the volume it would have if they were perpendicular, so their ratio doesn't depend on the scale
+	float x_length = x_axis.Length();
+	float y_length = y_axis.Length();
+	float z_length = z_axis.Length();
+	float volume = x_length * y_length * z_length;
+	if (!(x_length >= POSE_MIN_AXIS_LENGTH && y_length >= POSE_MIN_AXIS_LENGTH && z_length >= POSE_MIN_AXIS_LENGTH))
+	{
+
+		return false;
+
+	}
+
+	float determinant = x_axis.x() * (y_axis.y() * z_axis.z() - y_axis.z() * z_axis.y())
+		- x_axis.y() * (y_axis.x() * z_axis.z() - y_axis.z() * z_axis.x())
+		+ x_axis.z() * (y_axis.x() * z_axis.y() - y_axis.y() * z_axis.x());
+
+	return fabsf(determinant) >= POSE_MIN_RELATIVE_DETERMINANT * volume;
+
+}
+
+bool PoseMaths::GetLocalTransform(const gef::Matrix44& transform, const gef::Matrix44& parent, gef::Matrix44& local)
+{
+
+	if (!IsFinite(transform) || !IsFinite(parent) || !IsInvertible(parent))
+	{
+
+		return false;
+
+	}
+
+	gef::Matrix44 inv_parent;
+	inv_parent.Inverse(parent);
+	gef::Matrix44 result = transform * inv_parent;
+
+	// Extreme but finite inputs can still overflow
+	if (!IsFinite(result))
+	{
+
+		return false;
+
+	}
+
+	local = result;
+	return true;
+
+}
+
+bool PoseMaths::IsWithinTolerance(const gef::Matrix44& transform, const gef::Matrix44& reference, float tolerance, float translation_tolerance)
+{
+
+	for (int row = 0; row < 4; row++)
+	{
+
+		gef::Vector4 values = transform.GetRow(row);
+		gef::Vector4 reference_values = reference.GetRow(row);
+		float row_tolerance = row == 3 ? translation_tolerance : tolerance;
+
+		// Written so a NaN fails the comparison rather than passing it
+		if (!(fabsf(values.x() - reference_values.x()) < row_tolerance
+			&& fabsf(values.y() - reference_values.y()) < row_tolerance
+			&& fabsf(values.z() - reference_values.z()) < row_tolerance))
+		{
+
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef POSE_MATHS_H
+#define POSE_MATHS_H
+
+#include <maths/vector4.h>
+#include <maths/matrix44.h>
+#include <maths/quaternion.h>
+
+// Smallest determinant of a transform's rotation part, relative to the cube of its scale, that's still inverted
+// A rigid, uniformly scaled transform has a relative determinant of one, so anything far below it has collapsed
+#define POSE_MIN_RELATIVE_DETERMINANT 1.0e-3f
+// Shortest a transform's rotation rows can be before it's treated as having collapsed
+#define POSE_MIN_AXIS_LENGTH 1.0e-4f
+
+// Pose maths class
+// Helpers for splitting GEF transforms into translation, rotation and uniform scale and back again
+// GEF transforms row vectors, so the rotation rows of a matrix are the transformed basis vectors
+class PoseMaths
+{
+
+public:
+
+	// Split a transform into its translation, rotation and uniform scale
+	static void Decompose(const gef::Matrix44& transform, gef::Vector4& translation, gef::Quaternion& rotation, float& scale);
+
+	// Build a transform from a translation, rotation and uniform scale
+	static void Compose(const gef::Vector4& translation, const gef::Quaternion& rotation, float scale, gef::Matrix44& transform);
+
+	// Get a single element of a matrix
+	static float GetElement(const gef::Matrix44& transform, int row, int column);
+
+	// Get whether every element of a transform is a finite number
+	static bool IsFinite(const gef::Matrix44& transform);
+
+	// Get whether a transform is far enough from singular to be inverted reliably
+	static bool IsInvertible(const gef::Matrix44& transform);
+
+	// Get a transform relative to a parent transform, i.e. transform * inverse(parent)
+	// Returns false without touching local if either transform isn't finite or the parent can't be inverted
+	static bool GetLocalTransform(const gef::Matrix44& transform, const gef::Matrix44& parent, gef::Matrix44& local);
+
+	// Get whether the x, y and z of every row of a transform are strictly within a tolerance of a reference transform's
+	// The translation row has its own tolerance, as it isn't scaled like the rotation rows
+	// Anything compared with a NaN is out of tolerance
+	static bool IsWithinTolerance(const gef::Matrix44& transform, const gef::Matrix44& reference, float tolerance, float translation_tolerance);
+
+};
+
+#endif // !POSE_MATHS_H
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "profiler.h"
+#include <kernel.h>
+
+Profiler::Profiler()
+{
+
+	BeginFrame();
+
+	for (int value = 0; value < NUM_PROFILER_VALUES; value++)
+	{
+
+		values_[value] = 0.0f;
+
+	}
+
+	for (int timer = 0; timer < NUM_PROFILER_TIMERS; timer++)
+	{
+
+		timers_[timer] = 0.0f;
+		timer_starts_[timer] = 0;
+
+	}
+
+}
+
+Profiler::~Profiler()
+{
+
+
+
+}
+
+void Profiler::BeginFrame()
+{
+
+	for (int counter = 0; counter < NUM_PROFILER_COUNTERS; counter++)
+	{
+
+		counters_[counter] = 0;
+
+	}
+
+}
+
+gef::UInt64 Profiler::GetTime()
+{
+
+	return sceKernelGetProcessTimeWide();
+
+}
\ No newline at end of file
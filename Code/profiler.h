@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <gef.h>
+
+// Enumerated type for the statistics the profiler keeps track of
+enum ProfilerCounter
+{
+
+	PROFILER_COUNTER_OBJECTS_VISIBLE,		// Objects that passed culling and were submitted for drawing
+	PROFILER_COUNTER_OBJECTS_CULLED,		// Objects that were active but outside the view frustum
+	NUM_PROFILER_COUNTERS
+
+};
+
+// Enumerated type for measurements that are kept until they're next measured
+enum ProfilerValue
+{
+
+	PROFILER_VALUE_INPUT_LATENCY,			// Milliseconds from a button press being read to its result being presented
+	PROFILER_VALUE_STARTUP_SETUP,			// Milliseconds spent creating the renderers and reading the asset bundle at startup
+	PROFILER_VALUE_STARTUP_TRACKING,		// Milliseconds spent initialising the tracking library at startup
+	PROFILER_VALUE_STARTUP_UI_DECODE,		// Milliseconds spent decoding the UI textures at startup
+	PROFILER_VALUE_STARTUP_LEVEL_READ,		// Milliseconds spent reading the first level's scenes at startup
+	PROFILER_VALUE_STARTUP_LOADING,			// Milliseconds from starting the tasks above, which run together, to them all finishing
+	PROFILER_VALUE_STARTUP_UPLOAD,			// Milliseconds spent creating the textures, font and meshes once loading had finished
+	PROFILER_VALUE_TIME_TO_FIRST_FRAME,		// Milliseconds from the process starting to the first frame being presented
+	NUM_PROFILER_VALUES
+
+};
+
+// Enumerated type for the stages of a frame that are timed
+enum ProfilerTimer
+{
+
+	PROFILER_TIMER_TRACKING,				// Sampling the camera image and tracking the markers
+	PROFILER_TIMER_SIMULATION,				// Stepping the objects and checking their transforms
+	PROFILER_TIMER_RENDER,					// Drawing the camera image and the level
+	PROFILER_TIMER_UI,						// Drawing the UI sprites and text
+	NUM_PROFILER_TIMERS
+
+};
+
+// Profiler class
+// Gathers per-frame statistics from the rest of the application so they can be displayed
+class Profiler
+{
+
+public:
+
+	Profiler();
+	~Profiler();
+
+	// Clear the counters at the start of a frame
+	void BeginFrame();
+
+	// Add to one of the counters
+	inline void AddCount(ProfilerCounter counter, int value) { counters_[counter] += value; };
+
+	// Get a counter's value for the current frame
+	inline int GetCount(ProfilerCounter counter) { return counters_[counter]; };
+
+	// Set and get the latest measurement of a value
+	inline void SetValue(ProfilerValue value, float measurement) { values_[value] = measurement; };
+	inline float GetValue(ProfilerValue value) { return values_[value]; };
+
+	// Time a stage of the frame, which is kept until the stage is next timed
+	inline void BeginTimer(ProfilerTimer timer) { timer_starts_[timer] = GetTime(); };
+	inline void EndTimer(ProfilerTimer timer) { timers_[timer] = (GetTime() - timer_starts_[timer]) / 1000.0f; };
+
+	// Get how long a stage took the last time it was timed, in milliseconds
+	inline float GetTimer(ProfilerTimer timer) { return timers_[timer]; };
+
+	// Get the current time in microseconds
+	static gef::UInt64 GetTime();
+
+private:
+
+	int counters_[NUM_PROFILER_COUNTERS];
+	float values_[NUM_PROFILER_VALUES];
+	float timers_[NUM_PROFILER_TIMERS];
+	gef::UInt64 timer_starts_[NUM_PROFILER_TIMERS];
+
+};
+
+#endif // !PROFILER_H
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "render_queue.h"
+#include <algorithm>
+#include <graphics/mesh.h>
+#include <graphics/primitive.h>
+#include <graphics/renderer_3d.h>
+#include <maths/matrix44.h>
+
+// Order commands by their sort keys
+static bool CompareSortKeys(const RenderCommand& a, const RenderCommand& b)
+{
+
+	return a.sort_key < b.sort_key;
+
+}
+
+RenderQueue::RenderQueue() :
+	num_batches_(0)
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+
+
+
+}
+
+void RenderQueue::Clear()
+{
+
+	commands_.clear();
+	materials_.clear();
+	meshes_.clear();
+
+}
+
+void RenderQueue::AddCommand(const gef::Mesh* mesh, const gef::Matrix44* transform)
+{
+
+	if (!mesh)
+	{
+
+		return;
+
+	}
+
+	RenderCommand command;
+	command.mesh = mesh;
+	command.transform = transform;
+
+	// Our meshes use a single material, so key on the material of the first primitive
+	command.material = NULL;
+	if (mesh->num_primitives() > 0)
+	{
+
+		command.material = mesh->GetPrimitive(0)->material();
+
+	}
+
+	command.sort_key = (GetMaterialIndex(command.material) << 16) | GetMeshIndex(command.mesh);
+
+	commands_.push_back(command);
+
+}
+
+void RenderQueue::Sort()
+{
+
+	// Stable sort so draws with equal keys keep the order they were added in
+	std::stable_sort(commands_.begin(), commands_.end(), CompareSortKeys);
+
+}
+
+void RenderQueue::Submit(gef::Renderer3D* renderer_3d_)
+{
+
+	num_batches_ = 0;
+
+	const gef::Mesh* current_mesh = NULL;
+
+	for (std::vector<RenderCommand>::iterator it = commands_.begin(); it != commands_.end(); ++it)
+	{
+
+		// Only swap the mesh when it changes, consecutive draws of the same mesh form one batch
+		if (it->mesh != current_mesh)
+		{
+
+			current_mesh = it->mesh;
+			instance_.set_mesh(current_mesh);
+			num_batches_++;
+
+		}
+
+		instance_.set_transform(*it->transform);
+		renderer_3d_->DrawMesh(instance_);
+
+	}
+
+}
+
+gef::UInt32 RenderQueue::GetMaterialIndex(const gef::Material* material)
+{
+
+	for (gef::UInt32 index = 0; index < materials_.size(); index++)
+	{
+
+		if (materials_[index] == material)
+		{
+
+			return index;
+
+		}
+
+	}
+
+	materials_.push_back(material);
+	return (gef::UInt32)materials_.size() - 1;
+
+}
+
+gef::UInt32 RenderQueue::GetMeshIndex(const gef::Mesh* mesh)
+{
+
+	for (gef::UInt32 index = 0; index < meshes_.size(); index++)
+	{
+
+		if (meshes_[index] == mesh)
+		{
+
+			return index;
+
+		}
+
+	}
+
+	meshes_.push_back(mesh);
+	return (gef::UInt32)meshes_.size() - 1;
+
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+#include <gef.h>
+#include <graphics/mesh_instance.h>
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Mesh;
+	class Material;
+	class Matrix44;
+	class Renderer3D;
+
+}
+
+// A single draw, as emitted by the level each frame
+struct RenderCommand
+{
+
+	const gef::Mesh* mesh;
+	const gef::Material* material;
+	const gef::Matrix44* transform;
+	// Material index in the upper bits, mesh index in the lower bits
+	gef::UInt32 sort_key;
+
+};
+
+// Render queue class
+// Collects the draws for a frame, sorts them so draws sharing a material and mesh are adjacent, then submits them
+class RenderQueue
+{
+
+public:
+
+	RenderQueue();
+	~RenderQueue();
+
+	// Empty the queue at the start of a frame
+	void Clear();
+	// Make room for a number of draws, so the commands aren't grown part way through a frame
+	inline void Reserve(int num_commands) { commands_.reserve(num_commands); };
+	// Add a draw of a mesh with the given transform, which has to stay where it is until the queue is submitted
+	void AddCommand(const gef::Mesh* mesh, const gef::Matrix44* transform);
+	// Sort the commands by material then mesh
+	void Sort();
+	// Draw all of the commands in their current order
+	void Submit(gef::Renderer3D* renderer_3d_);
+
+	// Getters
+	inline int GetNumCommands() { return (int)commands_.size(); };
+	inline int GetNumBatches() { return num_batches_; };
+
+private:
+
+	// Find the index of a material or mesh seen this frame, adding it if it's new
+	gef::UInt32 GetMaterialIndex(const gef::Material* material);
+	gef::UInt32 GetMeshIndex(const gef::Mesh* mesh);
+
+	std::vector<RenderCommand> commands_;
+
+	// Unique materials and meshes seen this frame, used to build compact sort keys
+	std::vector<const gef::Material*> materials_;
+	std::vector<const gef::Mesh*> meshes_;
+
+	// Mesh instance reused for every draw so consecutive draws of one mesh only swap the transform
+	gef::MeshInstance instance_;
+
+	// Number of runs of consecutive draws that share a mesh in the last submit
+	int num_batches_;
+
+};
+
+#endif // !RENDER_QUEUE_H
\ No newline at end of file
@@ -0,0 +1,490 @@
+#include "shape_symmetry.h"
+#include <map>
+#include <algorithm>
+#include <math.h>
+#include <maths/math_utils.h>
+#include <maths/quaternion.h>
+#include <graphics/mesh.h>
+#include <graphics/mesh_data.h>
+#include "pose_maths.h"
+
+// Vertices have to land within this fraction of the mesh's size of another vertex for a rotation to count as a symmetry
+static const float symmetry_tolerance = 0.01f;
+
+// Largest number of vertices tested, larger meshes are sampled evenly
+static const int max_tested_vertices = 512;
+
+// Fewest distinct vertices every ring of a shape needs for it to count as continuously symmetric
+// Faceted surfaces of revolution are never within the vertex tolerance of themselves when rotated by an arbitrary angle,
+// so they're recognised by their rings instead, and anything coarser than the highest discrete order is left to those
+static const int min_ring_segments = MAX_SYMMETRY_ORDER + 1;
+// How much wider than an even spacing the largest gap between a ring's vertices can be
+static const float max_ring_gap_ratio = 1.5f;
+// Vertices closer together round a ring than this many radians are copies of the same vertex
+static const float ring_duplicate_angle = 1.0e-4f;
+
+// Grid of vertex positions for finding nearby vertices quickly
+class VertexGrid
+{
+
+public:
+
+	VertexGrid(const gef::Mesh::Vertex* vertices, int num_vertices, float cell_size) :
+		vertices_(vertices),
+		cell_size_(cell_size)
+	{
+
+		for (int vertex = 0; vertex < num_vertices; vertex++)
+		{
+
+			cells_.insert(std::make_pair(GetKey(GetCell(vertices[vertex].px), GetCell(vertices[vertex].py), GetCell(vertices[vertex].pz)), vertex));
+
+		}
+
+	}
+
+	// Check if there's a vertex within the cell size of a position
+	bool HasVertexNear(float x, float y, float z) const
+	{
+
+		int cell_x = GetCell(x);
+		int cell_y = GetCell(y);
+		int cell_z = GetCell(z);
+		float max_distance_squared = cell_size_ * cell_size_;
+
+		for (int offset_z = -1; offset_z <= 1; offset_z++)
+		{
+
+			for (int offset_y = -1; offset_y <= 1; offset_y++)
+			{
+
+				for (int offset_x = -1; offset_x <= 1; offset_x++)
+				{
+
+					std::pair<CellMap::const_iterator, CellMap::const_iterator> range = cells_.equal_range(GetKey(cell_x + offset_x, cell_y + offset_y, cell_z + offset_z));
+
+					for (CellMap::const_iterator it = range.first; it != range.second; ++it)
+					{
+
+						const gef::Mesh::Vertex& vertex = vertices_[it->second];
+						float dx = vertex.px - x;
+						float dy = vertex.py - y;
+						float dz = vertex.pz - z;
+
+						if (dx * dx + dy * dy + dz * dz <= max_distance_squared)
+						{
+
+							return true;
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+private:
+
+	typedef std::multimap<long long, int> CellMap;
+
+	int GetCell(float position) const
+	{
+
+		return (int)floorf(position / cell_size_);
+
+	}
+
+	static long long GetKey(int x, int y, int z)
+	{
+
+		return ((long long)(x & 0x1fffff) << 42) | ((long long)(y & 0x1fffff) << 21) | (long long)(z & 0x1fffff);
+
+	}
+
+	const gef::Mesh::Vertex* vertices_;
+	float cell_size_;
+	CellMap cells_;
+
+};
+
+// Check if rotating a mesh's vertices by an angle about an axis through its centre maps them onto its vertices
+static bool IsSymmetricUnder(const gef::Mesh::Vertex* vertices, int num_vertices, const VertexGrid& grid, const gef::Vector4& centre, int axis, float angle)
+{
+
+	float c = cosf(angle);
+	float s = sinf(angle);
+	int stride = num_vertices > max_tested_vertices ? num_vertices / max_tested_vertices : 1;
+
+	for (int vertex = 0; vertex < num_vertices; vertex += stride)
+	{
+
+		float position[3] = { vertices[vertex].px - centre.x(), vertices[vertex].py - centre.y(), vertices[vertex].pz - centre.z() };
+
+		// Rotate within the plane at right angles to the axis
+		int u = (axis + 1) % 3;
+		int v = (axis + 2) % 3;
+		float rotated_u = position[u] * c - position[v] * s;
+		float rotated_v = position[u] * s + position[v] * c;
+		position[u] = rotated_u;
+		position[v] = rotated_v;
+
+		if (!grid.HasVertexNear(position[0] + centre.x(), position[1] + centre.y(), position[2] + centre.z()))
+		{
+
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+// A vertex's position about a candidate symmetry axis
+struct RingVertex
+{
+
+	float height;
+	float radius;
+	float angle;
+
+};
+
+static bool CompareHeight(const RingVertex& a, const RingVertex& b)
+{
+
+	return a.height < b.height;
+
+}
+
+static bool CompareRadius(const RingVertex& a, const RingVertex& b)
+{
+
+	return a.radius < b.radius;
+
+}
+
+static bool CompareAngle(const RingVertex& a, const RingVertex& b)
+{
+
+	return a.angle < b.angle;
+
+}
+
+// Check if a ring's vertices are spread evenly all the way round it, with enough of them to stand for a circle
+static bool IsEvenRing(std::vector<RingVertex>::iterator first, std::vector<RingVertex>::iterator last)
+{
+
+	std::sort(first, last, CompareAngle);
+
+	// Vertices shared by several faces appear more than once, so count the distinct angles and the widest gap between them
+	const float min_angle = ring_duplicate_angle;
+	int num_segments = 1;
+	float previous_angle = first->angle;
+	float largest_gap = 0.0f;
+
+	for (std::vector<RingVertex>::iterator it = first + 1; it != last; ++it)
+	{
+
+		float gap = it->angle - previous_angle;
+		if (gap > min_angle)
+		{
+
+			num_segments++;
+			largest_gap = gap > largest_gap ? gap : largest_gap;
+			previous_angle = it->angle;
+
+		}
+
+	}
+
+	// Including the gap back round to the first vertex
+	float wrap_gap = first->angle + 2.0f * FRAMEWORK_PI - previous_angle;
+	if (wrap_gap <= min_angle && num_segments > 1)
+	{
+
+		num_segments--;
+
+	}
+	largest_gap = wrap_gap > largest_gap ? wrap_gap : largest_gap;
+
+	return num_segments >= min_ring_segments && largest_gap <= max_ring_gap_ratio * 2.0f * FRAMEWORK_PI / num_segments;
+
+}
+
+// Check if a mesh is a surface of revolution about an axis through its centre, however finely it's faceted
+// Its vertices are grouped into rings of the same height along the axis and distance from it, and every ring that
+// isn't on the axis has to go evenly all the way round
+static bool IsAxiallySymmetric(const gef::Mesh::Vertex* vertices, int num_vertices, const gef::Vector4& centre, int axis, float tolerance)
+{
+
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+
+	std::vector<RingVertex> ring_vertices(num_vertices);
+	for (int vertex = 0; vertex < num_vertices; vertex++)
+	{
+
+		float position[3] = { vertices[vertex].px - centre.x(), vertices[vertex].py - centre.y(), vertices[vertex].pz - centre.z() };
+		ring_vertices[vertex].height = position[axis];
+		ring_vertices[vertex].radius = sqrtf(position[u] * position[u] + position[v] * position[v]);
+		ring_vertices[vertex].angle = atan2f(position[v], position[u]);
+
+	}
+
+	// Each group spans no more than the tolerance from its first vertex, so a cloud of vertices can't be chained together
+	// into one ring, while the vertices of a real ring share their height and radius almost exactly
+	std::sort(ring_vertices.begin(), ring_vertices.end(), CompareHeight);
+
+	std::vector<RingVertex>::iterator layer_first = ring_vertices.begin();
+	while (layer_first != ring_vertices.end())
+	{
+
+		std::vector<RingVertex>::iterator layer_last = layer_first + 1;
+		while (layer_last != ring_vertices.end() && layer_last->height - layer_first->height <= tolerance)
+		{
+
+			++layer_last;
+
+		}
+
+		std::sort(layer_first, layer_last, CompareRadius);
+
+		std::vector<RingVertex>::iterator ring_first = layer_first;
+		while (ring_first != layer_last)
+		{
+
+			std::vector<RingVertex>::iterator ring_last = ring_first + 1;
+			while (ring_last != layer_last && ring_last->radius - ring_first->radius <= tolerance)
+			{
+
+				++ring_last;
+
+			}
+
+			// Vertices on the axis are unchanged by any rotation about it
+			if ((ring_last - 1)->radius > tolerance && !IsEvenRing(ring_first, ring_last))
+			{
+
+				return false;
+
+			}
+
+			ring_first = ring_last;
+
+		}
+
+		layer_first = layer_last;
+
+	}
+
+	return true;
+
+}
+
+ShapeSymmetry::ShapeSymmetry() :
+	axis_(-1),
+	order_(1),
+	centre_(0.0f, 0.0f, 0.0f)
+{
+}
+
+ShapeSymmetry::~ShapeSymmetry()
+{
+
+
+
+}
+
+void ShapeSymmetry::Compute(const gef::MeshData& mesh_data)
+{
+
+	axis_ = -1;
+	order_ = 1;
+	table_.clear();
+
+	if (mesh_data.vertex_data.vertex_byte_size != sizeof(gef::Mesh::Vertex) || mesh_data.vertex_data.num_vertices == 0)
+	{
+
+		return;
+
+	}
+
+	const gef::Mesh::Vertex* vertices = (const gef::Mesh::Vertex*)mesh_data.vertex_data.vertices;
+	int num_vertices = mesh_data.vertex_data.num_vertices;
+
+	gef::Vector4 centre = GetCentre(mesh_data);
+	float size = (mesh_data.aabb.max_vtx() - mesh_data.aabb.min_vtx()).Length();
+
+	VertexGrid grid(vertices, num_vertices, size * symmetry_tolerance);
+
+	int best_axis = -1;
+	int best_order = 1;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+
+		// Continuous symmetry beats any discrete group
+		if (IsAxiallySymmetric(vertices, num_vertices, centre, axis, size * symmetry_tolerance))
+		{
+
+			best_axis = axis;
+			best_order = SYMMETRY_CONTINUOUS;
+			break;
+
+		}
+
+		// Otherwise find the highest order group about this axis
+		for (int order = MAX_SYMMETRY_ORDER; order > best_order; order--)
+		{
+
+			if (IsSymmetricUnder(vertices, num_vertices, grid, centre, axis, 2.0f * FRAMEWORK_PI / order))
+			{
+
+				best_axis = axis;
+				best_order = order;
+				break;
+
+			}
+
+		}
+
+	}
+
+	if (best_axis >= 0)
+	{
+
+		Set(best_axis, best_order, centre);
+
+	}
+
+}
+
+void ShapeSymmetry::Set(int axis, int order, const gef::Vector4& centre)
+{
+
+	axis_ = axis;
+	order_ = order;
+	centre_ = centre;
+
+	BuildTable();
+
+}
+
+gef::Vector4 ShapeSymmetry::GetCentre(const gef::MeshData& mesh_data)
+{
+
+	gef::Vector4 min = mesh_data.aabb.min_vtx();
+	gef::Vector4 max = mesh_data.aabb.max_vtx();
+
+	return gef::Vector4((min.x() + max.x()) * 0.5f, (min.y() + max.y()) * 0.5f, (min.z() + max.z()) * 0.5f);
+
+}
+
+void ShapeSymmetry::BuildTable()
+{
+
+	table_.clear();
+
+	if (axis_ < 0 || order_ == SYMMETRY_CONTINUOUS)
+	{
+
+		return;
+
+	}
+
+	for (int step = 0; step < order_; step++)
+	{
+
+		table_.push_back(MakeRotation(2.0f * FRAMEWORK_PI * step / order_));
+
+	}
+
+}
+
+gef::Matrix44 ShapeSymmetry::MakeRotation(float angle) const
+{
+
+	float axis_values[3] = { 0.0f, 0.0f, 0.0f };
+	axis_values[axis_] = sinf(angle * 0.5f);
+
+	gef::Quaternion rotation;
+	rotation.x = axis_values[0];
+	rotation.y = axis_values[1];
+	rotation.z = axis_values[2];
+	rotation.w = cosf(angle * 0.5f);
+
+	// Rotate about the axis through the mesh's centre rather than its origin
+	gef::Matrix44 to_centre;
+	gef::Matrix44 from_centre;
+	gef::Matrix44 axis_rotation;
+	to_centre.SetIdentity();
+	to_centre.SetTranslation(gef::Vector4(-centre_.x(), -centre_.y(), -centre_.z()));
+	from_centre.SetIdentity();
+	from_centre.SetTranslation(centre_);
+	PoseMaths::Compose(gef::Vector4(0.0f, 0.0f, 0.0f), rotation, 1.0f, axis_rotation);
+
+	return to_centre * axis_rotation * from_centre;
+
+}
+
+gef::Matrix44 ShapeSymmetry::Canonicalise(const gef::Matrix44& transform, const gef::Matrix44& reference) const
+{
+
+	if (axis_ < 0)
+	{
+
+		return transform;
+
+	}
+
+	// Find the rotation that takes the object's orientation to the reference orientation
+	gef::Vector4 translation;
+	gef::Quaternion transform_rotation;
+	gef::Quaternion reference_rotation;
+	float scale;
+	PoseMaths::Decompose(transform, translation, transform_rotation, scale);
+	PoseMaths::Decompose(reference, translation, reference_rotation, scale);
+
+	gef::Matrix44 transform_matrix;
+	gef::Matrix44 reference_matrix;
+	gef::Matrix44 inverse_transform_matrix;
+	PoseMaths::Compose(gef::Vector4(0.0f, 0.0f, 0.0f), transform_rotation, 1.0f, transform_matrix);
+	PoseMaths::Compose(gef::Vector4(0.0f, 0.0f, 0.0f), reference_rotation, 1.0f, reference_matrix);
+	inverse_transform_matrix.Transpose(transform_matrix);
+
+	gef::Quaternion difference;
+	PoseMaths::Decompose(reference_matrix * inverse_transform_matrix, translation, difference, scale);
+
+	// The twist of that rotation about the symmetry axis is the part the symmetry can absorb
+	float axis_component = axis_ == 0 ? difference.x : (axis_ == 1 ? difference.y : difference.z);
+	float twist = 2.0f * atan2f(axis_component, difference.w);
+
+	if (order_ == SYMMETRY_CONTINUOUS)
+	{
+
+		return MakeRotation(twist) * transform;
+
+	}
+
+	// Snap the twist to the nearest element of the group and look up its transform
+	float step = 2.0f * FRAMEWORK_PI / order_;
+	int element = (int)floorf(twist / step + 0.5f) % order_;
+	if (element < 0)
+	{
+
+		element += order_;
+
+	}
+
+	return table_[element] * transform;
+
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef SHAPE_SYMMETRY_H
+#define SHAPE_SYMMETRY_H
+
+#include <vector>
+#include <maths/vector4.h>
+#include <maths/matrix44.h>
+
+// GEF forward declarations
+namespace gef
+{
+
+	class MeshData;
+
+}
+
+// Order of a shape that's symmetric under any rotation about its axis, such as a cylinder
+#define SYMMETRY_CONTINUOUS 0
+
+// Highest order of discrete rotational symmetry that's looked for
+#define MAX_SYMMETRY_ORDER 12
+
+// Shape symmetry class
+// The rotational symmetry group of a shape about one of its local axes
+// Poses that differ only by a rotation in the group look identical, so the matcher shouldn't tell them apart
+class ShapeSymmetry
+{
+
+public:
+
+	ShapeSymmetry();
+	~ShapeSymmetry();
+
+	// Work out the symmetry of a mesh by checking which rotations about its local axes map its vertices onto themselves
+	void Compute(const gef::MeshData& mesh_data);
+	// Set the symmetry directly, the centre being the point the axis passes through in mesh space
+	void Set(int axis, int order, const gef::Vector4& centre);
+
+	// Rotate an object transform by the element of the group that brings it closest to the reference transform
+	gef::Matrix44 Canonicalise(const gef::Matrix44& transform, const gef::Matrix44& reference) const;
+
+	// Axis is 0, 1 or 2 for x, y or z, or -1 if the shape isn't symmetric
+	inline int GetAxis() const { return axis_; };
+	inline int GetOrder() const { return order_; };
+	inline bool IsSymmetric() const { return axis_ >= 0; };
+
+	// Get the centre of a mesh's bounding box, which symmetry axes pass through
+	static gef::Vector4 GetCentre(const gef::MeshData& mesh_data);
+
+private:
+
+	// Precompute the transforms for each element of a discrete group
+	void BuildTable();
+	// Make the transform that rotates by an angle about the symmetry axis
+	gef::Matrix44 MakeRotation(float angle) const;
+
+	int axis_;
+	int order_;
+	gef::Vector4 centre_;
+
+	// Transforms for each element of a discrete group, indexed by how many steps of the group they rotate by
+	std::vector<gef::Matrix44> table_;
+
+};
+
+#endif // !SHAPE_SYMMETRY_H
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "stress_benchmark.h"
+#include <stdio.h>
+#include <math.h>
+#include <kernel.h>
+#include "level.h"
+#include "profiler.h"
+#include "game_object_pool.h"
+#include "compact_pose.h"
+
+// Object counts the benchmark steps through, stopping at the first the game object pool can't hold
+static const int stress_object_counts[] = { 2, 16, 128, 1024, 10000 };
+static const int num_stress_object_counts = sizeof(stress_object_counts) / sizeof(stress_object_counts[0]);
+
+StressBenchmark::StressBenchmark() :
+	step_(0),
+	frame_(0),
+	is_running_(false),
+	needs_level_(false)
+{
+}
+
+StressBenchmark::~StressBenchmark()
+{
+
+
+
+}
+
+void StressBenchmark::Start(const StressSettings& settings)
+{
+
+	settings_ = settings;
+	results_.clear();
+
+	step_ = 0;
+	frame_ = 0;
+	is_running_ = GetStepSettings(step_, step_settings_);
+	needs_level_ = is_running_;
+
+}
+
+void StressBenchmark::Stop()
+{
+
+	is_running_ = false;
+	needs_level_ = false;
+	trace_.clear();
+
+}
+
+void StressBenchmark::BuildLevel(Level* level, gef::Platform* platform_)
+{
+
+	LevelDefinition definition;
+	StressGenerator::GenerateLevel(step_settings_, definition);
+	LoadTrace();
+
+	// The objects all share one generated scene, which the level takes ownership of
+	level->ResetLevel();
+	level->AddScene(StressGenerator::GetSceneName(step_settings_), StressGenerator::GenerateScene(step_settings_));
+	level->InitLevel(definition, platform_);
+
+	StepResult result;
+	result.num_objects = level->GetNumObjects();
+	result.num_markers = step_settings_.num_markers;
+	result.replay_time = 0.0f;
+	result.simulation_time = 0.0f;
+	result.render_time = 0.0f;
+	result.scaling_exponent = 0.0f;
+	results_.push_back(result);
+
+	frame_ = 0;
+	needs_level_ = false;
+
+}
+
+const gef::Matrix44* StressBenchmark::GetMarkerTransforms()
+{
+
+	// Loop the trace if the benchmark runs for longer than it
+	int num_frames = (int)trace_.size() / step_settings_.num_markers;
+	return &trace_[(frame_ % num_frames) * step_settings_.num_markers];
+
+}
+
+void StressBenchmark::LoadTrace()
+{
+
+	char file_name[64];
+	sprintf(file_name, STRESS_BENCHMARK_TRACE_FILE, step_settings_.num_markers);
+
+	// Any trace of whole frames will do, whatever its length
+	size_t num_markers = step_settings_.num_markers;
+	if (PoseCodec::ReadPoseFile(file_name, trace_) && trace_.size() >= num_markers && trace_.size() % num_markers == 0)
+	{
+
+		return;
+
+	}
+
+	StressGenerator::GenerateTrace(step_settings_, trace_);
+
+	// Replay what was written rather than what was generated, so every run sees the same quantised poses
+	sceIoMkdir(LEVEL_DEFINITION_PATH, 0777);
+	std::vector<gef::Matrix44> generated_trace = trace_;
+	if (!PoseCodec::WritePoseFile(file_name, &generated_trace[0], (int)generated_trace.size()) || !PoseCodec::ReadPoseFile(file_name, trace_)
+		|| trace_.size() != generated_trace.size())
+	{
+
+		trace_.swap(generated_trace);
+
+	}
+
+}
+
+bool StressBenchmark::EndFrame(Profiler* profiler_)
+{
+
+	if (!is_running_ || needs_level_)
+	{
+
+		return is_running_;
+
+	}
+
+	StepResult& result = results_.back();
+
+	// The first frames after building a level pay for things being touched for the first time
+	if (frame_ >= STRESS_BENCHMARK_WARMUP_FRAMES)
+	{
+
+		result.replay_time += profiler_->GetTimer(PROFILER_TIMER_TRACKING);
+		result.simulation_time += profiler_->GetTimer(PROFILER_TIMER_SIMULATION);
+		result.render_time += profiler_->GetTimer(PROFILER_TIMER_RENDER);
+
+	}
+
+	if (++frame_ < STRESS_BENCHMARK_WARMUP_FRAMES + STRESS_BENCHMARK_FRAMES)
+	{
+
+		return true;
+
+	}
+
+	result.replay_time /= STRESS_BENCHMARK_FRAMES;
+	result.simulation_time /= STRESS_BENCHMARK_FRAMES;
+	result.render_time /= STRESS_BENCHMARK_FRAMES;
+
+	// Linear scaling keeps the cost per object the same, so the cost grows with the object count to the power 1
+	if (results_.size() > 1)
+	{
+
+		const StepResult& previous = results_[results_.size() - 2];
+		float previous_time = previous.replay_time + previous.simulation_time + previous.render_time;
+		float time = result.replay_time + result.simulation_time + result.render_time;
+
+		if (previous_time > STRESS_MIN_SCALING_TIME && time > STRESS_MIN_SCALING_TIME && result.num_objects > previous.num_objects)
+		{
+
+			result.scaling_exponent = logf(time / previous_time) / logf((float)result.num_objects / previous.num_objects);
+
+		}
+
+	}
+
+	// Move on to the next object count, or finish if the pool can't hold it
+	step_++;
+	if (!GetStepSettings(step_, step_settings_))
+	{
+
+		is_running_ = false;
+		return false;
+
+	}
+
+	needs_level_ = true;
+
+	return true;
+
+}
+
+bool StressBenchmark::WriteResults(const char* file_name)
+{
+
+	FILE* file = fopen(file_name, "w");
+	if (!file)
+	{
+
+		return false;
+
+	}
+
+	fprintf(file, "# Shape Matcher stress benchmark, %i frames per step, mesh complexity %i\n", STRESS_BENCHMARK_FRAMES, settings_.mesh_complexity);
+	fprintf(file, "# Milliseconds per frame, and the exponent the total grew with from the previous step\n");
+	fprintf(file, "# step objects markers replay simulation render total exponent\n");
+
+	for (std::vector<StepResult>::const_iterator it = results_.begin(); it != results_.end(); ++it)
+	{
+
+		fprintf(file, "step %i %i %f %f %f %f %f\n", it->num_objects, it->num_markers, it->replay_time, it->simulation_time,
+			it->render_time, it->replay_time + it->simulation_time + it->render_time, it->scaling_exponent);
+
+	}
+
+	fprintf(file, "superlinear %i\n", IsSuperLinear() ? 1 : 0);
+
+	fclose(file);
+
+	return true;
+
+}
+
+bool StressBenchmark::IsSuperLinear()
+{
+
+	for (std::vector<StepResult>::const_iterator it = results_.begin(); it != results_.end(); ++it)
+	{
+
+		if (it->scaling_exponent > STRESS_MAX_SCALING_EXPONENT)
+		{
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+}
+
+bool StressBenchmark::GetStepSettings(int step, StressSettings& step_settings)
+{
+
+	if (step >= num_stress_object_counts)
+	{
+
+		return false;
+
+	}
+
+	// Use as many of the markers as there are objects to go on them
+	int num_objects = stress_object_counts[step];
+	step_settings = settings_;
+	step_settings.num_markers = num_objects < settings_.num_markers ? num_objects : settings_.num_markers;
+	step_settings.objects_per_marker = num_objects / step_settings.num_markers;
+
+	return step_settings.num_markers * step_settings.objects_per_marker <= MAX_GAME_OBJECTS;
+
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef STRESS_BENCHMARK_H
+#define STRESS_BENCHMARK_H
+
+#include <vector>
+#include <gef.h>
+#include <maths/matrix44.h>
+#include "stress_generator.h"
+
+// File the benchmark's results are written to
+#define STRESS_BENCHMARK_RESULTS_FILE LEVEL_DEFINITION_PATH "stress_results.txt"
+
+// Files the pose traces are kept in as compact poses, one for each number of markers
+// A trace is generated and written the first time it's needed, and can be swapped for a recorded one to replay that instead
+#define STRESS_BENCHMARK_TRACE_FILE LEVEL_DEFINITION_PATH "stress_trace_%i.pose"
+
+// Frames replayed for each object count, after the frames that are left out while things settle
+#define STRESS_BENCHMARK_FRAMES 120
+#define STRESS_BENCHMARK_WARMUP_FRAMES 10
+
+// Largest exponent the per-frame cost can grow with the object count before it's reported as super-linear
+#define STRESS_MAX_SCALING_EXPONENT 1.25f
+// Frames cheaper than this many milliseconds are too close to the timer's resolution to judge the scaling from
+#define STRESS_MIN_SCALING_TIME 0.05f
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Platform;
+
+}
+
+// Other forward declarations
+class Level;
+class Profiler;
+
+// Stress benchmark class
+// Replays a generated pose trace through generated levels of increasing size, from 2 objects up to as many as the
+// game object pool holds, recording the per-frame cost of each part of the frame at each size
+// Each size runs for a fixed number of frames, and the level for the next size is built between frames by the app
+class StressBenchmark
+{
+
+public:
+
+	StressBenchmark();
+	~StressBenchmark();
+
+	// Start from the smallest object count, spreading each count's objects over the settings' markers
+	// The settings' objects per marker are replaced by what each count needs
+	void Start(const StressSettings& settings);
+	void Stop();
+	inline bool IsRunning() { return is_running_; };
+
+	// Whether the level for the current object count needs building
+	inline bool NeedsLevel() { return is_running_ && needs_level_; };
+	// Build the level and pose trace for the current object count
+	void BuildLevel(Level* level, gef::Platform* platform_);
+
+	// Get the marker transforms to replay this frame
+	const gef::Matrix44* GetMarkerTransforms();
+	inline int GetNumMarkers() { return step_settings_.num_markers; };
+
+	// Record the frame's timings once it's been presented, moving on to the next object count when this one's done
+	// Returns false once every object count has been run
+	bool EndFrame(Profiler* profiler_);
+
+	// Write the results out, one line per object count, returning false if the file can't be written
+	bool WriteResults(const char* file_name);
+	// Whether the cost grew faster than STRESS_MAX_SCALING_EXPONENT allows between any two object counts
+	bool IsSuperLinear();
+
+	inline int GetStep() { return step_; };
+	inline int GetNumObjects() { return step_settings_.num_markers * step_settings_.objects_per_marker; };
+	inline int GetFrame() { return frame_; };
+
+private:
+
+	// Per-frame costs in milliseconds for one object count, averaged over its frames
+	struct StepResult
+	{
+
+		int num_objects;
+		int num_markers;
+		float replay_time;
+		float simulation_time;
+		float render_time;
+		// Exponent of the growth in total cost from the previous object count, or 0 for the first
+		float scaling_exponent;
+
+	};
+
+	// Work out the settings for a step, returning false if it has more objects than the pool holds
+	bool GetStepSettings(int step, StressSettings& step_settings);
+
+	// Read the pose trace for the current number of markers, generating and writing it first if there isn't one
+	void LoadTrace();
+
+	StressSettings settings_;
+	StressSettings step_settings_;
+	std::vector<gef::Matrix44> trace_;
+	std::vector<StepResult> results_;
+
+	int step_;
+	int frame_;
+	bool is_running_;
+	bool needs_level_;
+
+};
+
+#endif // !STRESS_BENCHMARK_H
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "stress_generator.h"
+#include <math.h>
+#include <stdio.h>
+#include <maths/math_utils.h>
+#include <graphics/scene.h>
+#include <graphics/mesh.h>
+#include <graphics/mesh_data.h>
+#include "mesh_simplifier.h"
+
+// Smallest standard deviation given to the generated bounds, so noise free traces still have a usable tolerance
+static const float min_bounds_sigma = 0.0001f;
+
+// Bounds are this many standard deviations of the noise wide, so the noisy poses match
+static const float bounds_noise_scale = 3.0f;
+
+// Step a xorshift generator and return a uniform value in (0, 1]
+static float RandomUniform(gef::UInt32& state)
+{
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return ((state >> 8) + 1) / 16777216.0f;
+
+}
+
+// Return a normally distributed value with zero mean and unit standard deviation
+static float RandomGaussian(gef::UInt32& state)
+{
+
+	float u = RandomUniform(state);
+	float v = RandomUniform(state);
+
+	return sqrtf(-2.0f * logf(u)) * cosf(2.0f * FRAMEWORK_PI * v);
+
+}
+
+// Get the number of cells along each side of the smallest square grid with at least count cells
+static int GetGridSize(int count)
+{
+
+	int size = 1;
+	while (size * size < count)
+	{
+
+		size++;
+
+	}
+
+	return size;
+
+}
+
+void StressGenerator::GenerateLevel(const StressSettings& settings, LevelDefinition& definition)
+{
+
+	definition.level_id = 0;
+	definition.tolerance = 0.05f;
+	definition.objects.clear();
+	definition.reference_transforms.clear();
+	definition.match_bounds.clear();
+	definition.solutions.clear();
+	definition.solution_translation_tolerance = 0.0f;
+	definition.solution_rotation_tolerance = 0.0f;
+
+	std::string scene_name = GetSceneName(settings);
+
+	// Objects sit in a grid on their marker, sized to fill their cell
+	int grid_size = GetGridSize(settings.objects_per_marker);
+	float cell_size = 2.0f / grid_size;
+	float object_scale = 0.4f * cell_size;
+
+	// Go round the markers in turn, so the first two objects are on the first two markers as in the real levels
+	int num_objects = settings.num_markers * settings.objects_per_marker;
+	for (int object = 0; object < num_objects; object++)
+	{
+
+		int marker = object % settings.num_markers;
+		int slot = object / settings.num_markers;
+
+		ObjectDefinition object_definition;
+		object_definition.scene_file = scene_name;
+		object_definition.lod_scene_file = scene_name;
+		object_definition.marker = marker;
+		object_definition.is_local = marker != 0;
+		object_definition.position[0] = ((slot % grid_size) + 0.5f) * cell_size - 1.0f;
+		object_definition.position[1] = ((slot / grid_size) + 0.5f) * cell_size - 1.0f;
+		object_definition.position[2] = 0.5f;
+		object_definition.rotation[0] = 0.0f;
+		object_definition.rotation[1] = 0.0f;
+		object_definition.rotation[2] = 0.0f;
+		object_definition.scale = object_scale;
+
+		// Spheres are symmetric about every axis, but they're matched as they are so the check costs the same as for
+		// any other shape, and giving the symmetry stops it being worked out from the mesh for every object
+		object_definition.symmetry_axis = -1;
+		object_definition.symmetry_order = 1;
+
+		definition.objects.push_back(object_definition);
+
+		// The reference is where the object is in camera space when the marker is where the trace centres it
+		gef::Matrix44 scale_matrix;
+		gef::Matrix44 translation_matrix;
+		scale_matrix.Scale(gef::Vector4(object_scale, object_scale, object_scale));
+		translation_matrix.SetIdentity();
+		translation_matrix.SetTranslation(gef::Vector4(object_definition.position[0], object_definition.position[1], object_definition.position[2]));
+
+		definition.reference_transforms.push_back(scale_matrix * translation_matrix * GetMarkerTransform(settings, marker));
+
+		// Rotation noise turns the object's axes, and swings its position about the marker by its distance from it
+		float lever = STRESS_MARKER_SCALE * sqrtf(object_definition.position[0] * object_definition.position[0]
+			+ object_definition.position[1] * object_definition.position[1] + object_definition.position[2] * object_definition.position[2]);
+		float axis_sigma = bounds_noise_scale * settings.rotation_noise * object_scale * STRESS_MARKER_SCALE + min_bounds_sigma;
+		float position_sigma = bounds_noise_scale * (settings.translation_noise + settings.rotation_noise * lever) + min_bounds_sigma;
+
+		MatchBounds bounds;
+		for (int element = 0; element < MATCH_ELEMENTS; element++)
+		{
+
+			bounds.sigma[element] = element < 9 ? axis_sigma : position_sigma;
+
+		}
+
+		definition.match_bounds.push_back(bounds);
+
+	}
+
+}
+
+gef::Scene* StressGenerator::GenerateScene(const StressSettings& settings)
+{
+
+	int num_rings = settings.mesh_complexity < 2 ? 2 : settings.mesh_complexity;
+	int num_segments = num_rings * 2;
+
+	gef::Scene* scene = new gef::Scene();
+	scene->mesh_data.push_back(gef::MeshData());
+	gef::MeshData& mesh_data = scene->mesh_data.back();
+
+	// A unit sphere, with a seam of duplicated vertices so the texture coordinates wrap
+	int num_vertices = (num_rings + 1) * (num_segments + 1);
+	gef::Mesh::Vertex* vertices = (gef::Mesh::Vertex*)new gef::UInt8[num_vertices * sizeof(gef::Mesh::Vertex)];
+
+	for (int ring = 0; ring <= num_rings; ring++)
+	{
+
+		float theta = FRAMEWORK_PI * ring / num_rings;
+
+		for (int segment = 0; segment <= num_segments; segment++)
+		{
+
+			float phi = 2.0f * FRAMEWORK_PI * segment / num_segments;
+
+			gef::Mesh::Vertex& vertex = vertices[ring * (num_segments + 1) + segment];
+			vertex.nx = sinf(theta) * cosf(phi);
+			vertex.ny = cosf(theta);
+			vertex.nz = sinf(theta) * sinf(phi);
+			vertex.px = vertex.nx;
+			vertex.py = vertex.ny;
+			vertex.pz = vertex.nz;
+			vertex.u = (float)segment / num_segments;
+			vertex.v = (float)ring / num_rings;
+
+		}
+
+	}
+
+	mesh_data.vertex_data.num_vertices = num_vertices;
+	mesh_data.vertex_data.vertex_byte_size = sizeof(gef::Mesh::Vertex);
+	mesh_data.vertex_data.vertices = vertices;
+
+	// Two triangles for each quad between neighbouring rings and segments
+	int index_byte_size = num_vertices > 0xffff ? 4 : 2;
+	int num_indices = num_rings * num_segments * 6;
+
+	gef::PrimitiveData* primitive = new gef::PrimitiveData();
+	primitive->type = gef::TRIANGLE_LIST;
+	primitive->material_name_id = 0;
+	primitive->num_indices = num_indices;
+	primitive->index_byte_size = index_byte_size;
+	primitive->indices = new gef::UInt8[num_indices * index_byte_size];
+
+	int index = 0;
+	for (int ring = 0; ring < num_rings; ring++)
+	{
+
+		for (int segment = 0; segment < num_segments; segment++)
+		{
+
+			gef::UInt32 a = ring * (num_segments + 1) + segment;
+			gef::UInt32 b = a + num_segments + 1;
+			gef::UInt32 quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+
+			for (int corner = 0; corner < 6; corner++, index++)
+			{
+
+				if (index_byte_size == 2)
+				{
+
+					((gef::UInt16*)primitive->indices)[index] = (gef::UInt16)quad[corner];
+
+				}
+				else
+				{
+
+					((gef::UInt32*)primitive->indices)[index] = quad[corner];
+
+				}
+
+			}
+
+		}
+
+	}
+
+	mesh_data.primitives.push_back(primitive);
+
+	mesh_data.aabb.set_min_vtx(gef::Vector4(-1.0f, -1.0f, -1.0f));
+	mesh_data.aabb.set_max_vtx(gef::Vector4(1.0f, 1.0f, 1.0f));
+	mesh_data.bounding_sphere.set_position(gef::Vector4(0.0f, 0.0f, 0.0f));
+	mesh_data.bounding_sphere.set_radius(1.0f);
+
+	// Coarser LODs are built the same way as for scenes without a baked LOD file
+	MeshSimplifier::AddLods(scene);
+
+	return scene;
+
+}
+
+std::string StressGenerator::GetSceneName(const StressSettings& settings)
+{
+
+	// The name can't clash with a real scene file, as those all end in .scn
+	char name[32];
+	sprintf(name, "stress_sphere_%i", settings.mesh_complexity);
+
+	return name;
+
+}
+
+void StressGenerator::GenerateTrace(const StressSettings& settings, std::vector<gef::Matrix44>& marker_transforms)
+{
+
+	marker_transforms.resize(settings.num_frames * settings.num_markers);
+
+	gef::UInt32 state = settings.seed ? settings.seed : 1;
+
+	for (int frame = 0; frame < settings.num_frames; frame++)
+	{
+
+		for (int marker = 0; marker < settings.num_markers; marker++)
+		{
+
+			gef::Matrix44 rotation_x;
+			gef::Matrix44 rotation_y;
+			gef::Matrix44 rotation_z;
+			rotation_x.RotationX(settings.rotation_noise * RandomGaussian(state));
+			rotation_y.RotationY(settings.rotation_noise * RandomGaussian(state));
+			rotation_z.RotationZ(settings.rotation_noise * RandomGaussian(state));
+
+			gef::Matrix44 translation;
+			translation.SetIdentity();
+			translation.SetTranslation(gef::Vector4(
+				settings.translation_noise * RandomGaussian(state),
+				settings.translation_noise * RandomGaussian(state),
+				settings.translation_noise * RandomGaussian(state)));
+
+			// Turn the marker about its own centre, then move it
+			gef::Matrix44 transform = GetMarkerTransform(settings, marker);
+			gef::Vector4 centre = transform.GetTranslation();
+			transform.SetTranslation(gef::Vector4(0.0f, 0.0f, 0.0f));
+			transform = transform * rotation_x * rotation_y * rotation_z;
+			transform.SetTranslation(centre);
+
+			marker_transforms[frame * settings.num_markers + marker] = transform * translation;
+
+		}
+
+	}
+
+}
+
+gef::Matrix44 StressGenerator::GetMarkerTransform(const StressSettings& settings, int marker)
+{
+
+	// The markers face the camera in a grid centred on its view
+	int grid_size = GetGridSize(settings.num_markers);
+	float offset = 0.5f * (grid_size - 1);
+
+	gef::Matrix44 transform;
+	transform.Scale(gef::Vector4(STRESS_MARKER_SCALE, STRESS_MARKER_SCALE, STRESS_MARKER_SCALE));
+	transform.SetTranslation(gef::Vector4(
+		((marker % grid_size) - offset) * STRESS_MARKER_SPACING,
+		((marker / grid_size) - offset) * STRESS_MARKER_SPACING,
+		-STRESS_MARKER_DISTANCE));
+
+	return transform;
+
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef STRESS_GENERATOR_H
+#define STRESS_GENERATOR_H
+
+#include <vector>
+#include <string>
+#include <gef.h>
+#include <maths/matrix44.h>
+#include "level_definition.h"
+
+// GEF forward declarations
+namespace gef
+{
+
+	class Scene;
+
+}
+
+// Distance between neighbouring markers in the generated layout, in metres
+#define STRESS_MARKER_SPACING 0.12f
+// Distance from the camera to the markers, in metres
+#define STRESS_MARKER_DISTANCE 0.6f
+// Scale of the marker transforms, matching what the tracking library reports for the real markers
+#define STRESS_MARKER_SCALE 0.06f
+
+// Settings for a generated stress level and its pose trace
+struct StressSettings
+{
+
+	int num_markers;
+	int objects_per_marker;
+	// Rings in each generated sphere mesh, which has twice as many segments, so about 4 * complexity^2 triangles
+	int mesh_complexity;
+	// Standard deviation of the noise added to the marker poses, in metres and radians
+	float translation_noise;
+	float rotation_noise;
+	// Number of frames in the pose trace
+	int num_frames;
+	// Seed for the noise, so the same settings always generate the same trace
+	gef::UInt32 seed;
+
+};
+
+// Stress generator class
+// Builds synthetic levels with any number of markers and objects, and traces of the markers' poses to replay through them
+// The objects are laid out in a grid on each marker, with reference transforms and bounds that the noisy poses match,
+// so a benchmark exercises every object in the update, the transform checks and the render
+// StressBenchmark keeps the traces in files of compact poses, written and read back with PoseCodec
+class StressGenerator
+{
+
+public:
+
+	// Fill in a level definition, the first marker being the origin that the others are localised against
+	static void GenerateLevel(const StressSettings& settings, LevelDefinition& definition);
+
+	// Build the sphere mesh the generated objects share, along with its LODs, without touching the GPU
+	static gef::Scene* GenerateScene(const StressSettings& settings);
+	// Get the name objects refer to the generated scene by
+	static std::string GetSceneName(const StressSettings& settings);
+
+	// Generate the markers' camera space transforms for each frame, frame by frame with num_markers transforms per frame
+	static void GenerateTrace(const StressSettings& settings, std::vector<gef::Matrix44>& marker_transforms);
+
+private:
+
+	// Get a marker's transform before any noise is added
+	static gef::Matrix44 GetMarkerTransform(const StressSettings& settings, int marker);
+
+};
+
+#endif // !STRESS_GENERATOR_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "task_pool.h"
+
+TaskPool::TaskPool() :
+	num_tasks_(0),
+	next_task_(0)
+{
+}
+
+TaskPool::~TaskPool()
+{
+
+
+
+}
+
+bool TaskPool::AddTask(ThreadFunction function, void* argument)
+{
+
+	if (num_tasks_ == TASK_POOL_MAX_TASKS)
+	{
+
+		return false;
+
+	}
+
+	tasks_[num_tasks_].function = function;
+	tasks_[num_tasks_].argument = argument;
+	num_tasks_++;
+
+	return true;
+
+}
+
+void TaskPool::Run()
+{
+
+	next_task_ = 0;
+
+	// No point starting more workers than there are tasks for them, and without a mutex they can't share the batch
+	int num_threads = num_tasks_ - 1 < TASK_POOL_NUM_THREADS ? num_tasks_ - 1 : TASK_POOL_NUM_THREADS;
+	if (!mutex_.IsValid())
+	{
+
+		num_threads = 0;
+
+	}
+
+	for (int thread = 0; thread < num_threads; thread++)
+	{
+
+		// If a worker can't be started, the others and this thread pick up its share
+		threads_[thread].Start("task_pool_worker", WorkerEntry, this, TASK_POOL_STACK_SIZE);
+
+	}
+
+	RunTasks();
+
+	for (int thread = 0; thread < num_threads; thread++)
+	{
+
+		threads_[thread].Join();
+
+	}
+
+	num_tasks_ = 0;
+
+}
+
+void TaskPool::WorkerEntry(void* argument)
+{
+
+	((TaskPool*)argument)->RunTasks();
+
+}
+
+void TaskPool::RunTasks()
+{
+
+	int task;
+	while ((task = TakeTask()) < num_tasks_)
+	{
+
+		tasks_[task].function(tasks_[task].argument);
+
+	}
+
+}
+
+int TaskPool::TakeTask()
+{
+
+	mutex_.Lock();
+	int task = next_task_++;
+	mutex_.Unlock();
+
+	return task;
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include "thread.h"
+
+// Most tasks that can be run together
+#define TASK_POOL_MAX_TASKS 16
+
+// Number of worker threads, the thread running the pool works through the tasks too
+#define TASK_POOL_NUM_THREADS 2
+
+// Stack given to each worker, which is enough for decoding images and reading scenes
+#define TASK_POOL_STACK_SIZE (256 * 1024)
+
+// Task pool class
+// Runs a batch of independent tasks across several threads and waits for them all to finish
+// Tasks mustn't touch the GPU, as resources have to be created on the main thread
+class TaskPool
+{
+
+public:
+
+	TaskPool();
+	~TaskPool();
+
+	// Add a task to the next batch, returning false if the batch is full
+	bool AddTask(ThreadFunction function, void* argument);
+	// Run the batch, returning once every task has finished
+	void Run();
+
+private:
+
+	static void WorkerEntry(void* argument);
+
+	// Keep taking tasks from the batch until there are none left
+	void RunTasks();
+	// Take the index of the next task, which is past the end of the batch once they've all been taken
+	int TakeTask();
+
+	struct Task
+	{
+
+		ThreadFunction function;
+		void* argument;
+
+	};
+
+	Task tasks_[TASK_POOL_MAX_TASKS];
+	int num_tasks_;
+	// Index of the next task to be taken, shared with the workers
+	Mutex mutex_;
+	int next_task_;
+
+	Thread threads_[TASK_POOL_NUM_THREADS];
+
+};
+
+#endif // !TASK_POOL_H
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "telemetry.h"
+#include <kernel.h>
+
+// How long the writer sleeps when the ring is empty, in microseconds
+static const SceUInt32 writer_sleep_time = 100000;
+
+// Largest encoded size of one record
+static const int max_encoded_record_size = 10 + 5 + 2 + 5;
+
+// Version written to each file's header
+static const gef::UInt32 telemetry_version = 1;
+
+// Append an unsigned value to a buffer, seven bits at a time with the top bit set on all but the last byte
+static int WriteVarint(gef::UInt8* buffer, gef::UInt64 value)
+{
+
+	int size = 0;
+
+	while (value >= 0x80)
+	{
+
+		buffer[size++] = (gef::UInt8)(value | 0x80);
+		value >>= 7;
+
+	}
+
+	buffer[size++] = (gef::UInt8)value;
+
+	return size;
+
+}
+
+Telemetry::Telemetry() :
+	head_(0),
+	tail_(0),
+	dropped_(0),
+	running_(false),
+	file_(NULL),
+	file_size_(0)
+{
+}
+
+Telemetry::~Telemetry()
+{
+
+	Stop();
+
+}
+
+bool Telemetry::Start()
+{
+
+	if (writer_thread_.IsRunning())
+	{
+
+		return false;
+
+	}
+
+	// Without a mutex the writer can't be told to stop, so records just stay in the ring until it fills up
+	if (!mutex_.IsValid())
+	{
+
+		return false;
+
+	}
+
+	sceIoMkdir(TELEMETRY_PATH, 0777);
+
+	// The writer isn't running yet, so there's no need to lock
+	running_ = true;
+	if (!writer_thread_.Start("telemetry_writer", WriterEntry, this))
+	{
+
+		running_ = false;
+		return false;
+
+	}
+
+	return true;
+
+}
+
+void Telemetry::Stop()
+{
+
+	mutex_.Lock();
+	running_ = false;
+	mutex_.Unlock();
+
+	writer_thread_.Join();
+
+}
+
+void Telemetry::WriterEntry(void* argument)
+{
+
+	((Telemetry*)argument)->RunWriter();
+
+}
+
+gef::UInt64 Telemetry::GetTime()
+{
+
+	return sceKernelGetProcessTimeWide();
+
+}
+
+void Telemetry::RunWriter()
+{
+
+	TelemetryRecord records[TELEMETRY_CHUNK_RECORDS];
+	gef::UInt32 reported_dropped = 0;
+	gef::UInt32 last_frame = 0;
+
+	RotateFiles();
+
+	while (true)
+	{
+
+		// Check for stopping before draining, so everything emitted before Stop is written
+		mutex_.Lock();
+		bool running = running_;
+		mutex_.Unlock();
+
+		int num_records = Drain(records, TELEMETRY_CHUNK_RECORDS);
+		if (num_records > 0)
+		{
+
+			last_frame = records[num_records - 1].frame;
+
+		}
+
+		// Note any records lost since last time, making room in the chunk if it's full
+		gef::UInt32 dropped = dropped_;
+		if (dropped != reported_dropped)
+		{
+
+			if (num_records == TELEMETRY_CHUNK_RECORDS)
+			{
+
+				WriteChunk(records, num_records);
+				num_records = 0;
+
+			}
+
+			TelemetryRecord& record = records[num_records++];
+			record.timestamp = GetTime();
+			record.frame = last_frame;
+			record.value = (gef::Int32)(dropped - reported_dropped);
+			record.type = TELEMETRY_EVENT_RECORDS_DROPPED;
+			record.level = 0;
+			reported_dropped = dropped;
+
+		}
+
+		if (num_records > 0)
+		{
+
+			WriteChunk(records, num_records);
+
+		}
+
+		if (!running && num_records == 0)
+		{
+
+			break;
+
+		}
+
+		// Wait for more records unless the ring still has a backlog
+		if (num_records < TELEMETRY_CHUNK_RECORDS)
+		{
+
+			if (file_)
+			{
+
+				fflush(file_);
+
+			}
+
+			if (running)
+			{
+
+				sceKernelDelayThread(writer_sleep_time);
+
+			}
+
+		}
+
+	}
+
+	if (file_)
+	{
+
+		fclose(file_);
+		file_ = NULL;
+
+	}
+
+}
+
+int Telemetry::Drain(TelemetryRecord* records, int max_records)
+{
+
+	gef::UInt32 tail = tail_;
+	gef::UInt32 available = head_ - tail;
+
+	// Don't read the records until the head that published them has been seen
+	MemoryBarrier();
+
+	int num_records = available < (gef::UInt32)max_records ? (int)available : max_records;
+
+	for (int record = 0; record < num_records; record++)
+	{
+
+		records[record] = ring_[(tail + record) & (TELEMETRY_RING_SIZE - 1)];
+
+	}
+
+	// Hand the slots back to the game thread once they've been read
+	MemoryBarrier();
+	tail_ = tail + num_records;
+
+	return num_records;
+
+}
+
+void Telemetry::WriteChunk(const TelemetryRecord* records, int num_records)
+{
+
+	gef::UInt8 buffer[TELEMETRY_CHUNK_RECORDS * max_encoded_record_size];
+	int size = 0;
+
+	// Timestamps and frames only ever go up, so store how much they've gone up by
+	gef::UInt64 previous_timestamp = records[0].timestamp;
+	gef::UInt32 previous_frame = records[0].frame;
+
+	for (int record = 0; record < num_records; record++)
+	{
+
+		const TelemetryRecord& current = records[record];
+
+		size += WriteVarint(buffer + size, current.timestamp - previous_timestamp);
+		size += WriteVarint(buffer + size, current.frame - previous_frame);
+		buffer[size++] = (gef::UInt8)current.type;
+		buffer[size++] = (gef::UInt8)current.level;
+		size += WriteVarint(buffer + size, ((gef::UInt32)current.value << 1) ^ (gef::UInt32)(current.value >> 31));
+
+		previous_timestamp = current.timestamp;
+		previous_frame = current.frame;
+
+	}
+
+	if (file_ && file_size_ >= TELEMETRY_FILE_SIZE)
+	{
+
+		RotateFiles();
+
+	}
+
+	if (!file_)
+	{
+
+		return;
+
+	}
+
+	gef::UInt32 header[2] = { (gef::UInt32)num_records, (gef::UInt32)size };
+	fwrite(header, sizeof(header), 1, file_);
+	fwrite(&records[0].timestamp, sizeof(records[0].timestamp), 1, file_);
+	fwrite(&records[0].frame, sizeof(records[0].frame), 1, file_);
+	fwrite(buffer, 1, size, file_);
+
+	file_size_ += sizeof(header) + sizeof(records[0].timestamp) + sizeof(records[0].frame) + size;
+
+}
+
+void Telemetry::RotateFiles()
+{
+
+	if (file_)
+	{
+
+		fclose(file_);
+		file_ = NULL;
+
+	}
+
+	// Shuffle the older files along, dropping the oldest, so telemetry_0 is always the newest
+	char file_name[128];
+	char older_file_name[128];
+	sprintf(file_name, "%stelemetry_%i.bin", TELEMETRY_PATH, TELEMETRY_NUM_FILES - 1);
+	remove(file_name);
+
+	for (int file = TELEMETRY_NUM_FILES - 1; file > 0; file--)
+	{
+
+		sprintf(older_file_name, "%stelemetry_%i.bin", TELEMETRY_PATH, file);
+		sprintf(file_name, "%stelemetry_%i.bin", TELEMETRY_PATH, file - 1);
+		rename(file_name, older_file_name);
+
+	}
+
+	file_ = fopen(file_name, "wb");
+	file_size_ = 0;
+
+	if (file_)
+	{
+
+		fwrite("SMTL", 1, 4, file_);
+		fwrite(&telemetry_version, sizeof(telemetry_version), 1, file_);
+		file_size_ = 4 + sizeof(telemetry_version);
+
+	}
+
+}
\ No newline at end of file
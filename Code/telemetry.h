@@ -0,0 +1,139 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdio.h>
+#include <gef.h>
+#include "thread.h"
+
+// Folder the telemetry files are written to
+#define TELEMETRY_PATH "ux0:data/shape_matcher/"
+
+// Number of records the ring can hold before new ones are dropped, must be a power of two
+#define TELEMETRY_RING_SIZE 1024
+
+// Most records the writer encodes into one chunk
+#define TELEMETRY_CHUNK_RECORDS 256
+
+// Size a telemetry file can grow to before the writer moves on to a new one, and how many files are kept
+#define TELEMETRY_FILE_SIZE (64 * 1024)
+#define TELEMETRY_NUM_FILES 4
+
+// Enumerated type for the events recorded during a session
+enum TelemetryEvent
+{
+
+	TELEMETRY_EVENT_SESSION_START,			// The game has started, value is unused
+	TELEMETRY_EVENT_MARKERS_FOUND,			// Both markers came into view, value is unused
+	TELEMETRY_EVENT_MARKERS_LOST,			// One or both markers went out of view, value has bit 0 set if marker 01 is still found and bit 1 if marker 02 is
+	TELEMETRY_EVENT_LEVEL_WON,				// The level was won, value is the milliseconds since it started
+	TELEMETRY_EVENT_DIFFICULTY_CHANGED,		// The difficulty was toggled, value is the new difficulty
+	TELEMETRY_EVENT_LEVEL_SWITCHED,			// A new level was started, value is unused
+	TELEMETRY_EVENT_LEVEL_RESET,			// The game was reset, value is unused
+	TELEMETRY_EVENT_RECORDS_DROPPED,		// Written by the writer when the ring overflowed, value is the number of records lost
+	NUM_TELEMETRY_EVENTS
+
+};
+
+// One event, as it's held in the ring
+struct TelemetryRecord
+{
+
+	gef::UInt64 timestamp;
+	gef::UInt32 frame;
+	gef::Int32 value;
+	gef::UInt16 type;
+	gef::UInt16 level;
+
+};
+
+// Telemetry class
+// Records session events for later analysis
+// The game thread writes fixed size records into a single producer, single consumer ring without locking
+// A background thread drains the ring, compresses the records and writes them to a set of rotating files
+// If the writer falls behind, new records are dropped rather than making the game wait
+//
+// Each file starts with the magic "SMTL" and a UInt32 version, followed by chunks of:
+//   UInt32 number of records, UInt32 size of the encoded records in bytes
+//   UInt64 timestamp and UInt32 frame of the first record
+//   the records, each a varint timestamp delta, varint frame delta, type byte, level byte and zigzag varint value
+class Telemetry
+{
+
+public:
+
+	Telemetry();
+	~Telemetry();
+
+	// Start the writer thread, returning false if it couldn't be started
+	bool Start();
+	// Stop the writer thread once it's written everything that's been recorded
+	void Stop();
+
+	// Record an event, returning false if the ring is full and the record was dropped
+	// This is only ever called from the game thread
+	inline bool Emit(TelemetryEvent type, gef::UInt32 frame, int level, int value)
+	{
+
+		// Read the clock before touching the ring, so the ring is only ever held for the copy
+		gef::UInt64 timestamp = GetTime();
+
+		gef::UInt32 head = head_;
+		if (head - tail_ == TELEMETRY_RING_SIZE)
+		{
+
+			dropped_ = dropped_ + 1;
+			return false;
+
+		}
+
+		// Don't write the slot until the writer's finished reading it
+		MemoryBarrier();
+
+		TelemetryRecord& record = ring_[head & (TELEMETRY_RING_SIZE - 1)];
+		record.timestamp = timestamp;
+		record.frame = frame;
+		record.value = value;
+		record.type = (gef::UInt16)type;
+		record.level = (gef::UInt16)level;
+
+		// Publish the record before the head that hands it to the writer
+		MemoryBarrier();
+		head_ = head + 1;
+
+		return true;
+
+	};
+
+private:
+
+	static void WriterEntry(void* argument);
+	static gef::UInt64 GetTime();
+
+	// Writer thread loop, which runs until stopped and the ring is empty
+	void RunWriter();
+	// Take up to a chunk's worth of records off the ring, returning how many were taken
+	int Drain(TelemetryRecord* records, int max_records);
+	// Encode and write a chunk of records, moving on to a new file if the current one is full
+	void WriteChunk(const TelemetryRecord* records, int num_records);
+	// Close the current file and open a new one, shuffling the older files along
+	void RotateFiles();
+
+	// The ring, with the producer owning head_ and dropped_ and the consumer owning tail_
+	TelemetryRecord ring_[TELEMETRY_RING_SIZE];
+	volatile gef::UInt32 head_;
+	volatile gef::UInt32 tail_;
+	volatile gef::UInt32 dropped_;
+
+	// Guards whether the writer should keep going, which only Start and Stop change
+	Mutex mutex_;
+	bool running_;
+
+	Thread writer_thread_;
+
+	// Only touched by the writer thread
+	FILE* file_;
+	gef::UInt32 file_size_;
+
+};
+
+#endif // !TELEMETRY_H
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "thread.h"
+#include <stddef.h>
+#include <kernel.h>
+
+// Kernel entry point, which is passed a pointer to the thread object
+static SceInt32 ThreadEntry(SceSize argument_size, void* argument_block)
+{
+
+	Thread* thread = *(Thread**)argument_block;
+	thread->Run();
+
+	return 0;
+
+}
+
+Thread::Thread() :
+	thread_id_(-1),
+	function_(NULL),
+	argument_(NULL)
+{
+}
+
+Thread::~Thread()
+{
+
+	Join();
+
+}
+
+bool Thread::Start(const char* name, ThreadFunction function, void* argument, unsigned int stack_size)
+{
+
+	if (IsRunning())
+	{
+
+		return false;
+
+	}
+
+	function_ = function;
+	argument_ = argument;
+
+	SceUID thread_id = sceKernelCreateThread(name, ThreadEntry, SCE_KERNEL_DEFAULT_PRIORITY_USER, stack_size, 0, SCE_KERNEL_THREAD_CPU_AFFINITY_MASK_DEFAULT, NULL);
+	if (thread_id < 0)
+	{
+
+		return false;
+
+	}
+
+	// The kernel copies the argument block, so pass it a pointer to this object
+	Thread* self = this;
+	if (sceKernelStartThread(thread_id, sizeof(self), &self) < 0)
+	{
+
+		sceKernelDeleteThread(thread_id);
+		return false;
+
+	}
+
+	thread_id_ = thread_id;
+
+	return true;
+
+}
+
+void Thread::Join()
+{
+
+	if (!IsRunning())
+	{
+
+		return;
+
+	}
+
+	sceKernelWaitThreadEnd(thread_id_, NULL, NULL);
+	sceKernelDeleteThread(thread_id_);
+	thread_id_ = -1;
+
+}
+
+void Thread::Run()
+{
+
+	function_(argument_);
+
+}
+
+Mutex::Mutex()
+{
+
+	// The kernel returns a negative error code on failure, which is kept as -1 so IsValid can be checked
+	mutex_id_ = sceKernelCreateMutex("Mutex", SCE_KERNEL_MUTEX_ATTR_RECURSIVE, 0, NULL);
+	if (mutex_id_ < 0)
+	{
+
+		mutex_id_ = -1;
+
+	}
+
+}
+
+Mutex::~Mutex()
+{
+
+	if (mutex_id_ >= 0)
+	{
+
+		sceKernelDeleteMutex(mutex_id_);
+
+	}
+
+}
+
+void Mutex::Lock()
+{
+
+	if (IsValid())
+	{
+
+		sceKernelLockMutex(mutex_id_, 1, NULL);
+
+	}
+
+}
+
+void Mutex::Unlock()
+{
+
+	if (IsValid())
+	{
+
+		sceKernelUnlockMutex(mutex_id_, 1);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+// Stack given to a thread unless it asks for more
+#define THREAD_DEFAULT_STACK_SIZE (64 * 1024)
+
+// Function run on a thread, given the argument the thread was started with
+typedef void (*ThreadFunction)(void* argument);
+
+// Thread class
+// Runs a function on its own kernel thread, which is waited for and deleted when the thread is joined
+class Thread
+{
+
+public:
+
+	Thread();
+	~Thread();
+
+	// Start running a function on a new thread, returning false if the thread couldn't be created
+	bool Start(const char* name, ThreadFunction function, void* argument, unsigned int stack_size = THREAD_DEFAULT_STACK_SIZE);
+	// Wait for the function to return and delete the thread
+	void Join();
+
+	inline bool IsRunning() const { return thread_id_ >= 0; };
+
+	// Called on the new thread to run the function
+	void Run();
+
+private:
+
+	int thread_id_;
+
+	ThreadFunction function_;
+	void* argument_;
+
+};
+
+// Full memory barrier, so memory accesses before it are seen by other threads before any after it
+// Used to publish the indices of lock-free rings, which are aligned 32-bit volatiles that only one thread writes
+inline void MemoryBarrier()
+{
+
+	__sync_synchronize();
+
+}
+
+// Mutex class
+// Kernel mutex for guarding data shared between threads, which a thread can lock more than once
+class Mutex
+{
+
+public:
+
+	Mutex();
+	~Mutex();
+
+	void Lock();
+	void Unlock();
+
+	// Whether the kernel mutex was created, which it has to be before the mutex is shared between threads
+	inline bool IsValid() const { return mutex_id_ >= 0; };
+
+private:
+
+	int mutex_id_;
+
+};
+
+#endif // !THREAD_H
\ No newline at end of file
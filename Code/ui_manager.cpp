@@ -10,6 +10,11 @@
 #include "level.h"
 #include "game_object.h"
 #include "ar_app.h"
+#include "profiler.h"
+#include "asset_bundle.h"
+
+// PNG files the UI textures are loaded from
+static const char* ui_texture_files[NUM_UI_TEXTURES] = { "warningTexture.png", "controlsTexture.png", "topTexture.png", "winScreen.png" };
 
 UIManager::UIManager() :
 	missing_marker_sprite_(NULL),
@@ -20,18 +25,40 @@ UIManager::UIManager() :
 	win_texture_(NULL),
 	top_sprite_(NULL),
 	top_texture_(NULL),
-	font_(NULL)
+	font_(NULL),
+	debug_text_allowed_(true)
 {
+
+	for (int texture = 0; texture < NUM_UI_TEXTURES; texture++)
+	{
+
+		decoded_images_[texture] = NULL;
+
+	}
+
 }
 
 UIManager::~UIManager()
 {
 
+	// Release any images that were decoded but never made into textures
+	for (int texture = 0; texture < NUM_UI_TEXTURES; texture++)
+	{
 
+		delete decoded_images_[texture];
+
+	}
 
 }
 
-void UIManager::Init(gef::Platform* platform_, float camera_image_scale_factor)
+const char* UIManager::GetTextureFile(UITexture texture)
+{
+
+	return ui_texture_files[texture];
+
+}
+
+void UIManager::Init(gef::Platform* platform_, float camera_image_scale_factor, const AssetBundle* asset_bundle_)
 {
 
 	font_ = new gef::Font(*platform_);
@@ -43,36 +70,24 @@ void UIManager::Init(gef::Platform* platform_, float camera_image_scale_factor)
 	win_sprite_ = new gef::Sprite();
 	top_sprite_ = new gef::Sprite();
 
-	// Load a texture from file for the warning sprite from file
-	std::string file_name = "warningTexture.png";
-	gef::PNGLoader png_loader;
-	gef::ImageData image_data;
-	// Load from file
-	png_loader.Load(file_name.c_str(), *platform_, image_data);
-	// Create texture from the PNG data
-	missing_marker_texture_ = gef::Texture::Create(*platform_, image_data);
+	// Load a texture for the warning sprite
+	missing_marker_texture_ = LoadTexture(platform_, asset_bundle_, UI_TEXTURE_WARNING);
 	platform_->AddTexture(missing_marker_texture_);
 	// Set the texture to the sprite
 	missing_marker_sprite_->set_texture(missing_marker_texture_);
 
 	// Do the same for the instructions sprite
-	file_name = "controlsTexture.png";
-	png_loader.Load(file_name.c_str(), *platform_, image_data);
-	controls_texture_ = gef::Texture::Create(*platform_, image_data);
+	controls_texture_ = LoadTexture(platform_, asset_bundle_, UI_TEXTURE_CONTROLS);
 	platform_->AddTexture(controls_texture_);
 	controls_sprite_->set_texture(controls_texture_);
 
 	// And the top UI sprite
-	file_name = "topTexture.png";
-	png_loader.Load(file_name.c_str(), *platform_, image_data);
-	top_texture_ = gef::Texture::Create(*platform_, image_data);
+	top_texture_ = LoadTexture(platform_, asset_bundle_, UI_TEXTURE_TOP);
 	platform_->AddTexture(top_texture_);
 	top_sprite_->set_texture(top_texture_);
 
 	// And the win screen sprite
-	file_name = "winScreen.png";
-	png_loader.Load(file_name.c_str(), *platform_, image_data);
-	win_texture_ = gef::Texture::Create(*platform_, image_data);
+	win_texture_ = LoadTexture(platform_, asset_bundle_, UI_TEXTURE_WIN);
 	platform_->AddTexture(win_texture_);
 	win_sprite_->set_texture(win_texture_);
 
@@ -82,6 +97,60 @@ void UIManager::Init(gef::Platform* platform_, float camera_image_scale_factor)
 
 }
 
+void UIManager::DecodeTextures(gef::Platform* platform_, const AssetBundle* asset_bundle_)
+{
+
+	gef::PNGLoader png_loader;
+
+	for (int texture = 0; texture < NUM_UI_TEXTURES; texture++)
+	{
+
+		// Bundled textures are already decoded
+		if (decoded_images_[texture] || asset_bundle_->HasTexture(ui_texture_files[texture]))
+		{
+
+			continue;
+
+		}
+
+		decoded_images_[texture] = new gef::ImageData();
+		png_loader.Load(ui_texture_files[texture], *platform_, *decoded_images_[texture]);
+
+	}
+
+}
+
+gef::Texture* UIManager::LoadTexture(gef::Platform* platform_, const AssetBundle* asset_bundle_, UITexture texture)
+{
+
+	// The bundle holds the texels already decoded, so they can go straight to the texture
+	gef::Texture* new_texture = asset_bundle_->CreateTexture(*platform_, ui_texture_files[texture]);
+
+	if (!new_texture && decoded_images_[texture])
+	{
+
+		// Otherwise use the image decoded ahead of time, which isn't needed again
+		new_texture = gef::Texture::Create(*platform_, *decoded_images_[texture]);
+		delete decoded_images_[texture];
+		decoded_images_[texture] = NULL;
+
+	}
+	else if (!new_texture)
+	{
+
+		// Load from file
+		gef::PNGLoader png_loader;
+		gef::ImageData image_data;
+		png_loader.Load(ui_texture_files[texture], *platform_, image_data);
+		// Create texture from the PNG data
+		new_texture = gef::Texture::Create(*platform_, image_data);
+
+	}
+
+	return new_texture;
+
+}
+
 void UIManager::CleanUp(gef::Platform* platform_)
 {
 
@@ -168,14 +237,26 @@ void UIManager::Render(gef::Platform* platform_, gef::SpriteRenderer* sprite_ren
 
 }
 
-void UIManager::DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_renderer_, Level* level_, float fps_, bool marker_01_found_, bool marker_02_found_, Difficulty difficulty)
+void UIManager::DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_renderer_, Level* level_, Profiler* profiler_, float fps_, bool marker_01_found_, bool marker_02_found_, Difficulty difficulty)
 {
 
 	if (font_)
 	{
 
 		// Print the FPS
-		font_->RenderText(sprite_renderer_, gef::Vector4(850.0f, 510.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "FPS: %.1f", fps_);
+		hud_text_.Begin(HUD_TEXT_FPS);
+		hud_text_.Append("FPS: ");
+		hud_text_.AppendFixed(fps_, 1);
+		hud_text_.End();
+		hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_FPS, gef::Vector4(850.0f, 510.0f, -0.9f), gef::TJ_LEFT);
+
+		// Print the pose history frame being looked at, which is asked for explicitly so isn't dropped when over budget
+		if (level_->IsRewinding())
+		{
+
+			DrawRewind(sprite_renderer_, level_);
+
+		}
 
 		// Print warning text for when markers are missing
 		if (!marker_02_found_)
@@ -193,22 +274,80 @@ void UIManager::DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_r
 		else
 		{
 
-			// Print the marker transforms if we need to
-			if (display_transforms_)
+			// Print the marker transforms if we need to, and can afford to
+			if (display_transforms_ && debug_text_allowed_)
 			{
 
-				gef::Vector4 mesh_marker_vector_ = level_->GetGameObject(0)->transform().GetTranslation();
-				font_->RenderText(sprite_renderer_, gef::Vector4(50.0f, 450.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT,
-					"M02 mesh pos: %.3f,  %.3f,  %.3f", mesh_marker_vector_.x(), mesh_marker_vector_.y(), mesh_marker_vector_.z());
+				gef::Vector4 mesh_marker_vector_ = level_->GetCameraTransform(0).GetTranslation();
+				BuildPositionText(HUD_TEXT_M02_POSITION, "M02 mesh pos: ", mesh_marker_vector_);
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_M02_POSITION, gef::Vector4(50.0f, 450.0f, -0.9f), gef::TJ_LEFT);
+
+				mesh_marker_vector_ = level_->GetCameraTransform(1).GetTranslation();
+				BuildPositionText(HUD_TEXT_M01_POSITION, "M01 mesh pos: ", mesh_marker_vector_);
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_M01_POSITION, gef::Vector4(50.0f, 480.0f, -0.9f), gef::TJ_LEFT);
+
+				// Print the culling statistics
+				hud_text_.Begin(HUD_TEXT_CULLING);
+				hud_text_.Append("Drawn: ");
+				hud_text_.AppendInt(profiler_->GetCount(PROFILER_COUNTER_OBJECTS_VISIBLE));
+				hud_text_.Append("  Culled: ");
+				hud_text_.AppendInt(profiler_->GetCount(PROFILER_COUNTER_OBJECTS_CULLED));
+				hud_text_.End();
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_CULLING, gef::Vector4(50.0f, 420.0f, -0.9f), gef::TJ_LEFT);
+
+				// Print how long the last input took to reach the screen
+				hud_text_.Begin(HUD_TEXT_LATENCY);
+				hud_text_.Append("Input latency: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_INPUT_LATENCY), 1);
+				hud_text_.Append(" ms");
+				hud_text_.End();
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_LATENCY, gef::Vector4(50.0f, 390.0f, -0.9f), gef::TJ_LEFT);
+
+				// Print where the startup time went, which only changes once the first frame is out
+				hud_text_.Begin(HUD_TEXT_STARTUP);
+				hud_text_.Append("First frame: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_TIME_TO_FIRST_FRAME), 0);
+				hud_text_.Append(" ms  Setup: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_SETUP), 0);
+				hud_text_.Append("  Loading: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_LOADING), 0);
+				hud_text_.Append("  Upload: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_UPLOAD), 0);
+				hud_text_.End();
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_STARTUP, gef::Vector4(50.0f, 360.0f, -0.9f), gef::TJ_LEFT);
+
+				hud_text_.Begin(HUD_TEXT_STARTUP_TASKS);
+				hud_text_.Append("Tracking: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_TRACKING), 0);
+				hud_text_.Append(" ms  UI decode: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_UI_DECODE), 0);
+				hud_text_.Append("  Level read: ");
+				hud_text_.AppendFixed(profiler_->GetValue(PROFILER_VALUE_STARTUP_LEVEL_READ), 0);
+				hud_text_.End();
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_STARTUP_TASKS, gef::Vector4(50.0f, 330.0f, -0.9f), gef::TJ_LEFT);
 
-				mesh_marker_vector_ = level_->GetGameObject(1)->transform().GetTranslation();
-				font_->RenderText(sprite_renderer_, gef::Vector4(50.0f, 480.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT,
-					"M01 mesh pos: %.3f,  %.3f,  %.3f", mesh_marker_vector_.x(), mesh_marker_vector_.y(), mesh_marker_vector_.z());
+			}
+
+			// Print the progress of a reference capture
+			if (level_->IsCapturing())
+			{
+
+				hud_text_.Begin(HUD_TEXT_CAPTURE);
+				hud_text_.Append("CAPTURING SOLUTION: ");
+				hud_text_.AppendInt(level_->GetCaptureProgress());
+				hud_text_.Append(" / ");
+				hud_text_.AppendInt(CAPTURE_NUM_FRAMES);
+				hud_text_.End();
+				hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_CAPTURE, gef::Vector4(480.0f, 272.0f, -0.9f), gef::TJ_CENTRE);
 
 			}
 
 			// Print the current level based on the ID
-			font_->RenderText(sprite_renderer_, gef::Vector4(350.0f, 0.0f, -0.9f), 1.0f, 0xffffffff, gef::TJ_LEFT, "Level: %i", level_->GetID());
+			hud_text_.Begin(HUD_TEXT_LEVEL);
+			hud_text_.Append("Level: ");
+			hud_text_.AppendInt(level_->GetID());
+			hud_text_.End();
+			hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_LEVEL, gef::Vector4(350.0f, 0.0f, -0.9f), gef::TJ_LEFT);
 
 			// Print the difficulty
 			if (difficulty == DIFFICULTY_EASY)
@@ -230,6 +369,93 @@ void UIManager::DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_r
 
 }
 
+void UIManager::BuildPositionText(HudTextSlot slot, const char* label, const gef::Vector4& position)
+{
+
+	hud_text_.Begin(slot);
+	hud_text_.Append(label);
+	hud_text_.AppendFixed(position.x(), 3);
+	hud_text_.Append(",  ");
+	hud_text_.AppendFixed(position.y(), 3);
+	hud_text_.Append(",  ");
+	hud_text_.AppendFixed(position.z(), 3);
+	hud_text_.End();
+
+}
+
+void UIManager::BuildRowDeltaText(HudTextSlot slot, const char* label, Level* level_, int object)
+{
+
+	float row_deltas[4];
+	level_->GetRewindRowDeltas(object, row_deltas);
+
+	hud_text_.Begin(slot);
+	hud_text_.Append(label);
+	for (int row = 0; row < 4; row++)
+	{
+
+		if (row > 0)
+		{
+
+			hud_text_.Append(",  ");
+
+		}
+		hud_text_.AppendFixed(row_deltas[row], 3);
+
+	}
+	hud_text_.End();
+
+}
+
+void UIManager::DrawRewind(gef::SpriteRenderer* sprite_renderer_, Level* level_)
+{
+
+	const PoseHistoryFrame& frame = level_->GetRewindFrame();
+
+	// Which frame this is, and what the check made of it
+	hud_text_.Begin(HUD_TEXT_REWIND);
+	hud_text_.Append("REWIND: -");
+	hud_text_.AppendInt(level_->GetRewindOffset());
+	hud_text_.Append(" frames (frame ");
+	hud_text_.AppendInt((gef::Int32)frame.frame);
+	hud_text_.Append(frame.is_tracked ? ")  Tracked" : ")  Extrapolated");
+	hud_text_.Append(frame.is_matched ? "  Matched" : "  Not matched");
+	if (frame.matched_solution >= 0)
+	{
+
+		hud_text_.Append(" solution ");
+		hud_text_.AppendInt(frame.matched_solution);
+
+	}
+	hud_text_.End();
+	hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_REWIND, gef::Vector4(50.0f, 30.0f, -0.9f), gef::TJ_LEFT);
+
+	// How many poses each filter had fused, and how fast it thought its marker was moving
+	hud_text_.Begin(HUD_TEXT_REWIND_FILTERS);
+	hud_text_.Append("Filters M02: ");
+	hud_text_.AppendInt(frame.filter_observations[0]);
+	hud_text_.Append(" obs  ");
+	hud_text_.AppendFixed(frame.linear_speeds[0], 3);
+	hud_text_.Append(" u/s  ");
+	hud_text_.AppendFixed(frame.angular_speeds[0], 2);
+	hud_text_.Append(" rad/s  M01: ");
+	hud_text_.AppendInt(frame.filter_observations[1]);
+	hud_text_.Append(" obs  ");
+	hud_text_.AppendFixed(frame.linear_speeds[1], 3);
+	hud_text_.Append(" u/s  ");
+	hud_text_.AppendFixed(frame.angular_speeds[1], 2);
+	hud_text_.Append(" rad/s");
+	hud_text_.End();
+	hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_REWIND_FILTERS, gef::Vector4(50.0f, 60.0f, -0.9f), gef::TJ_LEFT);
+
+	BuildRowDeltaText(HUD_TEXT_REWIND_M02_ROWS, "M02 row deltas: ", level_, 0);
+	hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_REWIND_M02_ROWS, gef::Vector4(50.0f, 90.0f, -0.9f), gef::TJ_LEFT);
+
+	BuildRowDeltaText(HUD_TEXT_REWIND_M01_ROWS, "M01 row deltas: ", level_, 1);
+	hud_text_.Render(font_, sprite_renderer_, HUD_TEXT_REWIND_M01_ROWS, gef::Vector4(50.0f, 120.0f, -0.9f), gef::TJ_LEFT);
+
+}
+
 void UIManager::DisplayTransforms(bool value)
 {
 
@@ -1,6 +1,8 @@
 #ifndef UI_MANAGER_H
 #define UI_MANAGER_H
 
+#include "hud_text.h"
+
 // GEF forward declarations
 namespace gef
 {
@@ -11,13 +13,29 @@ namespace gef
 	class Platform;
 	class SpriteRenderer;
 	class Font;
+	class ImageData;
+	class Vector4;
 
 }
 
 // Other forward declarations
 class Level;
+class Profiler;
+class AssetBundle;
 enum Difficulty;
 
+// Enumerated type for the textures used by the UI
+enum UITexture
+{
+
+	UI_TEXTURE_WARNING,				// Background of the warnings when markers are missing
+	UI_TEXTURE_CONTROLS,			// Startup instructions
+	UI_TEXTURE_TOP,					// Top of the UI
+	UI_TEXTURE_WIN,					// Win screen
+	NUM_UI_TEXTURES
+
+};
+
 // UI manager class
 // Handles drawing the UI sprites and text to the screen
 class UIManager
@@ -28,23 +46,44 @@ public:
 	UIManager();
 	~UIManager();
 
-	// Initialise the user interface objects
-	void Init(gef::Platform* platform_, float camera_image_scale_factor);
+	// Decode the UI textures that aren't in the asset bundle, ready for Init to create them
+	// This doesn't touch the GPU, so it can be run on another thread while the game starts up
+	void DecodeTextures(gef::Platform* platform_, const AssetBundle* asset_bundle_);
+	// Initialise the user interface objects, taking textures from the asset bundle or the decoded images where there are them
+	void Init(gef::Platform* platform_, float camera_image_scale_factor, const AssetBundle* asset_bundle_);
 	// Clean up the user interface objects
 	void CleanUp(gef::Platform* platform_);
 	// Render the UI sprites
 	void Render(gef::Platform* platform_, gef::SpriteRenderer* sprite_renderer_, bool has_won_, bool show_controls_, bool marker_01_found_, bool marker_02_found_);
 	// Render the text
-	void DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_renderer_, Level* level_, float fps_, bool marker_01_found_, bool marker_02_found_, Difficulty difficulty);
+	void DrawFont(gef::Platform* platform_, gef::SpriteRenderer* sprite_renderer_, Level* level_, Profiler* profiler_, float fps_, bool marker_01_found_, bool marker_02_found_, Difficulty difficulty);
 
 	// Get whether we're currently displaying the transforms
 	void DisplayTransforms(bool value);
 	// Set whether we want to display the transforms
 	bool IsDisplayingTransforms();
 
+	// Set whether the debug text can be drawn, so it can be dropped when the frame is over budget
+	inline void SetDebugTextAllowed(bool value) { debug_text_allowed_ = value; };
+
+	// Get the PNG file a texture is loaded from, e.g. to bake it into the asset bundle
+	static const char* GetTextureFile(UITexture texture);
+
 private:
 
+	// Create a texture from the asset bundle, or its decoded image, or by loading its PNG file if there's neither
+	gef::Texture* LoadTexture(gef::Platform* platform_, const AssetBundle* asset_bundle_, UITexture texture);
+
+	// Describe a position in a HUD slot, with the coordinates to three decimal places
+	void BuildPositionText(HudTextSlot slot, const char* label, const gef::Vector4& position);
+	// Describe how far each row of an object's transform was from its reference in the pose history frame being looked at
+	void BuildRowDeltaText(HudTextSlot slot, const char* label, Level* level_, int object);
+	// Render what's known about the pose history frame being looked at
+	void DrawRewind(gef::SpriteRenderer* sprite_renderer_, Level* level_);
+
 	gef::Font* font_;
+	// Cached strings for the HUD text that changes from frame to frame
+	HudText hud_text_;
 
 	// Sprite holding a texture for the background of warnings when markers are missing
 	gef::Sprite* missing_marker_sprite_;
@@ -61,10 +100,14 @@ private:
 	class gef::Texture* win_texture_;
 	class gef::Texture* top_texture_;
 
+	// Images decoded ahead of Init, which are released once their textures have been created
+	gef::ImageData* decoded_images_[NUM_UI_TEXTURES];
+
 	// Scale factor to make images fit the screen's aspect ratio
 	float camera_image_scale_factor_;
 
 	bool display_transforms_;
+	bool debug_text_allowed_;
 
 };
 
@@ -0,0 +1,328 @@
+// Host tests for the compact pose format the stress traces and pose history dumps are written in
+// Random marker and object poses are round tripped through PoseCodec and checked against the error bounds the
+// quantisation allows, and pose files are round tripped and checked to be rejected when missing, corrupt or truncated
+// Build with the CMakeLists.txt in this directory, against the stand-in GEF headers in gef_stub
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "compact_pose.h"
+#include "pose_maths.h"
+
+// Largest errors a round trip can have, from half a quantisation step of each field plus float rounding
+// Translations are stored in steps of COMPACT_POSE_TRANSLATION_RANGE / 32767
+#define MAX_TRANSLATION_ERROR (0.5f * COMPACT_POSE_TRANSLATION_RANGE / 32767.0f + 1.0e-6f)
+// Each stored quaternion component is within half a step of sqrt(2) / 65535, so the rotation is within a few of them
+#define MAX_ROTATION_ERROR 1.0e-4
+// Log2 scales are stored in steps of 12 / 255, so half a step is a factor of about 1.0164
+#define MAX_RELATIVE_SCALE_ERROR 0.0165f
+
+// Number of random poses round tripped
+#define NUM_RANDOM_POSES 20000
+
+// File written and read by the file tests, in the working directory
+#define TEST_POSE_FILE "compact_pose_tests.pose"
+
+static int num_checks = 0;
+static int num_failures = 0;
+
+// Count a check, reporting the first few that fail
+static void Check(bool condition, const char* format, ...)
+{
+
+	num_checks++;
+	if (condition)
+	{
+
+		return;
+
+	}
+
+	num_failures++;
+	if (num_failures <= 20)
+	{
+
+		va_list arguments;
+		va_start(arguments, format);
+		printf("FAILED: ");
+		vprintf(format, arguments);
+		printf("\n");
+		va_end(arguments);
+
+	}
+
+}
+
+// Xorshift generator, so every run sees the same poses
+static unsigned int random_state = 0x2545f491u;
+
+static unsigned int RandomBits()
+{
+
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+
+}
+
+// Uniform in [min, max)
+static float RandomRange(float min, float max)
+{
+
+	return min + (max - min) * (float)(RandomBits() >> 8) / (float)(1 << 24);
+
+}
+
+static gef::Quaternion RandomRotation()
+{
+
+	// Normalising a random 4D direction gives a uniformly distributed rotation
+	float x, y, z, w, length;
+	do
+	{
+
+		x = RandomRange(-1.0f, 1.0f);
+		y = RandomRange(-1.0f, 1.0f);
+		z = RandomRange(-1.0f, 1.0f);
+		w = RandomRange(-1.0f, 1.0f);
+		length = sqrtf(x * x + y * y + z * z + w * w);
+
+	} while (length < 0.1f || length > 1.0f);
+
+	return gef::Quaternion(x / length, y / length, z / length, w / length);
+
+}
+
+// Angle between two rotations in radians, worked out in double so it's good for tiny angles
+static double RotationError(const gef::Quaternion& a, const gef::Quaternion& b)
+{
+
+	double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z + (double)a.w * b.w;
+	double difference[4] =
+	{
+		a.x - (dot < 0.0 ? -b.x : b.x),
+		a.y - (dot < 0.0 ? -b.y : b.y),
+		a.z - (dot < 0.0 ? -b.z : b.z),
+		a.w - (dot < 0.0 ? -b.w : b.w)
+	};
+
+	// The chord between unit quaternions is 2 sin(angle / 4)
+	double chord = sqrt(difference[0] * difference[0] + difference[1] * difference[1] + difference[2] * difference[2] + difference[3] * difference[3]);
+	return 4.0 * asin(chord * 0.5 > 1.0 ? 1.0 : chord * 0.5);
+
+}
+
+static bool IsSameMatrix(const gef::Matrix44& a, const gef::Matrix44& b)
+{
+
+	return memcmp(&a, &b, sizeof(gef::Matrix44)) == 0;
+
+}
+
+static void TestRoundTrip()
+{
+
+	float worst_translation = 0.0f;
+	double worst_rotation = 0.0;
+	float worst_scale = 0.0f;
+
+	for (int test = 0; test < NUM_RANDOM_POSES; test++)
+	{
+
+		// Everything from the marker poses, which are tens of centimetres away, to object transforms in the stored range
+		float range = test % 2 == 0 ? 0.5f : COMPACT_POSE_TRANSLATION_RANGE * 0.99f;
+		gef::Vector4 translation(RandomRange(-range, range), RandomRange(-range, range), RandomRange(-range, range));
+		gef::Quaternion rotation = RandomRotation();
+		float scale = powf(2.0f, RandomRange(COMPACT_POSE_MIN_LOG_SCALE + 0.5f, COMPACT_POSE_MAX_LOG_SCALE - 0.5f));
+
+		gef::Matrix44 transform;
+		PoseMaths::Compose(translation, rotation, scale, transform);
+
+		CompactPose pose;
+		gef::Matrix44 decoded;
+		PoseCodec::Encode(transform, pose);
+		PoseCodec::Decode(pose, decoded);
+
+		gef::Vector4 decoded_translation;
+		gef::Quaternion decoded_rotation;
+		float decoded_scale;
+		PoseMaths::Decompose(decoded, decoded_translation, decoded_rotation, decoded_scale);
+
+		float translation_error = fabsf(decoded_translation.x() - translation.x());
+		translation_error = fmaxf(translation_error, fabsf(decoded_translation.y() - translation.y()));
+		translation_error = fmaxf(translation_error, fabsf(decoded_translation.z() - translation.z()));
+		double rotation_error = RotationError(decoded_rotation, rotation);
+		float scale_error = fabsf(decoded_scale / scale - 1.0f);
+
+		worst_translation = fmaxf(worst_translation, translation_error);
+		worst_rotation = rotation_error > worst_rotation ? rotation_error : worst_rotation;
+		worst_scale = fmaxf(worst_scale, scale_error);
+
+		Check(translation_error <= MAX_TRANSLATION_ERROR, "round trip %i translation error %g", test, translation_error);
+		Check(rotation_error <= MAX_ROTATION_ERROR, "round trip %i rotation error %g", test, rotation_error);
+		Check(scale_error <= MAX_RELATIVE_SCALE_ERROR, "round trip %i scale error %g", test, scale_error);
+
+		// Round tripping again mustn't drift, though when two quaternion components tie a different one can be dropped
+		CompactPose pose_again;
+		gef::Matrix44 decoded_again;
+		PoseCodec::Encode(decoded, pose_again);
+		PoseCodec::Decode(pose_again, decoded_again);
+		Check(memcmp(pose.translation, pose_again.translation, sizeof(pose.translation)) == 0 && pose.log_scale == pose_again.log_scale,
+			"round trip %i translation or scale changed on a second round trip", test);
+
+		gef::Vector4 translation_again;
+		gef::Quaternion rotation_again;
+		float scale_again;
+		PoseMaths::Decompose(decoded_again, translation_again, rotation_again, scale_again);
+		Check(RotationError(rotation_again, decoded_rotation) <= MAX_ROTATION_ERROR, "round trip %i rotation drifted on a second round trip", test);
+
+	}
+
+	printf("Worst round trip errors: translation %g, rotation %g radians, relative scale %g\n", worst_translation, worst_rotation, worst_scale);
+
+}
+
+static void TestClamping()
+{
+
+	// Out of range translations and scales are clamped rather than wrapping around
+	gef::Matrix44 transform;
+	PoseMaths::Compose(gef::Vector4(100.0f, -100.0f, 0.0f), gef::Quaternion(), 1000.0f, transform);
+
+	CompactPose pose;
+	gef::Matrix44 decoded;
+	PoseCodec::Encode(transform, pose);
+	PoseCodec::Decode(pose, decoded);
+
+	gef::Vector4 translation;
+	gef::Quaternion rotation;
+	float scale;
+	PoseMaths::Decompose(decoded, translation, rotation, scale);
+
+	Check(fabsf(translation.x() - COMPACT_POSE_TRANSLATION_RANGE) <= MAX_TRANSLATION_ERROR, "clamped x is %g", translation.x());
+	Check(fabsf(translation.y() + COMPACT_POSE_TRANSLATION_RANGE) <= MAX_TRANSLATION_ERROR, "clamped y is %g", translation.y());
+	Check(fabsf(scale / powf(2.0f, COMPACT_POSE_MAX_LOG_SCALE) - 1.0f) <= MAX_RELATIVE_SCALE_ERROR, "clamped scale is %g", scale);
+
+}
+
+// Write raw bytes to the test file
+static void WriteBytes(const void* data, size_t size)
+{
+
+	FILE* file = fopen(TEST_POSE_FILE, "wb");
+	if (file)
+	{
+
+		fwrite(data, 1, size, file);
+		fclose(file);
+
+	}
+
+}
+
+// Read the whole test file
+static std::vector<unsigned char> ReadBytes()
+{
+
+	std::vector<unsigned char> bytes;
+	FILE* file = fopen(TEST_POSE_FILE, "rb");
+	if (file)
+	{
+
+		int byte;
+		while ((byte = fgetc(file)) != EOF)
+		{
+
+			bytes.push_back((unsigned char)byte);
+
+		}
+
+		fclose(file);
+
+	}
+
+	return bytes;
+
+}
+
+static void TestFiles()
+{
+
+	std::vector<gef::Matrix44> transforms(100);
+	for (size_t transform = 0; transform < transforms.size(); transform++)
+	{
+
+		gef::Vector4 translation(RandomRange(-0.5f, 0.5f), RandomRange(-0.5f, 0.5f), RandomRange(-2.0f, -0.1f));
+		PoseMaths::Compose(translation, RandomRotation(), RandomRange(0.05f, 0.1f), transforms[transform]);
+
+	}
+
+	// A file reads back as exactly what decoding each pose gives
+	Check(PoseCodec::WritePoseFile(TEST_POSE_FILE, &transforms[0], (int)transforms.size()), "writing a pose file failed");
+
+	std::vector<gef::Matrix44> read_transforms;
+	Check(PoseCodec::ReadPoseFile(TEST_POSE_FILE, read_transforms), "reading a pose file failed");
+	Check(read_transforms.size() == transforms.size(), "read %i poses, wrote %i", (int)read_transforms.size(), (int)transforms.size());
+
+	for (size_t transform = 0; transform < transforms.size() && transform < read_transforms.size(); transform++)
+	{
+
+		CompactPose pose;
+		gef::Matrix44 decoded;
+		PoseCodec::Encode(transforms[transform], pose);
+		PoseCodec::Decode(pose, decoded);
+		Check(IsSameMatrix(decoded, read_transforms[transform]), "pose %i read back differently", (int)transform);
+
+	}
+
+	// An empty file of poses is fine
+	Check(PoseCodec::WritePoseFile(TEST_POSE_FILE, NULL, 0), "writing an empty pose file failed");
+	Check(PoseCodec::ReadPoseFile(TEST_POSE_FILE, read_transforms) && read_transforms.empty(), "reading an empty pose file failed");
+
+	// Corrupt files are rejected without touching what was passed in
+	PoseCodec::WritePoseFile(TEST_POSE_FILE, &transforms[0], (int)transforms.size());
+	std::vector<unsigned char> bytes = ReadBytes();
+	Check(bytes.size() > 12, "pose file is only %i bytes", (int)bytes.size());
+
+	std::vector<gef::Matrix44> untouched(1);
+	untouched[0].SetIdentity();
+
+	std::vector<unsigned char> corrupt = bytes;
+	corrupt[0] ^= 0xff;
+	WriteBytes(&corrupt[0], corrupt.size());
+	Check(!PoseCodec::ReadPoseFile(TEST_POSE_FILE, untouched) && untouched.size() == 1, "a file with the wrong magic was read");
+
+	// The count is the third word of the header, and a huge one mustn't be trusted enough to allocate for
+	corrupt = bytes;
+	memset(&corrupt[8], 0xff, 4);
+	WriteBytes(&corrupt[0], corrupt.size());
+	Check(!PoseCodec::ReadPoseFile(TEST_POSE_FILE, untouched) && untouched.size() == 1, "a file with a huge count was read");
+
+	corrupt = bytes;
+	corrupt.resize(bytes.size() - 1);
+	WriteBytes(&corrupt[0], corrupt.size());
+	Check(!PoseCodec::ReadPoseFile(TEST_POSE_FILE, untouched) && untouched.size() == 1, "a truncated file was read");
+
+	WriteBytes(&bytes[0], 6);
+	Check(!PoseCodec::ReadPoseFile(TEST_POSE_FILE, untouched) && untouched.size() == 1, "a file with a truncated header was read");
+
+	remove(TEST_POSE_FILE);
+	Check(!PoseCodec::ReadPoseFile(TEST_POSE_FILE, untouched) && untouched.size() == 1, "a missing file was read");
+
+}
+
+int main(int argc, char** argv)
+{
+
+	TestRoundTrip();
+	TestClamping();
+	TestFiles();
+
+	printf("%i of %i checks failed\n", num_failures, num_checks);
+
+	return num_failures == 0 ? 0 : 1;
+
+}
\ No newline at end of file
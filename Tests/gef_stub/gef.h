@@ -0,0 +1,19 @@
+#ifndef _GEF_STUB_GEF_H
+#define _GEF_STUB_GEF_H
+
+// Host stand-in for GEF's fixed size integer types
+namespace gef
+{
+
+	typedef signed char Int8;
+	typedef unsigned char UInt8;
+	typedef short Int16;
+	typedef unsigned short UInt16;
+	typedef int Int32;
+	typedef unsigned int UInt32;
+	typedef long long Int64;
+	typedef unsigned long long UInt64;
+
+}
+
+#endif // !_GEF_STUB_GEF_H
\ No newline at end of file
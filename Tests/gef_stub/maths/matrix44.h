@@ -0,0 +1,123 @@
+#ifndef _GEF_STUB_MATRIX44_H
+#define _GEF_STUB_MATRIX44_H
+
+#include <stddef.h>
+#include <maths/vector4.h>
+
+// Host stand-in for the parts of gef::Matrix44 the pose maths uses
+// Like GEF, transforms are row vector matrices and everything is worked out in single precision,
+// including the general inverse, so the tests see float rounding rather than a more forgiving double precision stand-in
+namespace gef
+{
+
+	class Matrix44
+	{
+
+	public:
+
+		inline void SetIdentity()
+		{
+
+			for (int row = 0; row < 4; row++)
+			{
+
+				for (int column = 0; column < 4; column++)
+				{
+
+					m_[row][column] = row == column ? 1.0f : 0.0f;
+
+				}
+
+			}
+
+		};
+
+		inline Vector4 GetRow(int row) const { return Vector4(m_[row][0], m_[row][1], m_[row][2], m_[row][3]); };
+		inline void SetRow(int row, const Vector4& values) { m_[row][0] = values.x(); m_[row][1] = values.y(); m_[row][2] = values.z(); m_[row][3] = values.w(); };
+		inline Vector4 GetTranslation() const { return Vector4(m_[3][0], m_[3][1], m_[3][2]); };
+
+		inline float m(int row, int column) const { return m_[row][column]; };
+		inline void set_m(int row, int column, float value) { m_[row][column] = value; };
+
+		// General inverse by cofactors
+		inline void Inverse(const Matrix44& matrix, float* determinant = NULL)
+		{
+
+			const float (*a)[4] = matrix.m_;
+			float c[4][4];
+
+			for (int row = 0; row < 4; row++)
+			{
+
+				for (int column = 0; column < 4; column++)
+				{
+
+					// Minor of the element, from the three rows and columns that aren't its own
+					int r[3];
+					int k[3];
+					for (int i = 0, n = 0; i < 4; i++) { if (i != row) r[n++] = i; }
+					for (int i = 0, n = 0; i < 4; i++) { if (i != column) k[n++] = i; }
+
+					float minor = a[r[0]][k[0]] * (a[r[1]][k[1]] * a[r[2]][k[2]] - a[r[1]][k[2]] * a[r[2]][k[1]])
+						- a[r[0]][k[1]] * (a[r[1]][k[0]] * a[r[2]][k[2]] - a[r[1]][k[2]] * a[r[2]][k[0]])
+						+ a[r[0]][k[2]] * (a[r[1]][k[0]] * a[r[2]][k[1]] - a[r[1]][k[1]] * a[r[2]][k[0]]);
+
+					c[row][column] = (row + column) % 2 == 0 ? minor : -minor;
+
+				}
+
+			}
+
+			float det = a[0][0] * c[0][0] + a[0][1] * c[0][1] + a[0][2] * c[0][2] + a[0][3] * c[0][3];
+			if (determinant)
+			{
+
+				*determinant = det;
+
+			}
+
+			float inv_det = 1.0f / det;
+			for (int row = 0; row < 4; row++)
+			{
+
+				for (int column = 0; column < 4; column++)
+				{
+
+					m_[row][column] = c[column][row] * inv_det;
+
+				}
+
+			}
+
+		};
+
+		inline const Matrix44 operator*(const Matrix44& other) const
+		{
+
+			Matrix44 result;
+			for (int row = 0; row < 4; row++)
+			{
+
+				for (int column = 0; column < 4; column++)
+				{
+
+					result.m_[row][column] = m_[row][0] * other.m_[0][column] + m_[row][1] * other.m_[1][column]
+						+ m_[row][2] * other.m_[2][column] + m_[row][3] * other.m_[3][column];
+
+				}
+
+			}
+
+			return result;
+
+		};
+
+	private:
+
+		float m_[4][4];
+
+	};
+
+}
+
+#endif // !_GEF_STUB_MATRIX44_H
\ No newline at end of file
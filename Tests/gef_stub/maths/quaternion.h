@@ -0,0 +1,25 @@
+#ifndef _GEF_STUB_QUATERNION_H
+#define _GEF_STUB_QUATERNION_H
+
+// Host stand-in for gef::Quaternion, which is plain data as far as the pose maths is concerned
+namespace gef
+{
+
+	class Quaternion
+	{
+
+	public:
+
+		Quaternion() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {};
+		Quaternion(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {};
+
+		float x;
+		float y;
+		float z;
+		float w;
+
+	};
+
+}
+
+#endif // !_GEF_STUB_QUATERNION_H
\ No newline at end of file
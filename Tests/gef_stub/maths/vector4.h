@@ -0,0 +1,33 @@
+#ifndef _GEF_STUB_VECTOR4_H
+#define _GEF_STUB_VECTOR4_H
+
+#include <math.h>
+
+// Host stand-in for the parts of gef::Vector4 the pose maths uses, so it can be tested off the Vita
+namespace gef
+{
+
+	class Vector4
+	{
+
+	public:
+
+		Vector4() { values_[0] = 0.0f; values_[1] = 0.0f; values_[2] = 0.0f; values_[3] = 1.0f; };
+		Vector4(float x, float y, float z, float w = 1.0f) { values_[0] = x; values_[1] = y; values_[2] = z; values_[3] = w; };
+
+		inline float x() const { return values_[0]; };
+		inline float y() const { return values_[1]; };
+		inline float z() const { return values_[2]; };
+		inline float w() const { return values_[3]; };
+
+		inline float Length() const { return sqrtf(values_[0] * values_[0] + values_[1] * values_[1] + values_[2] * values_[2]); };
+
+	private:
+
+		float values_[4];
+
+	};
+
+}
+
+#endif // !_GEF_STUB_VECTOR4_H
\ No newline at end of file
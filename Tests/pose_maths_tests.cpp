@@ -0,0 +1,714 @@
+// Host tests and benchmark for the transform numerics the matching depends on
+// Marker localisation (PoseMaths::GetLocalTransform) is checked against a double precision reference over random
+// rigid and uniformly scaled marker poses, to the ULP bound below, and fuzzed with the NaNs, infinities and collapsed
+// transforms that tracking produces when it's lost. The fixed tolerance compare used by Level::CheckTransforms
+// (PoseMaths::IsWithinTolerance) is checked against a double precision reference of the same rule
+// Build with the CMakeLists.txt in this directory, against the stand-in GEF headers in gef_stub
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <time.h>
+#include "pose_maths.h"
+
+// Largest error allowed in an element of a local transform, in ULPs of the element's magnitude before cancellation,
+// i.e. of the sum of the absolute products that make it up, which is what float rounding error scales with
+// The worst seen over the random poses is a little over 7, so this leaves room for other compilers' rounding
+#define LOCAL_TRANSFORM_MAX_ULPS 16.0
+
+// Number of random poses each property is checked over
+#define NUM_RANDOM_POSES 20000
+// Number of fuzzed transforms
+#define NUM_FUZZ_CASES 50000
+// Number of calls each benchmark is timed over
+#define NUM_BENCHMARK_CALLS 1000000
+
+static int num_checks = 0;
+static int num_failures = 0;
+
+// Count a check, reporting the first few that fail
+static void Check(bool condition, const char* format, ...)
+{
+
+	num_checks++;
+	if (condition)
+	{
+
+		return;
+
+	}
+
+	num_failures++;
+	if (num_failures <= 20)
+	{
+
+		va_list arguments;
+		va_start(arguments, format);
+		printf("FAILED: ");
+		vprintf(format, arguments);
+		printf("\n");
+		va_end(arguments);
+
+	}
+
+}
+
+// Xorshift generator, so every run sees the same poses
+static unsigned int random_state = 0x9e3779b9u;
+
+static unsigned int RandomBits()
+{
+
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+
+}
+
+// Uniform in [min, max)
+static float RandomRange(float min, float max)
+{
+
+	return min + (max - min) * (float)(RandomBits() >> 8) / (float)(1 << 24);
+
+}
+
+// Spread over the orders of magnitude between min and max
+static float RandomLogRange(float min, float max)
+{
+
+	return expf(RandomRange(logf(min), logf(max)));
+
+}
+
+static gef::Quaternion RandomRotation()
+{
+
+	// Normalising a random 4D direction gives a uniformly distributed rotation
+	float x, y, z, w, length;
+	do
+	{
+
+		x = RandomRange(-1.0f, 1.0f);
+		y = RandomRange(-1.0f, 1.0f);
+		z = RandomRange(-1.0f, 1.0f);
+		w = RandomRange(-1.0f, 1.0f);
+		length = sqrtf(x * x + y * y + z * z + w * w);
+
+	} while (length < 0.1f || length > 1.0f);
+
+	return gef::Quaternion(x / length, y / length, z / length, w / length);
+
+}
+
+// A marker pose like the tracking library reports, in front of the camera and scaled to the marker's size
+static gef::Matrix44 RandomMarkerPose(float min_scale, float max_scale)
+{
+
+	gef::Vector4 translation(RandomRange(-0.5f, 0.5f), RandomRange(-0.5f, 0.5f), RandomRange(-2.0f, -0.1f));
+	gef::Matrix44 pose;
+	PoseMaths::Compose(translation, RandomRotation(), RandomLogRange(min_scale, max_scale), pose);
+	return pose;
+
+}
+
+static float RandomSpecial()
+{
+
+	switch (RandomBits() % 8)
+	{
+
+	case 0:
+		return NAN;
+	case 1:
+		return INFINITY;
+	case 2:
+		return -INFINITY;
+	case 3:
+		return FLT_MAX;
+	case 4:
+		return FLT_MIN / 4.0f;
+	case 5:
+		return 0.0f;
+	case 6:
+		return RandomLogRange(1.0e20f, 1.0e38f);
+	default:
+		return RandomLogRange(1.0e-38f, 1.0e-20f);
+
+	}
+
+}
+
+// Size of one ULP of a float of this magnitude
+static double Ulp(double magnitude)
+{
+
+	int exponent;
+	frexp(magnitude > FLT_MIN ? magnitude : FLT_MIN, &exponent);
+	return ldexp(1.0, exponent - FLT_MANT_DIG);
+
+}
+
+// Work out transform * inverse(parent) in double precision, treating the parent as affine as all marker poses are
+// Magnitude gets the sum of the absolute products that make up each element
+static bool ReferenceLocalTransform(const gef::Matrix44& transform, const gef::Matrix44& parent, double local[4][4], double magnitude[4][4])
+{
+
+	double p[3][3];
+	double t[3];
+	for (int row = 0; row < 3; row++)
+	{
+
+		for (int column = 0; column < 3; column++)
+		{
+
+			p[row][column] = PoseMaths::GetElement(parent, row, column);
+
+		}
+
+		t[row] = PoseMaths::GetElement(parent, 3, row);
+
+	}
+
+	double determinant = p[0][0] * (p[1][1] * p[2][2] - p[1][2] * p[2][1])
+		- p[0][1] * (p[1][0] * p[2][2] - p[1][2] * p[2][0])
+		+ p[0][2] * (p[1][0] * p[2][1] - p[1][1] * p[2][0]);
+
+	if (determinant == 0.0)
+	{
+
+		return false;
+
+	}
+
+	// The rotation part is inverted by its adjugate, and the translation is -t * inverse(R)
+	double inv[4][4];
+	inv[0][0] = (p[1][1] * p[2][2] - p[1][2] * p[2][1]) / determinant;
+	inv[0][1] = (p[0][2] * p[2][1] - p[0][1] * p[2][2]) / determinant;
+	inv[0][2] = (p[0][1] * p[1][2] - p[0][2] * p[1][1]) / determinant;
+	inv[1][0] = (p[1][2] * p[2][0] - p[1][0] * p[2][2]) / determinant;
+	inv[1][1] = (p[0][0] * p[2][2] - p[0][2] * p[2][0]) / determinant;
+	inv[1][2] = (p[0][2] * p[1][0] - p[0][0] * p[1][2]) / determinant;
+	inv[2][0] = (p[1][0] * p[2][1] - p[1][1] * p[2][0]) / determinant;
+	inv[2][1] = (p[0][1] * p[2][0] - p[0][0] * p[2][1]) / determinant;
+	inv[2][2] = (p[0][0] * p[1][1] - p[0][1] * p[1][0]) / determinant;
+
+	for (int column = 0; column < 3; column++)
+	{
+
+		inv[3][column] = -(t[0] * inv[0][column] + t[1] * inv[1][column] + t[2] * inv[2][column]);
+		inv[column][3] = 0.0;
+
+	}
+	inv[3][3] = 1.0;
+
+	// The translation row's magnitude includes the parent's translation, which is where the cancellation happens
+	for (int row = 0; row < 4; row++)
+	{
+
+		for (int column = 0; column < 4; column++)
+		{
+
+			local[row][column] = 0.0;
+			magnitude[row][column] = 0.0;
+
+			for (int k = 0; k < 4; k++)
+			{
+
+				double element = PoseMaths::GetElement(transform, row, k);
+				local[row][column] += element * inv[k][column];
+				magnitude[row][column] += fabs(element * inv[k][column]);
+
+				if (row == 3 && k == 3 && column < 3)
+				{
+
+					magnitude[row][column] += fabs(t[0] * inv[0][column]) + fabs(t[1] * inv[1][column]) + fabs(t[2] * inv[2][column]);
+
+				}
+
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+// Largest error of a local transform's elements from the reference, in ULPs of their magnitudes
+static double LocalTransformError(const gef::Matrix44& transform, const gef::Matrix44& parent, const gef::Matrix44& local)
+{
+
+	double reference[4][4];
+	double magnitude[4][4];
+	if (!ReferenceLocalTransform(transform, parent, reference, magnitude))
+	{
+
+		return HUGE_VAL;
+
+	}
+
+	double largest_error = 0.0;
+	for (int row = 0; row < 4; row++)
+	{
+
+		for (int column = 0; column < 4; column++)
+		{
+
+			double error = fabs((double)PoseMaths::GetElement(local, row, column) - reference[row][column]) / Ulp(magnitude[row][column]);
+			largest_error = error > largest_error ? error : largest_error;
+
+		}
+
+	}
+
+	return largest_error;
+
+}
+
+static bool IsSameMatrix(const gef::Matrix44& a, const gef::Matrix44& b)
+{
+
+	return memcmp(&a, &b, sizeof(gef::Matrix44)) == 0;
+
+}
+
+static void TestLocalTransformAccuracy()
+{
+
+	double largest_error = 0.0;
+
+	for (int pose = 0; pose < NUM_RANDOM_POSES; pose++)
+	{
+
+		// Real markers are a few centimetres across, but anything from tiny to huge should localise as accurately
+		bool is_marker_sized = pose % 2 == 0;
+		gef::Matrix44 parent = is_marker_sized ? RandomMarkerPose(0.03f, 0.1f) : RandomMarkerPose(1.0e-3f, 1.0e3f);
+		gef::Matrix44 transform = is_marker_sized ? RandomMarkerPose(0.03f, 0.1f) : RandomMarkerPose(1.0e-3f, 1.0e3f);
+
+		Check(PoseMaths::IsFinite(parent) && PoseMaths::IsInvertible(parent), "random pose %i isn't invertible", pose);
+
+		gef::Matrix44 local;
+		bool is_localised = PoseMaths::GetLocalTransform(transform, parent, local);
+		Check(is_localised, "random pose %i wasn't localised", pose);
+		if (!is_localised)
+		{
+
+			continue;
+
+		}
+
+		double error = LocalTransformError(transform, parent, local);
+		largest_error = error > largest_error ? error : largest_error;
+		Check(error <= LOCAL_TRANSFORM_MAX_ULPS, "random pose %i is %.1f ULPs from the reference", pose, error);
+
+	}
+
+	printf("Local transform: largest error %.2f ULPs over %i random poses (bound %.0f)\n", largest_error, NUM_RANDOM_POSES, LOCAL_TRANSFORM_MAX_ULPS);
+
+}
+
+static void TestLocalTransformProperties()
+{
+
+	for (int pose = 0; pose < NUM_RANDOM_POSES; pose++)
+	{
+
+		gef::Matrix44 parent = RandomMarkerPose(0.03f, 0.1f);
+
+		// A pose relative to itself is the identity
+		gef::Matrix44 local;
+		gef::Matrix44 identity;
+		identity.SetIdentity();
+		Check(PoseMaths::GetLocalTransform(parent, parent, local) && LocalTransformError(parent, parent, local) <= LOCAL_TRANSFORM_MAX_ULPS,
+			"pose %i relative to itself isn't the identity", pose);
+		// The translation row is worked out from the parent's translation divided by its scale, so it's less precise
+		Check(PoseMaths::IsWithinTolerance(local, identity, 1.0e-5f, 1.0e-4f), "pose %i relative to itself is far from the identity", pose);
+
+		// Putting the local transform back on its parent gives the original transform
+		gef::Matrix44 transform = RandomMarkerPose(0.03f, 0.1f);
+		Check(PoseMaths::GetLocalTransform(transform, parent, local), "pose %i wasn't localised", pose);
+		Check(PoseMaths::IsWithinTolerance(local * parent, transform, 1.0e-5f, 1.0e-5f), "pose %i doesn't round trip", pose);
+
+		// Localising is unaffected by moving both poses together
+		gef::Matrix44 offset = RandomMarkerPose(1.0f, 1.0f);
+		gef::Matrix44 moved_local;
+		Check(PoseMaths::GetLocalTransform(transform * offset, parent * offset, moved_local)
+			&& PoseMaths::IsWithinTolerance(moved_local, local, 1.0e-4f, 1.0e-4f), "pose %i depends on the shared frame", pose);
+
+		// Decomposing and composing a pose gives it back
+		gef::Vector4 translation;
+		gef::Quaternion rotation;
+		float scale;
+		gef::Matrix44 recomposed;
+		PoseMaths::Decompose(transform, translation, rotation, scale);
+		PoseMaths::Compose(translation, rotation, scale, recomposed);
+		Check(PoseMaths::IsWithinTolerance(recomposed, transform, 1.0e-6f, 1.0e-6f), "pose %i doesn't decompose and recompose", pose);
+
+	}
+
+}
+
+static void TestInvertible()
+{
+
+	// Any rigid, uniformly scaled pose is invertible, however big or small
+	for (int pose = 0; pose < NUM_RANDOM_POSES; pose++)
+	{
+
+		gef::Matrix44 transform = RandomMarkerPose(1.0e-3f, 1.0e3f);
+		Check(PoseMaths::IsInvertible(transform), "rigid pose %i isn't invertible", pose);
+
+	}
+
+	gef::Matrix44 transform;
+
+	// A collapsed row
+	transform.SetIdentity();
+	transform.SetRow(1, gef::Vector4(0.0f, 0.0f, 0.0f, 0.0f));
+	Check(!PoseMaths::IsInvertible(transform), "a zero row is invertible");
+
+	// Rows shorter than POSE_MIN_AXIS_LENGTH
+	transform.SetIdentity();
+	transform.SetRow(2, gef::Vector4(0.0f, 0.0f, POSE_MIN_AXIS_LENGTH * 0.5f, 0.0f));
+	Check(!PoseMaths::IsInvertible(transform), "a collapsed axis is invertible");
+
+	// Two parallel rows
+	transform.SetIdentity();
+	transform.SetRow(1, gef::Vector4(1.0f, 0.0f, 0.0f, 0.0f));
+	Check(!PoseMaths::IsInvertible(transform), "parallel rows are invertible");
+
+	// Rows just either side of the relative determinant limit, tilting the z axis towards the x axis
+	float limit_angle = asinf(POSE_MIN_RELATIVE_DETERMINANT);
+	transform.SetIdentity();
+	transform.SetRow(2, gef::Vector4(cosf(limit_angle * 0.5f), 0.0f, sinf(limit_angle * 0.5f), 0.0f));
+	Check(!PoseMaths::IsInvertible(transform), "rows inside the determinant limit are invertible");
+	transform.SetRow(2, gef::Vector4(cosf(limit_angle * 2.0f), 0.0f, sinf(limit_angle * 2.0f), 0.0f));
+	Check(PoseMaths::IsInvertible(transform), "rows outside the determinant limit aren't invertible");
+
+	// The limit doesn't depend on scale
+	for (int row = 0; row < 3; row++)
+	{
+
+		transform.SetRow(row, gef::Vector4(transform.GetRow(row).x() * 1.0e-3f, transform.GetRow(row).y() * 1.0e-3f, transform.GetRow(row).z() * 1.0e-3f, 0.0f));
+
+	}
+	Check(PoseMaths::IsInvertible(transform), "a scaled down transform outside the determinant limit isn't invertible");
+
+	// NaNs fail rather than slipping through the comparisons
+	transform.SetIdentity();
+	transform.set_m(0, 1, NAN);
+	Check(!PoseMaths::IsInvertible(transform), "a NaN transform is invertible");
+
+}
+
+static void TestNonFinite()
+{
+
+	gef::Matrix44 parent = RandomMarkerPose(0.03f, 0.1f);
+	gef::Matrix44 transform = RandomMarkerPose(0.03f, 0.1f);
+
+	// A NaN or infinity anywhere in either transform is rejected, and the local transform is left alone
+	for (int element = 0; element < 16; element++)
+	{
+
+		for (int special = 0; special < 3; special++)
+		{
+
+			float value = special == 0 ? NAN : (special == 1 ? INFINITY : -INFINITY);
+
+			gef::Matrix44 bad = transform;
+			bad.set_m(element / 4, element % 4, value);
+			Check(!PoseMaths::IsFinite(bad), "element %i set to %f is finite", element, value);
+
+			gef::Matrix44 local;
+			local.SetIdentity();
+			gef::Matrix44 untouched = local;
+			Check(!PoseMaths::GetLocalTransform(bad, parent, local) && IsSameMatrix(local, untouched), "a transform with element %i set to %f was localised", element, value);
+			Check(!PoseMaths::GetLocalTransform(transform, bad, local) && IsSameMatrix(local, untouched), "a parent with element %i set to %f was localised", element, value);
+
+		}
+
+	}
+
+}
+
+static void TestFuzz()
+{
+
+	int num_localised = 0;
+
+	for (int fuzz = 0; fuzz < NUM_FUZZ_CASES; fuzz++)
+	{
+
+		gef::Matrix44 parent = RandomMarkerPose(0.03f, 0.1f);
+		gef::Matrix44 transform = RandomMarkerPose(0.03f, 0.1f);
+
+		switch (fuzz % 4)
+		{
+
+		case 0:
+		{
+
+			// Special values scattered through either transform
+			gef::Matrix44& target = RandomBits() % 2 ? parent : transform;
+			int num_elements = 1 + RandomBits() % 4;
+			for (int element = 0; element < num_elements; element++)
+			{
+
+				int index = RandomBits() % 16;
+				target.set_m(index / 4, index % 4, RandomSpecial());
+
+			}
+			break;
+
+		}
+		case 1:
+		{
+
+			// A parent whose rows are collapsing towards each other, as when the marker is seen edge on
+			float squash = RandomLogRange(1.0e-8f, 1.0e-1f);
+			gef::Vector4 x_axis = parent.GetRow(0);
+			gef::Vector4 y_axis = parent.GetRow(1);
+			parent.SetRow(1, gef::Vector4(x_axis.x() + (y_axis.x() - x_axis.x()) * squash, x_axis.y() + (y_axis.y() - x_axis.y()) * squash,
+				x_axis.z() + (y_axis.z() - x_axis.z()) * squash, 0.0f));
+			break;
+
+		}
+		case 2:
+		{
+
+			// A parent shrinking to nothing, as when tracking collapses
+			float shrink = RandomLogRange(1.0e-12f, 1.0f);
+			for (int row = 0; row < 3; row++)
+			{
+
+				gef::Vector4 axis = parent.GetRow(row);
+				parent.SetRow(row, gef::Vector4(axis.x() * shrink, axis.y() * shrink, axis.z() * shrink, 0.0f));
+
+			}
+			break;
+
+		}
+		default:
+		{
+
+			// Any bit pattern at all
+			for (int element = 0; element < 16; element++)
+			{
+
+				unsigned int bits = RandomBits();
+				float value;
+				memcpy(&value, &bits, sizeof(value));
+				parent.set_m(element / 4, element % 4, value);
+
+			}
+			break;
+
+		}
+
+		}
+
+		// Whatever goes in, either it's rejected and the output is left alone, or what comes out is finite
+		gef::Matrix44 local;
+		local.SetIdentity();
+		gef::Matrix44 untouched = local;
+		if (PoseMaths::GetLocalTransform(transform, parent, local))
+		{
+
+			num_localised++;
+			Check(PoseMaths::IsFinite(local), "fuzz case %i localised to a non-finite transform", fuzz);
+			Check(PoseMaths::IsFinite(parent) && PoseMaths::IsInvertible(parent), "fuzz case %i was localised against a bad parent", fuzz);
+
+		}
+		else
+		{
+
+			Check(IsSameMatrix(local, untouched), "fuzz case %i changed the local transform when it failed", fuzz);
+
+		}
+
+	}
+
+	printf("Fuzz: %i of %i cases localised, the rest rejected\n", num_localised, NUM_FUZZ_CASES);
+
+}
+
+// The fixed tolerance rule from Level::CheckTransforms, in double precision
+static bool ReferenceWithinTolerance(const gef::Matrix44& transform, const gef::Matrix44& reference, double tolerance, double translation_tolerance)
+{
+
+	for (int row = 0; row < 4; row++)
+	{
+
+		for (int column = 0; column < 3; column++)
+		{
+
+			double difference = fabs((double)PoseMaths::GetElement(transform, row, column) - (double)PoseMaths::GetElement(reference, row, column));
+			if (!(difference < (row == 3 ? translation_tolerance : tolerance)))
+			{
+
+				return false;
+
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+static void TestTolerance()
+{
+
+	const float tolerance = 0.05f;
+	const float translation_tolerance = tolerance * 4;
+
+	gef::Matrix44 reference = RandomMarkerPose(0.03f, 0.1f);
+	Check(PoseMaths::IsWithinTolerance(reference, reference, tolerance, translation_tolerance), "a transform isn't within tolerance of itself");
+
+	// Each element just inside and just outside its row's tolerance, and the last column not being compared at all
+	for (int row = 0; row < 4; row++)
+	{
+
+		float row_tolerance = row == 3 ? translation_tolerance : tolerance;
+
+		for (int column = 0; column < 4; column++)
+		{
+
+			gef::Matrix44 inside = reference;
+			inside.set_m(row, column, reference.m(row, column) + row_tolerance * 0.99f);
+			Check(PoseMaths::IsWithinTolerance(inside, reference, tolerance, translation_tolerance), "[%i][%i] inside the tolerance doesn't match", row, column);
+
+			gef::Matrix44 outside = reference;
+			outside.set_m(row, column, reference.m(row, column) - row_tolerance * 1.01f);
+			Check(PoseMaths::IsWithinTolerance(outside, reference, tolerance, translation_tolerance) == (column == 3),
+				"[%i][%i] outside the tolerance is treated wrongly", row, column);
+
+			gef::Matrix44 nan = reference;
+			nan.set_m(row, column, NAN);
+			Check(PoseMaths::IsWithinTolerance(nan, reference, tolerance, translation_tolerance) == (column == 3), "[%i][%i] NaN is treated wrongly", row, column);
+			Check(PoseMaths::IsWithinTolerance(reference, nan, tolerance, translation_tolerance) == (column == 3), "[%i][%i] NaN reference is treated wrongly", row, column);
+
+		}
+
+	}
+
+	// Random perturbations agree with the double precision rule, apart from differences within rounding of the boundary
+	int num_matched = 0;
+	int num_compared = 0;
+	for (int pose = 0; pose < NUM_RANDOM_POSES; pose++)
+	{
+
+		gef::Matrix44 transform = reference;
+		bool is_near_boundary = false;
+
+		for (int row = 0; row < 4; row++)
+		{
+
+			float row_tolerance = row == 3 ? translation_tolerance : tolerance;
+
+			for (int column = 0; column < 3; column++)
+			{
+
+				float value = reference.m(row, column) + RandomRange(-1.1f, 1.1f) * row_tolerance;
+				transform.set_m(row, column, value);
+
+				double difference = fabs((double)value - (double)reference.m(row, column));
+				is_near_boundary = is_near_boundary || fabs(difference - row_tolerance) <= 4.0 * Ulp(fabs(value) + row_tolerance);
+
+			}
+
+		}
+
+		if (is_near_boundary)
+		{
+
+			continue;
+
+		}
+
+		bool is_within = PoseMaths::IsWithinTolerance(transform, reference, tolerance, translation_tolerance);
+		num_compared++;
+		num_matched += is_within ? 1 : 0;
+		Check(is_within == ReferenceWithinTolerance(transform, reference, tolerance, translation_tolerance), "perturbation %i disagrees with the reference", pose);
+
+	}
+
+	Check(num_matched > 0 && num_matched < num_compared, "the perturbations didn't cover both sides of the tolerance");
+
+}
+
+// Keep the benchmarks' results live so the calls aren't optimised away
+static volatile float benchmark_sink = 0.0f;
+
+static void RunBenchmarks()
+{
+
+	const int num_poses = 64;
+	gef::Matrix44 parents[num_poses];
+	gef::Matrix44 transforms[num_poses];
+	for (int pose = 0; pose < num_poses; pose++)
+	{
+
+		parents[pose] = RandomMarkerPose(0.03f, 0.1f);
+		transforms[pose] = RandomMarkerPose(0.03f, 0.1f);
+
+	}
+
+	gef::Matrix44 local;
+	clock_t start = clock();
+	for (int call = 0; call < NUM_BENCHMARK_CALLS; call++)
+	{
+
+		PoseMaths::GetLocalTransform(transforms[call % num_poses], parents[call % num_poses], local);
+		benchmark_sink += local.m(3, 0);
+
+	}
+	double local_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	int num_within = 0;
+	start = clock();
+	for (int call = 0; call < NUM_BENCHMARK_CALLS; call++)
+	{
+
+		num_within += PoseMaths::IsWithinTolerance(transforms[call % num_poses], parents[(call + 1) % num_poses], 0.05f, 0.2f) ? 1 : 0;
+
+	}
+	double tolerance_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+	benchmark_sink += (float)num_within;
+
+	printf("Benchmark: GetLocalTransform %.1f ns/call, IsWithinTolerance %.1f ns/call\n",
+		local_time * 1.0e9 / NUM_BENCHMARK_CALLS, tolerance_time * 1.0e9 / NUM_BENCHMARK_CALLS);
+
+}
+
+int main(int argc, char** argv)
+{
+
+	TestLocalTransformAccuracy();
+	TestLocalTransformProperties();
+	TestInvertible();
+	TestNonFinite();
+	TestFuzz();
+	TestTolerance();
+
+	// The timings are only worth reading from an optimised build, so they're asked for explicitly
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+
+		RunBenchmarks();
+
+	}
+
+	printf("%i of %i checks failed\n", num_failures, num_checks);
+
+	return num_failures == 0 ? 0 : 1;
+
+}
\ No newline at end of file